@@ -44,6 +44,10 @@ android {
     kotlinOptions {
         jvmTarget = "1.8"
     }
+    androidResources {
+        // AAsset_getBuffer of a stored asset points into the mapped apk: ktx is parsed in place
+        noCompress += "ktx"
+    }
     externalNativeBuild {
         cmake {
             path = file("src/main/cpp/CMakeLists.txt")
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <chrono>
+
+#include <rapidjson/document.h>
+
+#include <accessor.h>
+#include <meshoptdecode.h>
+#include <misc.h>
+
+// https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#glb-file-format-specification
+static constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+static constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942; // "BIN\0"
+static constexpr size_t GLB_HEADER_SIZE = 12;
+static constexpr size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+static constexpr const char *EXT_MESHOPT_COMPRESSION = "EXT_meshopt_compression";
+
+static uint32_t readU32(std::span<const std::byte> bytes, size_t offset) {
+    uint32_t v;
+    memcpy(&v, bytes.data() + offset, sizeof(v));
+    return v;
+}
+
+std::span<const std::byte> findGlbBinaryChunk(std::span<const std::byte> glbBytes) {
+    if (glbBytes.size() < GLB_HEADER_SIZE || readU32(glbBytes, 0) != GLB_MAGIC) {
+        return {};
+    }
+    // header.length may be smaller than what we were handed (padding), never trust more
+    const size_t length = std::min<size_t>(readU32(glbBytes, 8), glbBytes.size());
+    size_t offset = GLB_HEADER_SIZE;
+    while (offset + GLB_CHUNK_HEADER_SIZE <= length) {
+        const size_t chunkLength = readU32(glbBytes, offset);
+        const uint32_t chunkType = readU32(glbBytes, offset + 4);
+        offset += GLB_CHUNK_HEADER_SIZE;
+        if (chunkLength > length - offset) {
+            return {};
+        }
+        if (chunkType == GLB_CHUNK_BIN) {
+            return glbBytes.subspan(offset, chunkLength);
+        }
+        // chunks are 4-byte aligned
+        offset += (chunkLength + 3) & ~size_t(3);
+    }
+    return {};
+}
+
+namespace {
+// one EXT_meshopt_compression bufferView extension
+struct CompressedBufferView {
+    size_t bufferView;
+    size_t buffer;
+    size_t byteOffset;
+    size_t byteLength;
+    size_t byteStride;
+    size_t count;
+    MeshoptMode mode;
+    MeshoptFilter filter;
+};
+
+size_t jsonSize(const rapidjson::Value &json, const char *name, const std::string &id,
+                bool required = true) {
+    const auto member = json.FindMember(name);
+    if (member == json.MemberEnd()) {
+        if (required) {
+            throw std::runtime_error("bufferView " + id + ": " + EXT_MESHOPT_COMPRESSION +
+                                     " lacks " + name);
+        }
+        return 0;
+    }
+    if (!member->value.IsUint64()) {
+        throw std::runtime_error("bufferView " + id + ": " + EXT_MESHOPT_COMPRESSION + "." +
+                                 name + " is not an unsigned integer");
+    }
+    return member->value.GetUint64();
+}
+
+CompressedBufferView parseCompressedBufferView(size_t index, const std::string &id,
+                                               const std::string &extension) {
+    rapidjson::Document json;
+    json.Parse(extension.c_str());
+    if (json.HasParseError() || !json.IsObject()) {
+        throw std::runtime_error("bufferView " + id + ": malformed " + EXT_MESHOPT_COMPRESSION);
+    }
+    CompressedBufferView view{};
+    view.bufferView = index;
+    view.buffer = jsonSize(json, "buffer", id);
+    view.byteOffset = jsonSize(json, "byteOffset", id, false);
+    view.byteLength = jsonSize(json, "byteLength", id);
+    view.byteStride = jsonSize(json, "byteStride", id);
+    view.count = jsonSize(json, "count", id);
+
+    const auto mode = json.FindMember("mode");
+    const std::string modeName = mode != json.MemberEnd() && mode->value.IsString()
+                                 ? mode->value.GetString() : "";
+    if (modeName == "ATTRIBUTES") {
+        view.mode = MESHOPT_MODE_ATTRIBUTES;
+    } else if (modeName == "TRIANGLES") {
+        view.mode = MESHOPT_MODE_TRIANGLES;
+    } else if (modeName == "INDICES") {
+        view.mode = MESHOPT_MODE_INDICES;
+    } else {
+        throw std::runtime_error("bufferView " + id + ": unknown meshopt mode " + modeName);
+    }
+    const auto filter = json.FindMember("filter");
+    const std::string filterName = filter != json.MemberEnd() && filter->value.IsString()
+                                   ? filter->value.GetString() : "NONE";
+    if (filterName == "NONE") {
+        view.filter = MESHOPT_FILTER_NONE;
+    } else if (filterName == "OCTAHEDRAL") {
+        view.filter = MESHOPT_FILTER_OCTAHEDRAL;
+    } else if (filterName == "QUATERNION") {
+        view.filter = MESHOPT_FILTER_QUATERNION;
+    } else if (filterName == "EXPONENTIAL") {
+        view.filter = MESHOPT_FILTER_EXPONENTIAL;
+    } else {
+        throw std::runtime_error("bufferView " + id + ": unknown meshopt filter " + filterName);
+    }
+    return view;
+}
+}
+
+void AccessorReader::decodeCompressedBufferViews(WorkerPool &workerPool) {
+    std::vector<CompressedBufferView> views;
+    for (size_t i = 0; i < _document.bufferViews.Size(); ++i) {
+        const auto &bufferView = _document.bufferViews[i];
+        const auto extension = bufferView.extensions.find(EXT_MESHOPT_COMPRESSION);
+        if (extension != bufferView.extensions.end()) {
+            views.push_back(parseCompressedBufferView(i, bufferView.id, extension->second));
+        }
+    }
+    if (views.empty()) {
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    _decodedBufferViews.resize(_document.bufferViews.Size());
+    // views are independent: one task each, biggest first so a large one does not finish last
+    std::sort(views.begin(), views.end(), [](const auto &a, const auto &b) {
+        return a.count * a.byteStride > b.count * b.byteStride;
+    });
+    workerPool.parallelFor(views.size(), [&](size_t v) {
+        const auto &view = views[v];
+        const auto &id = _document.bufferViews[view.bufferView].id;
+        if (view.buffer >= _document.buffers.Size()) {
+            throw std::runtime_error("bufferView " + id + ": meshopt buffer out of range");
+        }
+        // the compressed bytes form a buffer view of their own, under an id that is not in
+        // the document so the lookup does not land on the view being decoded
+        Microsoft::glTF::BufferView source;
+        source.id = id + "/" + EXT_MESHOPT_COMPRESSION;
+        source.bufferId = _document.buffers[view.buffer].id;
+        source.byteOffset = view.byteOffset;
+        source.byteLength = view.byteLength;
+        const auto compressed = readBufferView(source);
+
+        auto &decoded = _decodedBufferViews[view.bufferView];
+        decoded.resize(view.count * view.byteStride);
+        if (!decodeMeshoptBufferView(std::as_bytes(compressed.view), view.mode, view.filter,
+                                     view.count, view.byteStride, decoded.data())) {
+            throw std::runtime_error("bufferView " + id + ": malformed meshopt stream");
+        }
+    });
+
+    size_t compressedBytes = 0;
+    size_t decodedBytes = 0;
+    for (const auto &view: views) {
+        compressedBytes += view.byteLength;
+        decodedBytes += _decodedBufferViews[view.bufferView].size();
+    }
+    const auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("%s: %zu buffer views, %zu -> %zu bytes in %.2f ms (%.2f GB/s, %u threads)",
+         EXT_MESHOPT_COMPRESSION, views.size(), compressedBytes, decodedBytes,
+         elapsedUs / 1000.0, elapsedUs > 0 ? decodedBytes / (elapsedUs * 1000.0) : 0.0,
+         workerPool.concurrency());
+}
+
+std::span<const std::byte>
+AccessorReader::bufferViewBytes(const Microsoft::glTF::BufferView &bufferView) const {
+    if (!_decodedBufferViews.empty() && _document.bufferViews.Has(bufferView.id)) {
+        const auto &decoded = _decodedBufferViews[_document.bufferViews.GetIndex(bufferView.id)];
+        if (!decoded.empty()) {
+            return decoded;
+        }
+    }
+    // glb: only the first buffer without uri refers to the BIN chunk
+    if (_binChunk.empty() || _document.buffers.GetIndex(bufferView.bufferId) != 0 ||
+        !_document.buffers.Get(bufferView.bufferId).uri.empty()) {
+        return {};
+    }
+    if (bufferView.byteOffset + bufferView.byteLength > _binChunk.size()) {
+        throw std::runtime_error("bufferView " + bufferView.id + " overruns the BIN chunk");
+    }
+    return _binChunk.subspan(bufferView.byteOffset, bufferView.byteLength);
+}
+
+AccessorData<uint8_t>
+AccessorReader::readBufferView(const Microsoft::glTF::BufferView &bufferView) const {
+    AccessorData<uint8_t> res;
+    const auto bytes = bufferViewBytes(bufferView);
+    if (!bytes.empty()) {
+        res.view = std::span(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+        return res;
+    }
+    std::lock_guard<std::mutex> lock(_resourceReaderMutex);
+    res.owned = _resourceReader.ReadBinaryData<uint8_t>(_document, bufferView);
+    res.view = res.owned;
+    return res;
+}
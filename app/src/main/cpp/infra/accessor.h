@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <GLTFSDK/GLTF.h>
+#include <GLTFSDK/Document.h>
+#include <GLTFSDK/GLTFResourceReader.h>
+#include <workerpool.h>
+
+// locates the BIN chunk of a glb container
+// returns an empty span if the container has no BIN chunk
+std::span<const std::byte> findGlbBinaryChunk(std::span<const std::byte> glbBytes);
+
+// typed accessor data
+// view points either straight into the glb BIN chunk (tightly packed accessors)
+// or into owned, when the data had to be de-strided/converted
+template<typename T>
+struct AccessorData {
+    std::span<const T> view;
+    std::vector<T> owned;
+
+    AccessorData() = default;
+
+    AccessorData(const AccessorData &) = delete;
+
+    AccessorData &operator=(const AccessorData &) = delete;
+
+    // std::vector move keeps its heap block, so view stays valid
+    AccessorData(AccessorData &&) noexcept = default;
+
+    AccessorData &operator=(AccessorData &&) noexcept = default;
+
+    inline bool empty() const {
+        return view.empty();
+    }
+
+    inline size_t size() const {
+        return view.size();
+    }
+
+    inline const T &operator[](size_t i) const {
+        return view[i];
+    }
+};
+
+// reads accessors and buffer views out of the glb BIN chunk without intermediate copies
+// sparse substitutions are applied in place on a copy of the dense data
+// EXT_meshopt_compression buffer views are served from their decoded copy
+// anything that does not live in the BIN chunk (external uri) goes through resourceReader
+// safe to share between threads
+class AccessorReader {
+public:
+    AccessorReader(const Microsoft::glTF::Document &document,
+                   const Microsoft::glTF::GLTFResourceReader &resourceReader,
+                   std::span<const std::byte> binChunk)
+            : _document(document), _resourceReader(resourceReader), _binChunk(binChunk) {}
+
+    // EXT_meshopt_compression: decodes every compressed buffer view up front, one task per
+    // view; call before the reader is shared, reads are only thread safe afterwards
+    void decodeCompressedBufferViews(WorkerPool &workerPool);
+
+    // empty span if the buffer view does not live in the BIN chunk (and was not decoded)
+    std::span<const std::byte> bufferViewBytes(const Microsoft::glTF::BufferView &bufferView) const;
+
+    // raw bytes of a buffer view (e.g. an encoded image)
+    AccessorData<uint8_t> readBufferView(const Microsoft::glTF::BufferView &bufferView) const;
+
+    // T must match the accessor's component size, data is returned as a flat component array
+    // sparse accessors come back dense, with their substitutions applied to a private copy
+    template<typename T>
+    AccessorData<T> read(const Microsoft::glTF::Accessor &accessor) const {
+        AccessorData<T> res = readDense<T>(accessor);
+        if (accessor.sparse.count == 0U || applySparse(accessor, res)) {
+            return res;
+        }
+        // sparse data outside the BIN chunk: the resource reader resolves it
+        std::lock_guard<std::mutex> lock(_resourceReaderMutex);
+        res.owned = _resourceReader.ReadBinaryData<T>(_document, accessor);
+        res.view = res.owned;
+        return res;
+    }
+
+private:
+    template<typename T>
+    AccessorData<T> readDense(const Microsoft::glTF::Accessor &accessor) const {
+        AccessorData<T> res;
+        const size_t componentCount = Microsoft::glTF::Accessor::GetTypeCount(accessor.type);
+        const size_t componentSize = Microsoft::glTF::Accessor::GetComponentTypeSize(
+                accessor.componentType);
+        const size_t elementSize = componentCount * componentSize;
+
+        // a sparse accessor without a buffer view starts out as zeros
+        if (accessor.sparse.count > 0U && accessor.bufferViewId.empty()) {
+            res.owned.assign(accessor.count * componentCount, T{});
+            res.view = res.owned;
+            return res;
+        }
+        std::span<const std::byte> bytes;
+        if (sizeof(T) == componentSize && _document.bufferViews.Has(accessor.bufferViewId)) {
+            bytes = bufferViewBytes(_document.bufferViews.Get(accessor.bufferViewId));
+        }
+        if (bytes.empty()) {
+            // the resource reader seeks a single shared stream
+            std::lock_guard<std::mutex> lock(_resourceReaderMutex);
+            res.owned = _resourceReader.ReadBinaryData<T>(_document, accessor);
+            res.view = res.owned;
+            return res;
+        }
+
+        const auto &bufferView = _document.bufferViews.Get(accessor.bufferViewId);
+        const size_t stride = bufferView.byteStride.HasValue() && bufferView.byteStride.Get() != 0
+                              ? bufferView.byteStride.Get() : elementSize;
+        const size_t byteLength = accessor.count == 0 ? 0 :
+                                  (accessor.count - 1) * stride + elementSize;
+        if (accessor.byteOffset + byteLength > bytes.size()) {
+            throw std::runtime_error("accessor " + accessor.id + " overruns its buffer view");
+        }
+        const std::byte *src = bytes.data() + accessor.byteOffset;
+
+        if (stride == elementSize && reinterpret_cast<uintptr_t>(src) % alignof(T) == 0) {
+            // tightly packed: hand out the mapped bytes directly
+            res.view = std::span<const T>(reinterpret_cast<const T *>(src),
+                                          accessor.count * componentCount);
+            return res;
+        }
+        // interleaved (or misaligned) data: gather the elements
+        res.owned.resize(accessor.count * componentCount);
+        auto *dst = reinterpret_cast<std::byte *>(res.owned.data());
+        for (size_t i = 0; i < accessor.count; ++i) {
+            memcpy(dst + i * elementSize, src + i * stride, elementSize);
+        }
+        res.view = res.owned;
+        return res;
+    }
+
+    // overwrites the substituted elements in place, false when the sparse indices/values are
+    // not in the BIN chunk (res is left untouched then)
+    template<typename T>
+    bool applySparse(const Microsoft::glTF::Accessor &accessor, AccessorData<T> &res) const {
+        const auto &sparse = accessor.sparse;
+        const size_t componentCount = Microsoft::glTF::Accessor::GetTypeCount(accessor.type);
+        const size_t elementSize = componentCount * sizeof(T);
+        const size_t indexSize = Microsoft::glTF::Accessor::GetComponentTypeSize(
+                sparse.indicesComponentType);
+        if (sizeof(T) != Microsoft::glTF::Accessor::GetComponentTypeSize(accessor.componentType) ||
+            !_document.bufferViews.Has(sparse.indicesBufferViewId) ||
+            !_document.bufferViews.Has(sparse.valuesBufferViewId)) {
+            return false;
+        }
+        const auto indexBytes = bufferViewBytes(
+                _document.bufferViews.Get(sparse.indicesBufferViewId));
+        const auto valueBytes = bufferViewBytes(
+                _document.bufferViews.Get(sparse.valuesBufferViewId));
+        if (indexBytes.empty() || valueBytes.empty()) {
+            return false;
+        }
+        if (sparse.indicesByteOffset + sparse.count * indexSize > indexBytes.size() ||
+            sparse.valuesByteOffset + sparse.count * elementSize > valueBytes.size() ||
+            res.size() != accessor.count * componentCount) {
+            throw std::runtime_error("sparse accessor " + accessor.id + " overruns its data");
+        }
+        // the dense view may point into the read-only mapping
+        if (res.owned.empty()) {
+            res.owned.assign(res.view.begin(), res.view.end());
+        }
+        const std::byte *indices = indexBytes.data() + sparse.indicesByteOffset;
+        const std::byte *values = valueBytes.data() + sparse.valuesByteOffset;
+        for (size_t i = 0; i < sparse.count; ++i) {
+            uint32_t index = 0;
+            if (indexSize == sizeof(uint8_t)) {
+                index = static_cast<uint8_t>(indices[i]);
+            } else if (indexSize == sizeof(uint16_t)) {
+                uint16_t index16;
+                memcpy(&index16, indices + i * indexSize, sizeof(index16));
+                index = index16;
+            } else {
+                memcpy(&index, indices + i * indexSize, sizeof(index));
+            }
+            if (index >= accessor.count) {
+                throw std::runtime_error("sparse accessor " + accessor.id + " index out of range");
+            }
+            memcpy(res.owned.data() + size_t(index) * componentCount, values + i * elementSize,
+                   elementSize);
+        }
+        res.view = res.owned;
+        return true;
+    }
+
+    const Microsoft::glTF::Document &_document;
+    const Microsoft::glTF::GLTFResourceReader &_resourceReader;
+    std::span<const std::byte> _binChunk;
+    mutable std::mutex _resourceReaderMutex;
+    // by buffer view index, empty: not compressed
+    std::vector<std::vector<std::byte>> _decodedBufferViews;
+};
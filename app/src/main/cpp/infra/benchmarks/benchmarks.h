@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// one loaderbench case: argv holds the case's own arguments, returns the process exit code
+using BenchmarkFn = int (*)(int argc, char **argv);
+
+// loaderbench glb <file.glb>
+int benchGlbRead(int argc, char **argv);
+
+// loaderbench textures <file.glb> [threads]
+int benchTextures(int argc, char **argv);
+
+// loaderbench vertices
+int benchVertexKernels(int argc, char **argv);
+
+// loaderbench meshlets
+int benchMeshlets(int argc, char **argv);
+
+// loaderbench meshopt [threads]
+int benchMeshoptDecode(int argc, char **argv);
+
+// loaderbench etc [size]
+int benchEtcUnpack(int argc, char **argv);
+
+// wall clock of the fastest of runs calls, in ms
+inline double bestOfMs(int runs, const std::function<void()> &fn) {
+    double best = 0.0;
+    for (int run = 0; run < runs; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+        best = run == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+// 1 (the serial baseline) and threads, unless that is 1 as well
+inline std::vector<uint32_t> benchmarkConcurrencies(uint32_t threads) {
+    return threads > 1 ? std::vector<uint32_t>{1, threads} : std::vector<uint32_t>{1};
+}
+
+// high-water mark of the calling process, in KB
+inline long peakResidentSetSizeKB() {
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// runs fn in a forked child so its peak RSS is not inflated by whatever ran before it
+// fn prints its own results, returns false when the child failed
+inline bool runIsolated(const std::function<bool()> &fn) {
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        const bool ok = fn();
+        fflush(stdout);
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+           WEXITSTATUS(status) == 0;
+}
@@ -0,0 +1,144 @@
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <ktxetc.h>
+#include <ktxint.h>
+#include <gl_format.h>
+
+#include "benchmarks.h"
+
+// the cpu fallback loadTextures takes without textureCompressionETC2: _ktxUnpackETC alone and
+// unpackEtcTexture (decode + widening into an rgba8 ktxTexture) against a serial loop over
+// etcdec.cxx's reference block decoders, on a fixed synthetic texture, outputs are checked
+
+// etcdec.cxx, c++ linkage
+extern void decompressBlockETC2c(unsigned int block_part1, unsigned int block_part2,
+                                 uint8_t *img, int width, int height, int startx, int starty,
+                                 int channels);
+extern void decompressBlockAlphaC(uint8_t *data, uint8_t *img, int width, int height, int ix,
+                                  int iy, int channels);
+extern void setupAlphaTable();
+
+static constexpr uint32_t DEFAULT_SIZE = 2048;
+static constexpr int RUNS = 3;
+
+// mostly differential blocks with in-range deltas like an encoder emits, 1 in 8 random bits
+// which lands in the individual, T, H and planar modes as well
+static void fillColorBlock(std::mt19937 &rng, uint8_t *block) {
+    for (int i = 0; i < 8; ++i) {
+        block[i] = static_cast<uint8_t>(rng());
+    }
+    if (rng() % 8 == 0) {
+        return;
+    }
+    for (int c = 0; c < 3; ++c) {
+        const uint32_t color1 = 4 + rng() % 24;
+        block[c] = static_cast<uint8_t>(color1 << 3 | (rng() & 0x7));
+    }
+    block[3] |= 0x2;
+}
+
+static uint32_t readBigEndian(const uint8_t *bytes) {
+    return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 |
+           bytes[3];
+}
+
+// serial etcdec.cxx decode into tight rgba8, opaque when the format has no alpha
+static void referenceDecode(const uint8_t *blocks, uint32_t size, bool alpha,
+                            std::vector<uint8_t> &rgba) {
+    rgba.assign(size_t(size) * size * 4, 255);
+    const uint8_t *src = blocks;
+    for (uint32_t by = 0; by < size / 4; ++by) {
+        for (uint32_t bx = 0; bx < size / 4; ++bx) {
+            if (alpha) {
+                decompressBlockAlphaC(const_cast<uint8_t *>(src), rgba.data() + 3, size, size,
+                                      4 * bx, 4 * by, 4);
+                src += 8;
+            }
+            decompressBlockETC2c(readBigEndian(src), readBigEndian(src + 4), rgba.data(), size,
+                                 size, 4 * bx, 4 * by, 4);
+            src += 8;
+        }
+    }
+}
+
+static bool benchFormat(const char *label, GLenum glInternalformat, uint32_t size) {
+    const bool alpha = glInternalformat == GL_COMPRESSED_RGBA8_ETC2_EAC;
+    ktxTextureCreateInfo createInfo{
+            .glInternalformat = glInternalformat,
+            .baseWidth = size,
+            .baseHeight = size,
+            .baseDepth = 1,
+            .numDimensions = 2,
+            .numLevels = 1,
+            .numLayers = 1,
+            .numFaces = 1,
+    };
+    ktxTexture *etcTexture = nullptr;
+    if (ktxTexture_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &etcTexture) !=
+        KTX_SUCCESS) {
+        fprintf(stderr, "ktxTexture_Create failed\n");
+        return false;
+    }
+    std::mt19937 rng(25);
+    for (size_t offset = 0; offset < etcTexture->dataSize; offset += 8) {
+        if (alpha) {
+            // eac alpha: any bits are a valid block
+            for (int i = 0; i < 8; ++i) {
+                etcTexture->pData[offset + i] = static_cast<uint8_t>(rng());
+            }
+            offset += 8;
+        }
+        fillColorBlock(rng, etcTexture->pData + offset);
+    }
+
+    setupAlphaTable();
+    std::vector<uint8_t> reference;
+    const double referenceMs = bestOfMs(RUNS, [&] {
+        referenceDecode(etcTexture->pData, size, alpha, reference);
+    });
+    const double unpackMs = bestOfMs(RUNS, [&] {
+        GLubyte *decoded = nullptr;
+        GLenum format, internalFormat, type;
+        _ktxUnpackETC(etcTexture->pData, glInternalformat, size, size, &decoded, &format,
+                      &internalFormat, &type, _KTX_ALL_R16_FORMATS, KTX_TRUE);
+        free(decoded);
+    });
+    ktxTexture *unpacked = nullptr;
+    ktxResult result = KTX_SUCCESS;
+    const double textureMs = bestOfMs(RUNS, [&] {
+        if (unpacked) {
+            ktxTexture_Destroy(unpacked);
+        }
+        result = unpackEtcTexture(etcTexture, &unpacked);
+    });
+
+    const double pixels = double(size) * size;
+    printf("%-16s reference %8.2f ms %7.1f Mpx/s | _ktxUnpackETC %8.2f ms %7.1f Mpx/s (%.2fx)"
+           " | unpackEtcTexture %8.2f ms\n", label, referenceMs, pixels / referenceMs / 1e3,
+           unpackMs, pixels / unpackMs / 1e3, referenceMs / unpackMs, textureMs);
+
+    const bool match = result == KTX_SUCCESS && unpacked->dataSize == reference.size() &&
+                       memcmp(unpacked->pData, reference.data(), reference.size()) == 0;
+    if (unpacked) {
+        ktxTexture_Destroy(unpacked);
+    }
+    ktxTexture_Destroy(etcTexture);
+    if (!match) {
+        fprintf(stderr, "%s: unpackEtcTexture output differs from the reference decode\n",
+                label);
+    }
+    return match;
+}
+
+int benchEtcUnpack(int argc, char **argv) {
+    const uint32_t size = argc > 0 ? std::max(4, atoi(argv[0])) & ~3u : DEFAULT_SIZE;
+    printf("etc unpack: %ux%u, %u hardware threads, best of %d\n", size, size,
+           std::max(1u, std::thread::hardware_concurrency()), RUNS);
+    const bool rgb = benchFormat("RGB8_ETC2", GL_COMPRESSED_RGB8_ETC2, size);
+    const bool rgba = benchFormat("RGBA8_ETC2_EAC", GL_COMPRESSED_RGBA8_ETC2_EAC, size);
+    return rgb && rgba ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+#include <fstream>
+#include <sstream>
+
+#include <GLTFSDK/Deserialize.h>
+#include <GLTFSDK/GLBResourceReader.h>
+
+#include <glb.h>
+#include <mappedfile.h>
+#include <spanstream.h>
+
+#include "benchmarks.h"
+
+// glb ingestion, each variant in its own process:
+//  stringstream: the pre-span path, file copied into a vector (the AAsset copy) and every byte
+//                pushed through a std::stringstream that GLBResourceReader reads from
+//  span:         MappedFile + SpanStreamReader, what GltfBinaryIOReader::read does today
+//  read:         the whole GltfBinaryIOReader::read (accessors, meshes, textures) for scale
+// the first two stop after the manifest plus one read of every buffer view
+
+namespace {
+
+class StringStreamReader : public Microsoft::glTF::IStreamReader {
+public:
+    explicit StringStreamReader(std::shared_ptr<std::stringstream> stream)
+            : _stream(std::move(stream)) {}
+
+    std::shared_ptr<std::istream> GetInputStream(const std::string &) const override {
+        return _stream;
+    }
+
+private:
+    std::shared_ptr<std::stringstream> _stream;
+};
+
+}
+
+// manifest + every buffer view through the resource reader, returns the bytes read
+static size_t ingest(std::shared_ptr<Microsoft::glTF::IStreamReader> streamReader) {
+    auto glbStream = streamReader->GetInputStream("");
+    Microsoft::glTF::GLBResourceReader resourceReader(std::move(streamReader),
+                                                      std::move(glbStream));
+    const auto document = Microsoft::glTF::Deserialize(resourceReader.GetJson());
+    size_t bytes = 0;
+    for (const auto &bufferView: document.bufferViews.Elements()) {
+        // EXT_meshopt_compression fallback buffers have no data behind them
+        try {
+            bytes += resourceReader.ReadBinaryData<uint8_t>(document, bufferView).size();
+        } catch (const Microsoft::glTF::GLTFException &) {
+        }
+    }
+    return bytes;
+}
+
+static void report(const char *variant, double ms, size_t bytes) {
+    printf("%-13s %9.2f ms %10ld KB peak RSS", variant, ms, peakResidentSetSizeKB());
+    if (bytes > 0) {
+        printf("  (%zu buffer view bytes)", bytes);
+    }
+    printf("\n");
+}
+
+int benchGlbRead(int argc, char **argv) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: loaderbench glb <file.glb>\n");
+        return 2;
+    }
+    const std::string path = argv[0];
+
+    bool ok = runIsolated([&] {
+        size_t bytes = 0;
+        const double ms = bestOfMs(1, [&] {
+            std::ifstream file(path, std::ios::binary);
+            std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+                                     std::istreambuf_iterator<char>());
+            auto sstream = std::make_shared<std::stringstream>();
+            for (const char c: buffer) {
+                *sstream << c;
+            }
+            bytes = ingest(std::make_shared<StringStreamReader>(std::move(sstream)));
+        });
+        report("stringstream", ms, bytes);
+        return true;
+    });
+    ok = ok && runIsolated([&] {
+        size_t bytes = 0;
+        const double ms = bestOfMs(1, [&] {
+            MappedFile file(path);
+            bytes = ingest(std::make_shared<SpanStreamReader>(file.bytes()));
+        });
+        report("span", ms, bytes);
+        return true;
+    });
+    ok = ok && runIsolated([&] {
+        GltfBinaryIOReaderOptions options;
+        options.meshDecodeConcurrency = WorkerPool::hardwareConcurrency();
+        options.textureDecodeConcurrency = WorkerPool::hardwareConcurrency();
+        const double ms = bestOfMs(1, [&] {
+            GltfBinaryIOReader(options).read(path);
+        });
+        report("read", ms, 0);
+        return true;
+    });
+    return ok ? 0 : 1;
+}
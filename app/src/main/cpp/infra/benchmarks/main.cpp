@@ -0,0 +1,44 @@
+#include <cstring>
+
+#include "benchmarks.h"
+
+struct BenchmarkCase {
+    const char *name;
+    const char *usage;
+    BenchmarkFn run;
+};
+
+static constexpr BenchmarkCase BENCHMARKS[] = {
+        {"glb", "glb <file.glb>: glb ingestion time and peak RSS, stringstream copy vs span",
+         benchGlbRead},
+        {"textures", "textures <file.glb> [threads]: texture decode, 1 thread vs N",
+         benchTextures},
+        {"vertices", "vertices: index widening and vertex interleave, kernels vs scalar loops",
+         benchVertexKernels},
+        {"meshlets", "meshlets: meshlet build throughput and fill on a synthetic grid",
+         benchMeshlets},
+        {"meshopt", "meshopt [threads]: EXT_meshopt_compression decode GB/s, 1 thread vs N",
+         benchMeshoptDecode},
+        {"etc", "etc [size]: software ETC2 decode Mpx/s, reference block loop vs _ktxUnpackETC",
+         benchEtcUnpack},
+};
+
+static int usage() {
+    fprintf(stderr, "usage: loaderbench <case> [args]\n");
+    for (const auto &benchmark: BENCHMARKS) {
+        fprintf(stderr, "  %s\n", benchmark.usage);
+    }
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        return usage();
+    }
+    for (const auto &benchmark: BENCHMARKS) {
+        if (strcmp(argv[1], benchmark.name) == 0) {
+            return benchmark.run(argc - 2, argv + 2);
+        }
+    }
+    return usage();
+}
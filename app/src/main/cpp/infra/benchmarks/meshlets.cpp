@@ -0,0 +1,70 @@
+#include <cmath>
+#include <vector>
+
+#include <meshlets.h>
+#include <meshoptimization.h>
+
+#include "benchmarks.h"
+
+// buildMeshlets on a fixed synthetic mesh: a GRID_SIZE^2 quad heightfield (curved, so the
+// normal cones vary), once in row-major triangle order and once after optimizeVertexCache,
+// which is the order the loader builds from
+
+static constexpr uint32_t GRID_SIZE = 512;
+static constexpr int RUNS = 5;
+
+static void buildGrid(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices) {
+    vertices.clear();
+    indices.clear();
+    for (uint32_t y = 0; y <= GRID_SIZE; ++y) {
+        for (uint32_t x = 0; x <= GRID_SIZE; ++x) {
+            Vertex vertex{};
+            vertex.vx = float(x);
+            vertex.vy = 8.0f * std::sin(float(x) * 0.05f) * std::cos(float(y) * 0.03f);
+            vertex.vz = float(y);
+            vertex.ux = float(x) / GRID_SIZE;
+            vertex.uy = float(y) / GRID_SIZE;
+            vertices.push_back(vertex);
+        }
+    }
+    const uint32_t row = GRID_SIZE + 1;
+    for (uint32_t y = 0; y < GRID_SIZE; ++y) {
+        for (uint32_t x = 0; x < GRID_SIZE; ++x) {
+            const uint32_t i = y * row + x;
+            indices.insert(indices.end(), {i, i + row, i + 1, i + 1, i + row, i + row + 1});
+        }
+    }
+}
+
+static void run(const char *order, std::span<const uint32_t> indices,
+                std::span<const Vertex> vertices) {
+    MeshletBuffers built;
+    const double ms = bestOfMs(RUNS, [&] {
+        built = buildMeshlets(indices, vertices);
+    });
+    const auto fill = meshletFill(built.meshlets);
+    size_t cullable = 0;
+    for (const auto &meshlet: built.meshlets) {
+        cullable += meshlet.coneCutoff < 1.0f;
+    }
+    const size_t triangles = indices.size() / 3;
+    printf("%-12s %8.2f ms %7.1f Mtriangles/s  %zu meshlets, fill %.1f%% vertices "
+           "%.1f%% triangles, %zu usable cones\n",
+           order, ms, triangles / ms / 1e3, fill.meshlets,
+           100.0 * double(fill.vertices) / double(fill.meshlets * MESHLET_MAX_VERTICES),
+           100.0 * double(fill.triangles) / double(fill.meshlets * MESHLET_MAX_TRIANGLES),
+           cullable);
+}
+
+int benchMeshlets(int, char **) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    buildGrid(vertices, indices);
+    printf("%u x %u grid: %zu vertices, %zu triangles, best of %d\n", GRID_SIZE, GRID_SIZE,
+           vertices.size(), indices.size() / 3, RUNS);
+
+    run("row-major", indices, vertices);
+    optimizeVertexCache(indices, vertices.size(), MESH_OPT_CACHE_SIZE);
+    run("vertex cache", indices, vertices);
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <meshoptdecode.h>
+#include <workerpool.h>
+
+#include "benchmarks.h"
+
+// EXT_meshopt_compression decoding over a fixed compressed buffer: the same views are encoded
+// from a seeded generator on every run, then decoded serially and on N threads the way
+// AccessorReader::decodeCompressedBufferViews does it (one task per view, largest first)
+// the encoders below are the minimal reverse of meshoptdecode.cpp, not meshoptimizer's
+
+static constexpr size_t VIEW_VERTEX_COUNT = 1 << 16;
+static constexpr int RUNS = 5;
+
+namespace {
+
+struct CompressedView {
+    std::vector<std::byte> compressed;
+    std::vector<std::byte> expected;
+    MeshoptMode mode;
+    MeshoptFilter filter;
+    size_t count;
+    size_t stride;
+};
+
+}
+
+static uint8_t zigzag8(uint8_t delta) {
+    return static_cast<uint8_t>((delta << 1) ^ static_cast<uint8_t>(int8_t(delta) >> 7));
+}
+
+// one 16-byte group at the cheapest of the 4 widths, returns its header bits
+static int encodeBytesGroup(const uint8_t *group, std::vector<uint8_t> &out) {
+    size_t escapes2 = 0;
+    size_t escapes4 = 0;
+    bool zero = true;
+    for (size_t i = 0; i < 16; ++i) {
+        zero = zero && group[i] == 0;
+        escapes2 += group[i] >= 3;
+        escapes4 += group[i] >= 15;
+    }
+    if (zero) {
+        return 0;
+    }
+    const size_t size2 = 4 + escapes2;
+    const size_t size4 = 8 + escapes4;
+    if (size2 <= size4 && size2 < 16) {
+        for (size_t i = 0; i < 16; i += 4) {
+            uint8_t packed = 0;
+            for (size_t j = 0; j < 4; ++j) {
+                packed |= std::min<uint8_t>(group[i + j], 3) << (6 - 2 * j);
+            }
+            out.push_back(packed);
+        }
+        for (size_t i = 0; i < 16; ++i) {
+            if (group[i] >= 3) {
+                out.push_back(group[i]);
+            }
+        }
+        return 1;
+    }
+    if (size4 < 16) {
+        for (size_t i = 0; i < 16; i += 2) {
+            out.push_back(static_cast<uint8_t>(std::min<uint8_t>(group[i], 15) << 4 |
+                                               std::min<uint8_t>(group[i + 1], 15)));
+        }
+        for (size_t i = 0; i < 16; ++i) {
+            if (group[i] >= 15) {
+                out.push_back(group[i]);
+            }
+        }
+        return 2;
+    }
+    out.insert(out.end(), group, group + 16);
+    return 3;
+}
+
+static std::vector<std::byte> encodeVertexBuffer(const std::byte *vertices, size_t count,
+                                                 size_t stride) {
+    const auto *src = reinterpret_cast<const uint8_t *>(vertices);
+    std::vector<uint8_t> out{0xa0};
+    const size_t blockSize = std::min<size_t>((8192 / stride) & ~size_t(15), 256);
+    std::vector<uint8_t> last(src, src + stride);
+    uint8_t deltas[256];
+    for (size_t offset = 0; offset < count; offset += blockSize) {
+        const size_t size = std::min(blockSize, count - offset);
+        const size_t alignedSize = (size + 15) & ~size_t(15);
+        for (size_t k = 0; k < stride; ++k) {
+            memset(deltas, 0, sizeof(deltas));
+            for (size_t i = 0; i < size; ++i) {
+                const uint8_t value = src[(offset + i) * stride + k];
+                deltas[i] = zigzag8(static_cast<uint8_t>(value - last[k]));
+                last[k] = value;
+            }
+            const size_t header = out.size();
+            out.resize(header + (alignedSize / 16 + 3) / 4, 0);
+            for (size_t group = 0; group < alignedSize / 16; ++group) {
+                const int bits = encodeBytesGroup(deltas + group * 16, out);
+                out[header + group / 4] |= static_cast<uint8_t>(bits << ((group % 4) * 2));
+            }
+        }
+    }
+    // tail: padded to 32 bytes, ends with the first vertex
+    out.resize(out.size() + std::max<size_t>(stride, 32) - stride, 0);
+    out.insert(out.end(), src, src + stride);
+    const auto *begin = reinterpret_cast<const std::byte *>(out.data());
+    return {begin, begin + out.size()};
+}
+
+// v1 sequence codec on a single baseline, u32 indices
+static std::vector<std::byte> encodeIndexSequence(const uint32_t *indices, size_t count) {
+    std::vector<uint8_t> out{0xd1};
+    uint32_t last = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t delta = indices[i] - last;
+        last = indices[i];
+        uint32_t v = ((delta << 1) ^ (0U - (delta >> 31))) << 1;
+        while (v >= 128) {
+            out.push_back(static_cast<uint8_t>((v & 127) | 128));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+    out.resize(out.size() + 4, 0);
+    const auto *begin = reinterpret_cast<const std::byte *>(out.data());
+    return {begin, begin + out.size()};
+}
+
+// 16 positions views (snorm16x4 on a noisy walk), 16 octahedral normal views, 8 index views
+static std::vector<CompressedView> buildViews() {
+    std::mt19937 rng(16);
+    std::vector<CompressedView> views;
+    for (int v = 0; v < 16; ++v) {
+        std::vector<int16_t> positions(4 * VIEW_VERTEX_COUNT);
+        int16_t p[3] = {0, 0, 0};
+        for (size_t i = 0; i < VIEW_VERTEX_COUNT; ++i) {
+            for (size_t c = 0; c < 3; ++c) {
+                p[c] = static_cast<int16_t>(p[c] + int(rng() % 97) - 48);
+                positions[4 * i + c] = p[c];
+            }
+            positions[4 * i + 3] = 1;
+        }
+        CompressedView view{{}, {}, MESHOPT_MODE_ATTRIBUTES, MESHOPT_FILTER_NONE,
+                            VIEW_VERTEX_COUNT, 8};
+        const auto *bytes = reinterpret_cast<const std::byte *>(positions.data());
+        view.expected.assign(bytes, bytes + positions.size() * sizeof(int16_t));
+        view.compressed = encodeVertexBuffer(view.expected.data(), view.count, view.stride);
+        views.push_back(std::move(view));
+    }
+    for (int v = 0; v < 16; ++v) {
+        std::vector<int8_t> normals(4 * VIEW_VERTEX_COUNT);
+        for (size_t i = 0; i < VIEW_VERTEX_COUNT; ++i) {
+            normals[4 * i] = static_cast<int8_t>(int(i / 64 % 200) - 100 + int(rng() % 5));
+            normals[4 * i + 1] = static_cast<int8_t>(int(i % 200) - 100 + int(rng() % 5));
+            normals[4 * i + 2] = 127;
+            normals[4 * i + 3] = 0;
+        }
+        CompressedView view{{}, {}, MESHOPT_MODE_ATTRIBUTES, MESHOPT_FILTER_OCTAHEDRAL,
+                            VIEW_VERTEX_COUNT, 4};
+        const auto *bytes = reinterpret_cast<const std::byte *>(normals.data());
+        view.expected.assign(bytes, bytes + normals.size());
+        view.compressed = encodeVertexBuffer(view.expected.data(), view.count, view.stride);
+        applyMeshoptFilter(view.filter, view.count, view.stride, view.expected.data());
+        views.push_back(std::move(view));
+    }
+    for (int v = 0; v < 8; ++v) {
+        std::vector<uint32_t> indices(3 * VIEW_VERTEX_COUNT);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            indices[i] = static_cast<uint32_t>(i / 2 + rng() % 32);
+        }
+        CompressedView view{{}, {}, MESHOPT_MODE_INDICES, MESHOPT_FILTER_NONE, indices.size(),
+                            4};
+        const auto *bytes = reinterpret_cast<const std::byte *>(indices.data());
+        view.expected.assign(bytes, bytes + indices.size() * sizeof(uint32_t));
+        view.compressed = encodeIndexSequence(indices.data(), indices.size());
+        views.push_back(std::move(view));
+    }
+    return views;
+}
+
+int benchMeshoptDecode(int argc, char **argv) {
+    const uint32_t threads = argc > 0 ? static_cast<uint32_t>(std::max(atoi(argv[0]), 1))
+                                      : WorkerPool::hardwareConcurrency();
+    const auto views = buildViews();
+    size_t compressedBytes = 0;
+    size_t decodedBytes = 0;
+    for (const auto &view: views) {
+        compressedBytes += view.compressed.size();
+        decodedBytes += view.expected.size();
+    }
+    printf("%zu buffer views, %zu -> %zu bytes (%.1f%%), best of %d\n", views.size(),
+           compressedBytes, decodedBytes, 100.0 * double(compressedBytes) / double(decodedBytes),
+           RUNS);
+
+    std::vector<size_t> order(views.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return views[a].compressed.size() > views[b].compressed.size();
+    });
+    std::vector<std::vector<std::byte>> decoded(views.size());
+    for (size_t i = 0; i < views.size(); ++i) {
+        decoded[i].resize(views[i].expected.size());
+    }
+
+    std::atomic<bool> ok{true};
+    double serialMs = 0.0;
+    for (const uint32_t concurrency: benchmarkConcurrencies(threads)) {
+        WorkerPool pool(concurrency);
+        const double ms = bestOfMs(RUNS, [&] {
+            pool.parallelFor(order.size(), [&](size_t i) {
+                const auto &view = views[order[i]];
+                if (!decodeMeshoptBufferView(view.compressed, view.mode, view.filter, view.count,
+                                             view.stride, decoded[order[i]].data())) {
+                    ok = false;
+                }
+            });
+        });
+        for (size_t i = 0; i < views.size(); ++i) {
+            ok = ok && decoded[i] == views[i].expected;
+        }
+        serialMs = concurrency == 1 ? ms : serialMs;
+        printf("%2u threads: %8.2f ms %6.2f GB/s  (%.2fx)\n", concurrency, ms,
+               double(decodedBytes) / ms / 1e6, serialMs / ms);
+    }
+    if (!ok) {
+        fprintf(stderr, "decoded views differ from their source\n");
+        return 1;
+    }
+    return 0;
+}
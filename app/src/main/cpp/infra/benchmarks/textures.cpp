@@ -0,0 +1,49 @@
+#include <cstdlib>
+
+#include <accessor.h>
+#include <glb.h>
+#include <mappedfile.h>
+#include <spanstream.h>
+
+#include "benchmarks.h"
+
+// readTextures on the same parsed document at concurrency 1 and N, best of a few runs each
+// needs a glb with several textures to show anything, the decode is per texture
+
+int benchTextures(int argc, char **argv) {
+    if (argc < 1) {
+        fprintf(stderr, "usage: loaderbench textures <file.glb> [threads]\n");
+        return 2;
+    }
+    const uint32_t threads = argc > 1 ? static_cast<uint32_t>(std::max(atoi(argv[1]), 1))
+                                      : WorkerPool::hardwareConcurrency();
+    constexpr int RUNS = 3;
+
+    MappedFile file(argv[0]);
+    auto streamReader = std::make_shared<SpanStreamReader>(file.bytes());
+    auto glbStream = streamReader->GetInputStream("");
+    Microsoft::glTF::GLBResourceReader resourceReader(std::move(streamReader),
+                                                      std::move(glbStream));
+    const auto document = Microsoft::glTF::Deserialize(resourceReader.GetJson());
+    AccessorReader accessorReader(document, resourceReader, findGlbBinaryChunk(file.bytes()));
+    WorkerPool decodePool(WorkerPool::hardwareConcurrency());
+    accessorReader.decodeCompressedBufferViews(decodePool);
+
+    double serialMs = 0.0;
+    for (const uint32_t concurrency: benchmarkConcurrencies(threads)) {
+        WorkerPool pool(concurrency);
+        size_t texels = 0;
+        const double ms = bestOfMs(RUNS, [&] {
+            Scene scene;
+            readTextures(document, accessorReader, pool, scene);
+            texels = 0;
+            for (const auto &texture: scene.textures) {
+                texels += size_t(texture->width) * texture->height;
+            }
+        });
+        serialMs = concurrency == 1 ? ms : serialMs;
+        printf("%zu textures, %.1f Mtexels, %2u threads: %9.2f ms  (%.2fx)\n",
+               document.textures.Size(), texels / 1e6, concurrency, ms, serialMs / ms);
+    }
+    return 0;
+}
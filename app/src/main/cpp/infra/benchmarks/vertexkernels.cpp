@@ -0,0 +1,91 @@
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <vertexkernels.h>
+
+#include "benchmarks.h"
+
+// the per-element loops decodeNodeMesh ran before the kernels (push_back into unreserved
+// vectors) against widenIndices / interleaveVertices into pre-sized destinations
+// fixed synthetic streams, same seed every run, outputs are checked against each other
+
+static constexpr size_t VERTEX_COUNT = 1 << 20;
+static constexpr size_t INDEX_COUNT = 3 * VERTEX_COUNT;
+static constexpr int RUNS = 5;
+
+static void reportRate(const char *label, size_t count, double ms, double baselineMs) {
+    printf("%-24s %8.2f ms %9.1f M/s", label, ms, count / ms / 1e3);
+    if (baselineMs > 0.0) {
+        printf("  (%.2fx)", baselineMs / ms);
+    }
+    printf("\n");
+}
+
+int benchVertexKernels(int, char **) {
+    std::mt19937 rng(5);
+    std::vector<uint16_t> indices16(INDEX_COUNT);
+    for (auto &index: indices16) {
+        index = static_cast<uint16_t>(rng());
+    }
+    std::vector<float> positions(3 * VERTEX_COUNT);
+    std::vector<float> uvs(2 * VERTEX_COUNT);
+    std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+    for (auto &p: positions) {
+        p = coordinate(rng);
+    }
+    for (auto &uv: uvs) {
+        uv = coordinate(rng);
+    }
+    constexpr uint32_t MATERIAL = 7;
+
+    printf("kernels: %s, %zu indices, %zu vertices, best of %d\n", vertexKernelsIsa(),
+           INDEX_COUNT, VERTEX_COUNT, RUNS);
+
+    std::vector<uint32_t> scalarIndices;
+    const double scalarIndexMs = bestOfMs(RUNS, [&] {
+        scalarIndices = {};
+        for (const auto index: indices16) {
+            scalarIndices.push_back(index);
+        }
+    });
+    std::vector<uint32_t> widened;
+    const double widenMs = bestOfMs(RUNS, [&] {
+        widened.resize(INDEX_COUNT);
+        widenIndices(indices16.data(), INDEX_COUNT, widened.data());
+    });
+    reportRate("indices u16 push_back", INDEX_COUNT, scalarIndexMs, 0.0);
+    reportRate("indices u16 widen", INDEX_COUNT, widenMs, scalarIndexMs);
+
+    std::vector<Vertex> scalarVertices;
+    const double scalarVertexMs = bestOfMs(RUNS, [&] {
+        scalarVertices = {};
+        for (size_t i = 0; i < VERTEX_COUNT; ++i) {
+            Vertex vertex;
+            vertex.vx = positions[3 * i];
+            vertex.vy = positions[3 * i + 1];
+            vertex.vz = positions[3 * i + 2];
+            vertex.ux = uvs[2 * i];
+            vertex.uy = uvs[2 * i + 1];
+            vertex.material = MATERIAL;
+            scalarVertices.emplace_back(vertex);
+        }
+    });
+    std::vector<Vertex> interleaved;
+    const double interleaveMs = bestOfMs(RUNS, [&] {
+        interleaved.resize(VERTEX_COUNT);
+        interleaveVertices(positions.data(), uvs.data(), MATERIAL, VERTEX_COUNT,
+                           interleaved.data());
+    });
+    reportRate("vertices push_back", VERTEX_COUNT, scalarVertexMs, 0.0);
+    reportRate("vertices interleave", VERTEX_COUNT, interleaveMs, scalarVertexMs);
+
+    const bool match = scalarIndices == widened &&
+                       memcmp(scalarVertices.data(), interleaved.data(),
+                              VERTEX_COUNT * sizeof(Vertex)) == 0;
+    if (!match) {
+        fprintf(stderr, "kernel output differs from the scalar loops\n");
+        return 1;
+    }
+    return 0;
+}
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <array>
 #include <sstream>
+#include <chrono>
+#include <sys/resource.h>
 #include <GLTFSDK/GLTF.h>
 #include <GLTFSDK/GLTFResourceReader.h>
 #include <GLTFSDK/GLBResourceReader.h>
@@ -10,25 +14,27 @@
 #include <matrix.h>
 #include <quaternion.h>
 #include <misc.h>
+#include <spanstream.h>
+#include <mappedfile.h>
+#include <accessor.h>
+#include <workerpool.h>
+#include <vertexkernels.h>
+#include <meshstages.h>
+#include <scenegraph.h>
 
 
 std::shared_ptr<Scene> GltfBinaryIOReader::read(const std::string &filePath) {
-    std::shared_ptr<Scene> res = std::make_shared<Scene>();
-    // to do
-    return res;
+    // the scene owns copies of everything it needs, the mapping can go away after parsing
+    MappedFile file(filePath);
+    return read(file.bytes());
 }
 
-class InMemoryStreamReader : public Microsoft::glTF::IStreamReader {
-public:
-    InMemoryStreamReader(std::shared_ptr<std::stringstream> stream) : _stream(stream) {}
-
-    std::shared_ptr<std::istream> GetInputStream(const std::string &) const override {
-        return _stream;
-    }
-
-private:
-    std::shared_ptr<std::stringstream> _stream;
-};
+// high-water mark of the process, in KB (linux/android report ru_maxrss in KB)
+static long peakResidentSetSizeKB() {
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
 
 void PrintDocumentInfo(const Microsoft::glTF::Document &document) {
     LOGI("Asset Version: %s", document.asset.version.c_str());
@@ -65,9 +71,9 @@ void PrintDocumentInfo(const Microsoft::glTF::Document &document) {
     }
 }
 
-void PrintResourceInfo(const Microsoft::glTF::Document &document,
-                       const Microsoft::glTF::GLTFResourceReader &resourceReader) {
-    // Use the resource reader to get each mesh primitive's position data
+// sizes come from the accessors/bufferViews, nothing is decoded just to be logged
+void PrintResourceInfo(const Microsoft::glTF::Document &document) {
+    // Use the accessor to get each mesh primitive's position data size
     for (const auto &mesh: document.meshes.Elements()) {
         LOGI("Mesh: %s", mesh.id.c_str());
 
@@ -79,9 +85,10 @@ void PrintResourceInfo(const Microsoft::glTF::Document &document,
                                                         accessorId)) {
                 // find the accessor with id
                 const Microsoft::glTF::Accessor &accessor = document.accessors.Get(accessorId);
-                ASSERT(accessor.componentType == Microsoft::glTF::COMPONENT_FLOAT,
-                       "Position data accessor should be float");
-                // Sparse accessors
+                // float, or int8/int16 under KHR_mesh_quantization
+                LOGI("Position Component Type: %d%s", int(accessor.componentType),
+                     accessor.normalized ? " (normalized)" : "");
+                // Sparse accessors, substituted in place when read
                 // https://github.com/KhronosGroup/glTF-Tutorials/blob/main/gltfTutorial/gltfTutorial_005_BuffersBufferViewsAccessors.md
                 LOGI("Sparse Accessor Count: %d", accessor.sparse.count);
 //                {
@@ -96,14 +103,16 @@ void PrintResourceInfo(const Microsoft::glTF::Document &document,
                 // how buffer is read from accessor.
 //                const BufferView& bufferView = gltfDocument.bufferViews.Get(accessor.bufferViewId);
 //                const Buffer& buffer = gltfDocument.buffers.Get(bufferView.bufferId);
-                const auto data = resourceReader.ReadBinaryData<float>(document, accessor);
-                const auto dataByteLength = data.size() * sizeof(float);
-                LOGI("Mesh has: %d bytes of position data", dataByteLength);
+                const size_t dataByteLength = accessor.count *
+                                              Microsoft::glTF::Accessor::GetTypeCount(accessor.type) *
+                                              Microsoft::glTF::Accessor::GetComponentTypeSize(
+                                                      accessor.componentType);
+                LOGI("Mesh has: %zu bytes of position data", dataByteLength);
             }
         }
     }
 
-    // Use the resource reader to get each image's data
+    // Use the bufferView to get each image's data size
     for (const auto &image: document.images.Elements()) {
         std::string filename;
         if (image.uri.empty()) {
@@ -116,265 +125,597 @@ void PrintResourceInfo(const Microsoft::glTF::Document &document,
         } else {
             filename = image.uri;
         }
-        auto data = resourceReader.ReadBinaryData(document, image);
-        LOGI("Image: %d", image.id.c_str());
-        LOGI("Image: %d bytes of image data", data.size());
+        LOGI("Image: %s", image.id.c_str());
+        if (!image.bufferViewId.empty()) {
+            LOGI("Image: %zu bytes of image data",
+                 document.bufferViews.Get(image.bufferViewId).byteLength);
+        }
         LOGI("Image filename: %s", filename.c_str());
     }
 }
 
+// node's local transform, row-vector convention (v' = v * m)
+static mat4x4f nodeLocalTransform(const Microsoft::glTF::Node &node) {
+    mat4x4f m(1.0f);
+    if (node.matrix != Microsoft::glTF::Matrix4::IDENTITY) {
+        // gltf stores column-major, which is exactly our row-vector layout
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                m.data[i][j] = node.matrix.values[i * 4 + j];
+            }
+        }
+    } else if (!node.HasIdentityTRS()) {
+        auto matScale = MatrixScale4x4(node.scale.x, node.scale.y,
+                                       node.scale.z);
+        quatf q(node.rotation.x, node.rotation.y,
+                node.rotation.z, node.rotation.w);
+
+        auto matRot = RotationMatrixFromQuaternion(q);
+        auto matTranslate = MatrixTranslation4x4(node.translation.x,
+                                                 node.translation.y,
+                                                 node.translation.z);
+        // T * R * S in gltf's column-vector terms
+        m = MatrixMultiply4x4(MatrixMultiply4x4(matScale, matRot), matTranslate);
+    }
+    return m;
+}
+
+// float attribute stream of any component type KHR_mesh_quantization allows
+// float accessors keep the zero-copy view, quantized ones are dequantized once into owned
+// empty for component types a vertex attribute cannot have
+static AccessorData<float> readFloatComponents(const AccessorReader &accessorReader,
+                                               const Microsoft::glTF::Accessor &accessor) {
+    AccessorData<float> res;
+    auto dequantize = [&](const auto &quantized) {
+        res.owned.resize(quantized.size());
+        dequantizeComponents(quantized.view.data(), quantized.size(), accessor.normalized,
+                             res.owned.data());
+        res.view = res.owned;
+    };
+    switch (accessor.componentType) {
+        case Microsoft::glTF::COMPONENT_FLOAT:
+            return accessorReader.read<float>(accessor);
+        case Microsoft::glTF::COMPONENT_BYTE:
+            dequantize(accessorReader.read<int8_t>(accessor));
+            break;
+        case Microsoft::glTF::COMPONENT_UNSIGNED_BYTE:
+            dequantize(accessorReader.read<uint8_t>(accessor));
+            break;
+        case Microsoft::glTF::COMPONENT_SHORT:
+            dequantize(accessorReader.read<int16_t>(accessor));
+            break;
+        case Microsoft::glTF::COMPONENT_UNSIGNED_SHORT:
+            dequantize(accessorReader.read<uint16_t>(accessor));
+            break;
+        default:
+            LOGE("accessor %s: component type %d is not a vertex attribute type",
+                 accessor.id.c_str(), int(accessor.componentType));
+            break;
+    }
+    return res;
+}
+
+// slot of a primitive in the composite geometry, for primitives decoded straight into it
+struct PrimitiveStaging {
+    Vertex *vertices{nullptr};
+    uint32_t *indices{nullptr};
+};
+
+// vertex and index count a primitive decodes to, 0 / 0 when it does not decode into a draw
+// (same checks as decodePrimitive, the counts come from the accessors alone)
+static std::pair<size_t, size_t> primitiveStreamCounts(
+        const Microsoft::glTF::Document &document,
+        const Microsoft::glTF::MeshPrimitive &primitive) {
+    std::string positionAccessorID;
+    std::string normalAccessorID;
+    if (!primitive.TryGetAttributeAccessorId(Microsoft::glTF::ACCESSOR_POSITION,
+                                             positionAccessorID) ||
+        !primitive.TryGetAttributeAccessorId(Microsoft::glTF::ACCESSOR_NORMAL,
+                                             normalAccessorID) ||
+        !document.accessors.Has(primitive.indicesAccessorId) ||
+        !document.accessors.Has(positionAccessorID) ||
+        !document.accessors.Has(normalAccessorID)) {
+        return {0, 0};
+    }
+    const auto &indicesAccessor = document.accessors[primitive.indicesAccessorId];
+    if (indicesAccessor.componentType != Microsoft::glTF::COMPONENT_UNSIGNED_INT &&
+        indicesAccessor.componentType != Microsoft::glTF::COMPONENT_UNSIGNED_SHORT &&
+        indicesAccessor.componentType != Microsoft::glTF::COMPONENT_UNSIGNED_BYTE) {
+        return {0, 0};
+    }
+    const size_t vertexCount = document.accessors[positionAccessorID].count;
+    const size_t indexCount = indicesAccessor.count;
+    if (vertexCount == 0 || indexCount == 0) {
+        return {0, 0};
+    }
+    return {vertexCount, indexCount};
+}
+
+// decodes one gltf primitive into currMesh: one material, one draw
+// only touches currMesh (and its staging slot), so primitives can be decoded concurrently
+// staging set: vertices and indices go straight to the slot (sized by primitiveStreamCounts),
+// currMesh only gets material and bounds; false when nothing was written
+static bool decodePrimitive(const Microsoft::glTF::Document &document,
+                            const AccessorReader &accessorReader,
+                            const Microsoft::glTF::MeshPrimitive &primitive,
+                            bool keepNormals,
+                            const PrimitiveStaging &staging,
+                            Mesh &currMesh) {
+    // use Accessor to access all the data buffers
+    std::string positionAccessorID;
+    std::string normalAccessorID;
+    std::string tangentAccessorID;
+    // multiple pairs of uv coordinates
+    std::string uvAccessorID;
+    std::string uvAccessorID2;
+
+    if (primitive.materialId != "") {
+        currMesh.materialIdx = document.materials.GetIndex(primitive.materialId);
+    }
+    // get accessorId first
+    // assume normal is included in the glb
+    if (primitive.TryGetAttributeAccessorId(Microsoft::glTF::ACCESSOR_POSITION,
+                                            positionAccessorID) &&
+        primitive.TryGetAttributeAccessorId(Microsoft::glTF::ACCESSOR_NORMAL,
+                                            normalAccessorID)) {
+        // tangent and uv could be optional
+        bool hasTangent = primitive.TryGetAttributeAccessorId(
+                Microsoft::glTF::ACCESSOR_TANGENT, tangentAccessorID);
+        bool hasUV = primitive.TryGetAttributeAccessorId(
+                Microsoft::glTF::ACCESSOR_TEXCOORD_0, uvAccessorID);
+        bool hasUV2 = primitive.TryGetAttributeAccessorId(
+                Microsoft::glTF::ACCESSOR_TEXCOORD_1, uvAccessorID2);
+        // indicesAccessorId is for element buffer
+        if (document.accessors.Has(primitive.indicesAccessorId) &&
+            document.accessors.Has(positionAccessorID) &&
+            document.accessors.Has(normalAccessorID)) {
+            // get three buffers: ebo, position and normal
+            // interleave or separate ?
+            const Microsoft::glTF::Accessor &positionAccessor =
+                    document.accessors[positionAccessorID];
+            const Microsoft::glTF::Accessor &normalAccessor =
+                    document.accessors[normalAccessorID];
+            const Microsoft::glTF::Accessor &indicesAccessor =
+                    document.accessors[primitive.indicesAccessorId];
+            auto indexDestination = [&](size_t count) {
+                if (staging.indices) {
+                    return staging.indices;
+                }
+                currMesh.indices.resize(count);
+                return currMesh.indices.data();
+            };
+            // index could be u8_t, u16_t or u32_t, widened to u32_t in bulk
+            // store indices to the currMesh, relative to this primitive's own vertices
+            size_t indexCount = 0;
+            if (indicesAccessor.componentType == Microsoft::glTF::COMPONENT_UNSIGNED_INT) {
+                const auto indices =
+                        accessorReader.read<unsigned int>(indicesAccessor);
+                indexCount = indices.size();
+                memcpy(indexDestination(indexCount), indices.view.data(),
+                       indices.view.size_bytes());
+            } else if (indicesAccessor.componentType ==
+                       Microsoft::glTF::COMPONENT_UNSIGNED_SHORT) {
+                const auto indices =
+                        accessorReader.read<uint16_t>(indicesAccessor);
+                indexCount = indices.size();
+                widenIndices(indices.view.data(), indexCount, indexDestination(indexCount));
+            } else if (indicesAccessor.componentType ==
+                       Microsoft::glTF::COMPONENT_UNSIGNED_BYTE) {
+                const auto indices =
+                        accessorReader.read<uint8_t>(indicesAccessor);
+                indexCount = indices.size();
+                widenIndices(indices.view.data(), indexCount, indexDestination(indexCount));
+            }
+            if (indexCount == 0) {
+                return false;
+            }
+            // store the vertices into currMesh
+            // KHR_mesh_quantization: any attribute may be (normalized) int8/int16
+            const auto positionBuffer = readFloatComponents(accessorReader, positionAccessor);
+            const auto normalBuffer = readFloatComponents(accessorReader, normalAccessor);
+            if (!positionBuffer.empty() && !normalBuffer.empty()) {
+                auto verticesCount = positionAccessor.count;
+                // vec4f
+                AccessorData<float> tangentBuffer;
+                // vec2f
+                AccessorData<float> uvBuffer;
+                // vec2f
+                AccessorData<float> uv2Buffer;
+                if (hasTangent) {
+                    const auto &tangentAccessor = document.accessors[tangentAccessorID];
+                    tangentBuffer = readFloatComponents(accessorReader, tangentAccessor);
+                }
+
+                if (hasUV) {
+                    const auto &uvAccessor = document.accessors[uvAccessorID];
+                    uvBuffer = readFloatComponents(accessorReader, uvAccessor);
+                }
+
+                if (hasUV2) {
+                    const auto &uv2Accessor = document.accessors[uvAccessorID2];
+                    uv2Buffer = readFloatComponents(accessorReader, uv2Accessor);
+                }
+
+                // positions stay in mesh space, node transforms are applied per instance
+                // a short uv stream would read out of bounds, drop it
+                const float *uvs = uvBuffer.size() >= 2 * verticesCount ? uvBuffer.view.data()
+                                                                        : nullptr;
+                Vertex *vertices = staging.vertices;
+                if (!vertices) {
+                    currMesh.vertices.resize(verticesCount);
+                    vertices = currMesh.vertices.data();
+                }
+                interleaveVertices(positionBuffer.view.data(), uvs,
+                                   uint32_t(currMesh.materialIdx), verticesCount, vertices);
+                // normals are only consumed by quantization (octahedral encoding)
+                if (keepNormals && normalBuffer.size() >= 3 * verticesCount) {
+                    currMesh.normals.assign(normalBuffer.view.begin(),
+                                            normalBuffer.view.begin() + 3 * verticesCount);
+                }
+
+                // bounding volume: the accessor carries min/max (required by the spec for
+                // POSITION), only reduce over the stream when an exporter left them out
+                // quantized min/max are in raw component units, reduce over the decoded stream
+                float minAABB[3] = {currMesh.minAABB[COMPONENT::X],
+                                    currMesh.minAABB[COMPONENT::Y],
+                                    currMesh.minAABB[COMPONENT::Z]};
+                float maxAABB[3] = {currMesh.maxAABB[COMPONENT::X],
+                                    currMesh.maxAABB[COMPONENT::Y],
+                                    currMesh.maxAABB[COMPONENT::Z]};
+                if (positionAccessor.componentType == Microsoft::glTF::COMPONENT_FLOAT &&
+                    positionAccessor.min.size() == 3 && positionAccessor.max.size() == 3) {
+                    for (size_t c = 0; c < 3; ++c) {
+                        minAABB[c] = std::min(minAABB[c], positionAccessor.min[c]);
+                        maxAABB[c] = std::max(maxAABB[c], positionAccessor.max[c]);
+                    }
+                } else {
+                    reducePositionBounds(positionBuffer.view.data(), verticesCount, minAABB,
+                                         maxAABB);
+                }
+                currMesh.minAABB = vec3f(std::array{minAABB[0], minAABB[1], minAABB[2]});
+                currMesh.maxAABB = vec3f(std::array{maxAABB[0], maxAABB[1], maxAABB[2]});
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// the default scene's node trees, breadth first: graph order is depth order
+// nodes outside the default scene are not drawn; without scenes every parentless node is a root
+void readSceneGraph(const Microsoft::glTF::Document &document,
+                    WorkerPool &workerPool,
+                    Scene &outputScene) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t nodeCount = document.nodes.Size();
+    std::vector<uint32_t> roots;
+    if (document.scenes.Size() > 0) {
+        for (const auto &nodeId: document.GetDefaultScene().nodes) {
+            roots.push_back(std::stoul(nodeId));
+        }
+    } else {
+        std::vector<bool> hasParent(nodeCount, false);
+        for (const auto &node: document.nodes.Elements()) {
+            for (const auto &childId: node.children) {
+                hasParent[std::stoul(childId)] = true;
+            }
+        }
+        for (size_t i = 0; i < nodeCount; ++i) {
+            if (!hasParent[i]) {
+                roots.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    auto &graph = outputScene.graph;
+    graph = SceneGraph{};
+    graph.parents.reserve(nodeCount);
+    graph.sourceNodes.reserve(nodeCount);
+    graph.meshes.reserve(nodeCount);
+    // a node reached twice (cycle, shared child) keeps its first parent
+    std::vector<bool> visited(nodeCount, false);
+    auto addNode = [&](uint32_t nodeIndex, int32_t parent) {
+        if (nodeIndex >= nodeCount || visited[nodeIndex]) {
+            LOGE("glTF node %u is out of range or has several parents, skipped", nodeIndex);
+            return;
+        }
+        visited[nodeIndex] = true;
+        const auto &node = document.nodes[nodeIndex];
+        graph.parents.push_back(parent);
+        graph.sourceNodes.push_back(nodeIndex);
+        graph.meshes.push_back(node.meshId.empty() ? -1 : std::stoi(node.meshId));
+    };
+    graph.levelOffsets.push_back(0);
+    for (const auto root: roots) {
+        addNode(root, -1);
+    }
+    while (graph.levelOffsets.back() < graph.size()) {
+        const size_t begin = graph.levelOffsets.back();
+        const size_t end = graph.size();
+        graph.levelOffsets.push_back(static_cast<uint32_t>(end));
+        for (size_t i = begin; i < end; ++i) {
+            for (const auto &childId: document.nodes[graph.sourceNodes[i]].children) {
+                addNode(std::stoul(childId), static_cast<int32_t>(i));
+            }
+        }
+    }
+
+    graph.localTransforms.resize(graph.size());
+    const size_t chunkCount = (graph.size() + SCENE_GRAPH_CHUNK_SIZE - 1) / SCENE_GRAPH_CHUNK_SIZE;
+    workerPool.parallelFor(chunkCount, [&](size_t chunk) {
+        const size_t first = chunk * SCENE_GRAPH_CHUNK_SIZE;
+        const size_t last = std::min(first + SCENE_GRAPH_CHUNK_SIZE, graph.size());
+        for (size_t i = first; i < last; ++i) {
+            graph.localTransforms[i] = nodeLocalTransform(document.nodes[graph.sourceNodes[i]]);
+        }
+    });
+    graph.updateWorldTransforms(workerPool);
+
+    const auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("Scene graph: %zu of %zu nodes, %zu roots, depth %zu, flattened in %lld us",
+         graph.size(), nodeCount, roots.size(), graph.depth(), static_cast<long long>(elapsedUs));
+}
+
 void readMeshes(const Microsoft::glTF::Document &document,
-                const Microsoft::glTF::GLTFResourceReader &resourceReader,
+                const AccessorReader &accessorReader,
+                const GltfBinaryIOReaderOptions &options,
+                WorkerPool &workerPool,
                 Scene &outputScene) {
     // node: // https://github.com/KhronosGroup/glTF/blob/master/specification/2.0/schema/node.schema.json
-    // every mesh's index and instance offset
-    // while read every mesh, update firstIndex and vertexOffset, bundle into larger buffer
-    uint32_t firstIndex = 0;
-    uint32_t vertexOffset = 0;
-    for (size_t i = 0; i < document.nodes.Size(); ++i) {
-        // nodes of scene graph could not have mesh
-        if (document.nodes[i].meshId.empty()) {
+    // nodes of scene graph could not have mesh
+    // a mesh referenced by several nodes is decoded once and drawn instanced:
+    // one slot per distinct mesh (first-reference order in the graph), holding the graph nodes
+    // that instance it
+    const auto &graph = outputScene.graph;
+    std::vector<int32_t> slotOfMesh(document.meshes.Size(), -1);
+    std::vector<uint32_t> slotMeshIds;
+    std::vector<std::vector<size_t>> slotNodes;
+    size_t meshNodeCount = 0;
+    for (size_t i = 0; i < graph.size(); ++i) {
+        const int32_t meshId = graph.meshes[i];
+        if (meshId < 0 || size_t(meshId) >= slotOfMesh.size()) {
             continue;
         }
-        // string to uint
-        uint32_t meshId = std::stoul(document.nodes[i].meshId);
-        const Microsoft::glTF::Mesh &mesh = document.meshes[meshId];
-        // goal to fill in this internal mesh entity
-        Mesh currMesh;
-        // step1: node's local transform
-        mat4x4f m(1.0f);
-
-        // nodes's local transformation matrix
-        // HasIdentityTRS
-        //           return translation == Vector3::ZERO
-        //                    && rotation == Quaternion::IDENTITY
-        //                    && scale == Vector3::ONE;
-
-        if (document.nodes[i].matrix != Microsoft::glTF::Matrix4::IDENTITY) {
-            // row-major
-            for (int i = 0; i < 4; i++) {
-                for (int j = 0; j < 4; j++) {
-                    m.data[i][j] = document.nodes[i].matrix.values[i * 4 + j];
-                }
+        if (slotOfMesh[meshId] < 0) {
+            slotOfMesh[meshId] = static_cast<int32_t>(slotMeshIds.size());
+            slotMeshIds.push_back(meshId);
+            slotNodes.emplace_back();
+        }
+        slotNodes[slotOfMesh[meshId]].push_back(i);
+        ++meshNodeCount;
+    }
+
+    // pass 1: decode every primitive of every distinct mesh into its own pre-sized slot,
+    // in parallel; primitives of one mesh stay adjacent
+    struct PrimitiveRef {
+        size_t slot;
+        size_t primitive;
+    };
+    std::vector<PrimitiveRef> primitiveRefs;
+    for (size_t slot = 0; slot < slotMeshIds.size(); ++slot) {
+        const auto &mesh = document.meshes[slotMeshIds[slot]];
+        for (size_t primitive = 0; primitive < mesh.primitives.size(); ++primitive) {
+            primitiveRefs.push_back({slot, primitive});
+        }
+    }
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<Mesh> decodedPrimitives(primitiveRefs.size());
+    // per primitive: where its vertices / indices go in the composite streams, 0 counts: no draw
+    std::vector<size_t> vertexCounts(primitiveRefs.size());
+    std::vector<size_t> indexCounts(primitiveRefs.size());
+    std::vector<size_t> vertexOffsets(primitiveRefs.size());
+    std::vector<size_t> indexOffsets(primitiveRefs.size());
+    const size_t vertexStride = options.quantizeVertices ? sizeof(QuantizedVertex)
+                                                         : sizeof(Vertex);
+    // the geometry is allocated once, in the caller's staging memory when it provides some
+    auto allocateGeometry = [&](size_t vertexCount, size_t indexCount) {
+        const size_t vertexByteSize = vertexCount * vertexStride;
+        const size_t indexByteSize = indexCount * sizeof(uint32_t);
+        std::span<std::byte> geometry;
+        if (options.stageGeometry) {
+            geometry = options.stageGeometry(vertexByteSize, indexByteSize);
+            if (geometry.size() < vertexByteSize + indexByteSize) {
+                throw std::runtime_error("stageGeometry returned less than the scene geometry");
             }
-        } else if (!document.nodes[i].HasIdentityTRS()) {
-            auto matScale = MatrixScale4x4(document.nodes[i].scale.x, document.nodes[i].scale.y,
-                                           document.nodes[i].scale.z);
-            quatf q(document.nodes[i].rotation.w, document.nodes[i].rotation.x,
-                    document.nodes[i].rotation.y, document.nodes[i].rotation.z);
-
-            auto matRot = RotationMatrixFromQuaternion(q);
-            auto matTranslate = MatrixTranslation4x4(document.nodes[i].translation.x,
-                                                     document.nodes[i].translation.y,
-                                                     document.nodes[i].translation.z);
-
-            m = MatrixMultiply4x4(matTranslate, MatrixMultiply4x4(matRot, matScale));
+        } else {
+            outputScene.ownedGeometry.resize(vertexByteSize + indexByteSize);
+            geometry = outputScene.ownedGeometry;
+        }
+        outputScene.vertexBytes = geometry.first(vertexByteSize);
+        // both vertex strides are multiples of 4, the indices stay aligned
+        outputScene.indices = {reinterpret_cast<const uint32_t *>(geometry.data() +
+                                                                  vertexByteSize), indexCount};
+        outputScene.totalVerticesByteSize = static_cast<uint32_t>(vertexByteSize);
+        outputScene.totalIndexByteSize = static_cast<uint32_t>(indexByteSize);
+        return geometry;
+    };
+    // no stage rewrites the streams: size every primitive from its accessors and decode it
+    // straight into its place in the composite geometry, the streams are written exactly once
+    const MeshStages stages{.optimizeMeshes = options.optimizeMeshes,
+                            .buildMeshlets = options.buildMeshlets,
+                            .generateLods = options.generateLods,
+                            .quantizeVertices = options.quantizeVertices};
+    const bool decodeInPlace = !stages.any();
+    if (decodeInPlace) {
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        for (size_t i = 0; i < primitiveRefs.size(); ++i) {
+            const auto &ref = primitiveRefs[i];
+            const auto counts = primitiveStreamCounts(
+                    document, document.meshes[slotMeshIds[ref.slot]].primitives[ref.primitive]);
+            vertexOffsets[i] = vertexCount;
+            indexOffsets[i] = indexCount;
+            vertexCount += counts.first;
+            indexCount += counts.second;
+            vertexCounts[i] = counts.first;
+            indexCounts[i] = counts.second;
         }
-        // 2.
-        for (auto &primitive: mesh.primitives) {
-            // use Accessor to access all the data buffers
-            std::string positionAccessorID;
-            std::string normalAccessorID;
-            std::string tangentAccessorID;
-            // multiple pairs of uv coordinates
-            std::string uvAccessorID;
-            std::string uvAccessorID2;
-
-            if (primitive.materialId != "") {
-                currMesh.materialIdx = document.materials.GetIndex(primitive.materialId);
+        const auto geometry = allocateGeometry(vertexCount, indexCount);
+        auto *vertices = reinterpret_cast<Vertex *>(geometry.data());
+        auto *indices = reinterpret_cast<uint32_t *>(geometry.data() + vertexCount * vertexStride);
+        workerPool.parallelFor(primitiveRefs.size(), [&](size_t i) {
+            if (vertexCounts[i] == 0) {
+                return;
             }
-            // get accessorId first
-            // assume normal is included in the glb
-            if (primitive.TryGetAttributeAccessorId(Microsoft::glTF::ACCESSOR_POSITION,
-                                                    positionAccessorID) &&
-                primitive.TryGetAttributeAccessorId(Microsoft::glTF::ACCESSOR_NORMAL,
-                                                    normalAccessorID)) {
-                // tangent and uv could be optional
-                bool hasTangent = primitive.TryGetAttributeAccessorId(
-                        Microsoft::glTF::ACCESSOR_TANGENT, tangentAccessorID);
-                bool hasUV = primitive.TryGetAttributeAccessorId(
-                        Microsoft::glTF::ACCESSOR_TEXCOORD_0, uvAccessorID);
-                bool hasUV2 = primitive.TryGetAttributeAccessorId(
-                        Microsoft::glTF::ACCESSOR_TEXCOORD_1, uvAccessorID2);
-                // indicesAccessorId is for element buffer
-                if (document.accessors.Has(primitive.indicesAccessorId) &&
-                    document.accessors.Has(positionAccessorID) &&
-                    document.accessors.Has(normalAccessorID)) {
-                    // get three buffers: ebo, position and normal
-                    // interleave or separate ?
-                    const Microsoft::glTF::Accessor &positionAccessor =
-                            document.accessors[positionAccessorID];
-                    const Microsoft::glTF::Accessor &normalAccessor =
-                            document.accessors[normalAccessorID];
-                    const Microsoft::glTF::Accessor &indicesAccessor =
-                            document.accessors[primitive.indicesAccessorId];
-                    // index could be u16_t or u32_t
-                    // store indices to the currMesh
-                    if (indicesAccessor.componentType == Microsoft::glTF::COMPONENT_UNSIGNED_INT) {
-                        std::vector<unsigned int> indices =
-                                resourceReader.ReadBinaryData<unsigned int>(document,
-                                                                            indicesAccessor);
-                        for (auto &index: indices) {
-                            // LOGI("Indices: %d", index);
-                            currMesh.indices.push_back(index);
-                        }
-                    } else if (indicesAccessor.componentType ==
-                               Microsoft::glTF::COMPONENT_UNSIGNED_SHORT) {
-                        std::vector<unsigned short> indices =
-                                resourceReader.ReadBinaryData<unsigned short>(document,
-                                                                              indicesAccessor);
-                        for (auto &index: indices) {
-                            // LOGI("Indices: %d", index);
-                            currMesh.indices.push_back(index);
-                        }
-                    }
-                    // store the vertices into currMesh
-                    if (positionAccessor.componentType == Microsoft::glTF::COMPONENT_FLOAT &&
-                        normalAccessor.componentType == Microsoft::glTF::COMPONENT_FLOAT) {
-                        std::vector<float> positionBuffer =
-                                resourceReader.ReadBinaryData<float>(document, positionAccessor);
-                        std::vector<float> normalBuffer =
-                                resourceReader.ReadBinaryData<float>(document, normalAccessor);
-
-                        auto verticesCount = positionAccessor.count;
-                        // vec4f
-                        std::vector<float> tangentBuffer(verticesCount * 4, 0.0);
-                        // vec2f
-                        std::vector<float> uvBuffer(verticesCount * 2, 0.0);
-                        // vec2f
-                        std::vector<float> uv2Buffer(verticesCount * 2, 0.0);
-                        if (hasTangent) {
-                            const auto &tangentAccessor = document.accessors[tangentAccessorID];
-                            tangentBuffer = resourceReader.ReadBinaryData<float>(document,
-                                                                                 tangentAccessor);
-                        }
-
-                        if (hasUV) {
-                            const auto &uvAccessor = document.accessors[uvAccessorID];
-                            uvBuffer = resourceReader.ReadBinaryData<float>(document, uvAccessor);
-                        }
-
-                        if (hasUV2) {
-                            const auto &uv2Accessor = document.accessors[uvAccessorID2];
-                            uv2Buffer = resourceReader.ReadBinaryData<float>(document, uv2Accessor);
-                        }
-
-                        for (uint64_t i = 0; i < verticesCount; i++) {
-                            const std::array<uint64_t, 4> vec4Offset = {4 * i, 4 * i + 1,
-                                                                        4 * i + 2, 4 * i + 3};
-                            const std::array<uint64_t, 3> vec3Offset = {3 * i, 3 * i + 1,
-                                                                        3 * i + 2};
-                            const std::array<uint64_t, 2> vec2Offset = {2 * i, 2 * i + 1};
-
-                            // to begin with, keep it simple
-                            //  vec3f(std::array{0.0f, 1.0f, 0.0f}),
-//                            Vertex vertex{
-//                                    .pos = vec3f(std::array{positionBuffer[vec3Offset[0]],
-//                                                            positionBuffer[vec3Offset[1]],
-//                                                            positionBuffer[vec3Offset[2]]}),
-//                                    .texCoord = vec2f(std::array{uvBuffer[vec2Offset[0]],
-//                                                                 uvBuffer[vec2Offset[1]]}),
-//                                    .material = uint32_t(currMesh.materialIdx),
-//                            };
-
-                            Vertex vertex;
-                            vertex.vx = positionBuffer[vec3Offset[0]];
-                            vertex.vy = positionBuffer[vec3Offset[1]];
-                            vertex.vz = positionBuffer[vec3Offset[2]];
-
-                            vertex.ux = positionBuffer[vec2Offset[0]];
-                            vertex.uy = positionBuffer[vec2Offset[1]];
-                            vertex.material = uint32_t(currMesh.materialIdx);
-
-                            // apply local transform for all the positions and normals (if exists)
-//                            LOGI("Before Transform: [%d %f, %f, %f]",
-//                                 i,
-//                                 vertex.vx,
-//                                 vertex.vy,
-//                                 vertex.vz);
-                            //vertex.transform(m);
-                            LOGI("After Transform: [%f %f %f]",
-                                 vertex.vx,
-                                 vertex.vy,
-                                 vertex.vz);
-
-                            currMesh.vertices.emplace_back(vertex);
-                            // To Do: calculating Bounding Volumes
-                            if (vertex.vx < currMesh.minAABB[COMPONENT::X]) {
-                                currMesh.minAABB[COMPONENT::X] = vertex.vx;
-                            }
-                            if (vertex.vy < currMesh.minAABB[COMPONENT::Y]) {
-                                currMesh.minAABB[COMPONENT::Y] = vertex.vy;
-                            }
-                            if (vertex.vz < currMesh.minAABB[COMPONENT::Z]) {
-                                currMesh.minAABB[COMPONENT::Z] = vertex.vz;
-                            }
-                            if (vertex.vx > currMesh.maxAABB[COMPONENT::X]) {
-                                currMesh.maxAABB[COMPONENT::X] = vertex.vx;
-                            }
-                            if (vertex.vy > currMesh.maxAABB[COMPONENT::Y]) {
-                                currMesh.maxAABB[COMPONENT::Y] = vertex.vy;
-                            }
-                            if (vertex.vz > currMesh.maxAABB[COMPONENT::Z]) {
-                                currMesh.maxAABB[COMPONENT::Z] = vertex.vz;
-                            }
-                        }
-                    }
-                }
+            const auto &ref = primitiveRefs[i];
+            const PrimitiveStaging staging{.vertices = vertices + vertexOffsets[i],
+                                           .indices = indices + indexOffsets[i]};
+            // a primitive failing late leaves a hole in the streams, nothing draws it
+            if (!decodePrimitive(document, accessorReader,
+                                 document.meshes[slotMeshIds[ref.slot]].primitives[ref.primitive],
+                                 false, staging, decodedPrimitives[i])) {
+                vertexCounts[i] = 0;
+                indexCounts[i] = 0;
             }
+        });
+    } else {
+        workerPool.parallelFor(primitiveRefs.size(), [&](size_t i) {
+            const auto &ref = primitiveRefs[i];
+            decodePrimitive(document, accessorReader,
+                            document.meshes[slotMeshIds[ref.slot]].primitives[ref.primitive],
+                            options.quantizeVertices, {}, decodedPrimitives[i]);
+        });
+    }
+    size_t decodedVertices = 0;
+    for (size_t i = 0; i < decodedPrimitives.size(); ++i) {
+        decodedVertices += decodeInPlace ? vertexCounts[i] : decodedPrimitives[i].vertices.size();
+    }
+    const auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("Decoded %zu primitives of %zu meshes (%zu mesh nodes), %zu vertices in %lld us "
+         "(%s kernels, %.1f Mvertices/s)",
+         decodedPrimitives.size(), slotMeshIds.size(), meshNodeCount, decodedVertices,
+         static_cast<long long>(elapsedUs), vertexKernelsIsa(),
+         elapsedUs > 0 ? double(decodedVertices) / double(elapsedUs) : 0.0);
+
+    auto primitiveMeshlets = runMeshStages(decodedPrimitives, stages, workerPool);
+    outputScene.quantizedVertices = options.quantizeVertices;
+
+    // the stages are done, the final streams go into the composite geometry in one copy:
+    // prefix sum in primitive order, same firstIndex/vertexOffset as a serial walk
+    if (!decodeInPlace) {
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        for (size_t i = 0; i < decodedPrimitives.size(); ++i) {
+            const auto &primitive = decodedPrimitives[i];
+            if (primitive.indices.empty() || primitive.vertexCount() == 0) {
+                continue;
+            }
+            vertexOffsets[i] = vertexCount;
+            indexOffsets[i] = indexCount;
+            vertexCounts[i] = primitive.vertexCount();
+            indexCounts[i] = primitive.indices.size();
+            vertexCount += vertexCounts[i];
+            indexCount += indexCounts[i];
         }
+        const auto geometry = allocateGeometry(vertexCount, indexCount);
+        auto *indices = reinterpret_cast<uint32_t *>(geometry.data() + vertexCount * vertexStride);
+        workerPool.parallelFor(decodedPrimitives.size(), [&](size_t i) {
+            auto &primitive = decodedPrimitives[i];
+            if (vertexCounts[i] != 0) {
+                const auto vertexBytes = primitive.vertexBytes();
+                memcpy(geometry.data() + vertexOffsets[i] * vertexStride, vertexBytes.data(),
+                       vertexBytes.size());
+                memcpy(indices + indexOffsets[i], primitive.indices.data(),
+                       indexCounts[i] * sizeof(uint32_t));
+            }
+            primitive.vertices = {};
+            primitive.quantizedVertices = {};
+            primitive.normals = {};
+            primitive.indices = {};
+        });
+    }
 
+    // pass 2: one draw record per primitive, with its own material and bounds
+    // primitives of one mesh share its instances, the transforms are emitted once per mesh
+    std::vector<int64_t> slotFirstInstance(slotMeshIds.size(), -1);
+    outputScene.meshes.reserve(outputScene.meshes.size() + decodedPrimitives.size());
+    outputScene.indirectDraw.reserve(outputScene.indirectDraw.size() + decodedPrimitives.size());
+    outputScene.instanceTransforms.reserve(outputScene.instanceTransforms.size() +
+                                           meshNodeCount);
+    for (size_t i = 0; i < decodedPrimitives.size(); ++i) {
+        auto &currMesh = decodedPrimitives[i];
         // indirect draw buffer
-        if (!currMesh.indices.empty() && !currMesh.vertices.empty()) {
-            IndirectDrawDef1 indirectDraw{
-                    .indexCount = static_cast<uint32_t>(currMesh.indices.size()),
-                    .instanceCount = 1,
-                    .firstIndex = firstIndex,
-                    .vertexOffset = vertexOffset,
-                    .firstInstance = 0,
-                    .meshId = static_cast<uint32_t>(outputScene.meshes.size()),
-                    .materialIndex = currMesh.materialIdx,
-            };
-
-            firstIndex += currMesh.indices.size();
-            vertexOffset += currMesh.vertices.size();
+        if (indexCounts[i] == 0 || vertexCounts[i] == 0) {
+            continue;
+        }
+        const auto firstIndex = static_cast<uint32_t>(indexOffsets[i]);
+        const auto vertexOffset = static_cast<uint32_t>(vertexOffsets[i]);
+
+        // instances of one mesh are contiguous, gl_InstanceIndex walks them
+        // world transforms: the hierarchy is already flattened
+        const size_t slot = primitiveRefs[i].slot;
+        const auto &nodes = slotNodes[slot];
+        if (slotFirstInstance[slot] < 0) {
+            slotFirstInstance[slot] = static_cast<int64_t>(outputScene.instanceTransforms.size());
+            for (const auto graphNode: nodes) {
+                outputScene.instanceTransforms.emplace_back(graph.worldTransforms[graphNode]);
+            }
+        }
+        IndirectDrawDef1 indirectDraw{
+                .indexCount = static_cast<uint32_t>(currMesh.lods.empty()
+                                                     ? indexCounts[i]
+                                                     : currMesh.lods[0].indexCount),
+                .instanceCount = static_cast<uint32_t>(nodes.size()),
+                .firstIndex = firstIndex,
+                .vertexOffset = vertexOffset,
+                .vertexCount = static_cast<uint32_t>(vertexCounts[i]),
+                .firstInstance = static_cast<uint32_t>(slotFirstInstance[slot]),
+                .meshId = static_cast<uint32_t>(outputScene.meshes.size()),
+                .materialIndex = currMesh.materialIdx,
+        };
+
+        if (!primitiveMeshlets.empty()) {
+            appendMeshlets(outputScene, primitiveMeshlets[i],
+                           static_cast<uint32_t>(outputScene.indirectDraw.size()), vertexOffset);
+        }
 
-            currMesh.extents = (currMesh.maxAABB - currMesh.minAABB) * 0.5f;
-            currMesh.center = currMesh.minAABB + currMesh.extents;
+        currMesh.extents = (currMesh.maxAABB - currMesh.minAABB) * 0.5f;
+        currMesh.center = currMesh.minAABB + currMesh.extents;
 
-            LOGI("Extents: [%f %f %f]", currMesh.extents[COMPONENT::X],
-                 currMesh.extents[COMPONENT::Y],
-                 currMesh.extents[COMPONENT::Z]);
-            LOGI("Center: [%f %f %f]", currMesh.center[COMPONENT::X], currMesh.center[COMPONENT::Y],
-                 currMesh.center[COMPONENT::Z]);
+        LOGI("Extents: [%f %f %f]", currMesh.extents[COMPONENT::X],
+             currMesh.extents[COMPONENT::Y],
+             currMesh.extents[COMPONENT::Z]);
+        LOGI("Center: [%f %f %f]", currMesh.center[COMPONENT::X], currMesh.center[COMPONENT::Y],
+             currMesh.center[COMPONENT::Z]);
 
-            outputScene.meshes.emplace_back(currMesh);
-            outputScene.indirectDraw.emplace_back(indirectDraw);
-            outputScene.totalVerticesByteSize +=
-                    sizeof(Vertex) * outputScene.meshes.back().vertices.size();
-            outputScene.totalIndexByteSize +=
-                    sizeof(uint32_t) * outputScene.meshes.back().indices.size();
-        }
+        outputScene.meshes.emplace_back(std::move(currMesh));
+        outputScene.indirectDraw.emplace_back(indirectDraw);
     }
 }
 
-std::vector<uint8_t> readTextureRawBuffer(
+// encoded (png/jpeg) bytes of the image, straight out of the BIN chunk when possible
+AccessorData<uint8_t> readTextureRawBuffer(
         const Microsoft::glTF::Document &document,
-        const Microsoft::glTF::GLTFResourceReader &resourceReader,
+        const AccessorReader &accessorReader,
         const std::string &imageId) {
     auto &image = document.images.Get(imageId);
-    auto imageBufferView = document.bufferViews.Get(image.bufferViewId);
-    auto imageRawBuffer = resourceReader.ReadBinaryData<uint8_t>(document, imageBufferView);
-    return imageRawBuffer;
+    auto &imageBufferView = document.bufferViews.Get(image.bufferViewId);
+    return accessorReader.readBufferView(imageBufferView);
 }
 
+// textures are independent: decode them concurrently into slots, keep document order
 void readTextures(const Microsoft::glTF::Document &document,
-                  const Microsoft::glTF::GLTFResourceReader &resourceReader,
+                  const AccessorReader &accessorReader,
+                  WorkerPool &workerPool,
                   Scene &outputScene) {
-    for (int i = 0; i < document.textures.Size(); ++i) {
-        outputScene.textures.emplace_back(std::move(std::make_unique<Texture>(
-                readTextureRawBuffer(document, resourceReader,document.textures[i].imageId))));
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::unique_ptr<Texture>> decodedTextures(document.textures.Size());
+    workerPool.parallelFor(decodedTextures.size(), [&](size_t i) {
+        decodedTextures[i] = std::make_unique<Texture>(
+                readTextureRawBuffer(document, accessorReader, document.textures[i].imageId).view);
+    });
+    outputScene.textures.reserve(outputScene.textures.size() + decodedTextures.size());
+    for (auto &texture: decodedTextures) {
+        outputScene.textures.emplace_back(std::move(texture));
     }
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("Decoded %zu textures in %lld ms on %u threads", decodedTextures.size(),
+         static_cast<long long>(elapsedMs), workerPool.concurrency());
 }
 
 void readMaterials(const Microsoft::glTF::Document &document, Scene &outputScene) {
@@ -398,15 +739,18 @@ void readMaterials(const Microsoft::glTF::Document &document, Scene &outputScene
 }
 
 std::shared_ptr<Scene> GltfBinaryIOReader::read(const std::vector<char> &binarybuffer) {
+    return read(std::as_bytes(std::span(binarybuffer)));
+}
+
+std::shared_ptr<Scene> GltfBinaryIOReader::read(std::span<const std::byte> glbBytes) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto peakRssBeforeKB = peakResidentSetSizeKB();
+
     std::shared_ptr<Scene> res = std::make_shared<Scene>();
     Scene &scene = *res.get();
 
-    std::shared_ptr<std::stringstream> sstream = std::make_shared<std::stringstream>();
-    for (const auto c: binarybuffer) {
-        *sstream << c;
-    }
-
-    auto streamReader = std::make_shared<InMemoryStreamReader>(sstream);
+    // no copy of the glb: the reader seeks and reads straight out of the caller's buffer
+    auto streamReader = std::make_shared<SpanStreamReader>(glbBytes);
     // in memory reader does not care about filepath
     auto glbStream = streamReader->GetInputStream("");
 
@@ -433,10 +777,22 @@ std::shared_ptr<Scene> GltfBinaryIOReader::read(const std::vector<char> &binaryb
 
     std::cout << "### glTF Info - ###\n\n";
     PrintDocumentInfo(document);
-    PrintResourceInfo(document, *glbResourceReader);
-
-    readMeshes(document, *glbResourceReader, scene);
-    readTextures(document, *glbResourceReader, scene);
+    PrintResourceInfo(document);
+
+    // accessors are served from the BIN chunk in place (mapped file or caller's buffer)
+    AccessorReader accessorReader(document, *glbResourceReader, findGlbBinaryChunk(glbBytes));
+    WorkerPool meshDecodePool(_options.meshDecodeConcurrency);
+    // EXT_meshopt_compression views are decoded once, before any accessor reads them
+    accessorReader.decodeCompressedBufferViews(meshDecodePool);
+    readSceneGraph(document, meshDecodePool, scene);
+    readMeshes(document, accessorReader, _options, meshDecodePool, scene);
+    WorkerPool textureDecodePool(_options.textureDecodeConcurrency);
+    readTextures(document, accessorReader, textureDecodePool, scene);
     readMaterials(document, scene);
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("GLB read: %zu bytes in %lld ms, peak RSS %ld KB -> %ld KB", glbBytes.size(),
+         static_cast<long long>(elapsedMs), peakRssBeforeKB, peakResidentSetSizeKB());
     return res;
 }
@@ -1,19 +1,66 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <span>
 
 #include <GLTFSDK/Deserialize.h>
 #include <GLTFSDK/GLBResourceReader.h>
 #include <GLTFSDK/GLTF.h>
 #include <GLTFSDK/GLTFResourceReader.h>
+#include <accessor.h>
 #include <scene.h>
+#include <workerpool.h>
+
+// destination of the scene's composite geometry, called once with the size of the whole scene:
+// vertices (Vertex or QuantizedVertex) at [0, vertexByteSize), u32 indices right behind them
+// typically a persistently mapped staging buffer, it has to outlive the Scene's views into it
+using GeometryStagingFn = std::function<std::span<std::byte>(size_t vertexByteSize,
+                                                             size_t indexByteSize)>;
+
+struct GltfBinaryIOReaderOptions {
+    // threads decoding mesh primitives and compressed buffer views (calling thread included),
+    // 1: serial
+    // the resulting Scene is identical for any value
+    uint32_t meshDecodeConcurrency{1};
+    // threads decoding png/jpeg textures (calling thread included), 1: serial
+    // Scene::textures stays in document order for any value
+    uint32_t textureDecodeConcurrency{1};
+    // emit QuantizedVertex (12 bytes) instead of Vertex (24 bytes), see Scene::quantizedVertices
+    bool quantizeVertices{false};
+    // weld + vertex cache / overdraw / fetch optimization per primitive, logs ACMR/ATVR/overfetch
+    bool optimizeMeshes{false};
+    // split every primitive into meshlets with bounds and normal cones, see Scene::meshlets
+    bool buildMeshlets{false};
+    // qem simplified levels behind each primitive's indices, see Mesh::lods
+    bool generateLods{false};
+    // (the three stages above can also run later, on the decoded scene: refineSceneGeometry)
+    // empty: the geometry is kept in Scene::ownedGeometry
+    // with none of the stages above, primitives are decoded straight into it (sized from the
+    // accessor counts up front); otherwise their final streams are copied in once, at the end
+    GeometryStagingFn stageGeometry{};
+};
+
+// decodes every document texture on workerPool and appends them to outputScene.textures in
+// document order; the read() stage behind textureDecodeConcurrency, exposed for loaderbench
+void readTextures(const Microsoft::glTF::Document &document,
+                  const AccessorReader &accessorReader,
+                  WorkerPool &workerPool,
+                  Scene &outputScene);
 
 class GltfBinaryIOReader {
 public:
+    explicit GltfBinaryIOReader(const GltfBinaryIOReaderOptions &options = {})
+            : _options(options) {}
+
     std::shared_ptr <Scene> read(const std::string &filePath);
 
     // for android
     std::shared_ptr <Scene> read(const std::vector<char> &binarybuffer);
 
+    // parses the glb in place, glbBytes only needs to stay alive for the duration of the call
+    std::shared_ptr <Scene> read(std::span<const std::byte> glbBytes);
+
 private:
+    GltfBinaryIOReaderOptions _options;
 };
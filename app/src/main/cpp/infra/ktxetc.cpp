@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <ktxetc.h>
+#include <ktxint.h>
+#include <gl_format.h>
+
+bool isEtcFormat(uint32_t glInternalformat) {
+    switch (glInternalformat) {
+        case GL_ETC1_RGB8_OES:
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_SRGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+        case GL_COMPRESSED_R11_EAC:
+        case GL_COMPRESSED_SIGNED_R11_EAC:
+        case GL_COMPRESSED_RG11_EAC:
+        case GL_COMPRESSED_SIGNED_RG11_EAC:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static uint32_t channelCount(GLenum format) {
+    switch (format) {
+        case GL_RED:
+            return 1;
+        case GL_RG:
+            return 2;
+        case GL_RGB:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+// 3-channel 8-bit formats are rarely sampleable in vulkan, they get an opaque alpha
+static GLenum widenedInternalformat(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_RGB8:
+            return GL_RGBA8;
+        case GL_SRGB8:
+            return GL_SRGB8_ALPHA8;
+        default:
+            return internalFormat;
+    }
+}
+
+ktxResult unpackEtcTexture(ktxTexture *etcTexture, ktxTexture **unpackedTexture) {
+    *unpackedTexture = nullptr;
+    if (!isEtcFormat(etcTexture->glInternalformat) || etcTexture->baseDepth > 1) {
+        return KTX_UNSUPPORTED_TEXTURE_TYPE;
+    }
+    if (!etcTexture->pData) {
+        const auto result = ktxTexture_LoadImageData(etcTexture, nullptr, 0);
+        if (result != KTX_SUCCESS) {
+            return result;
+        }
+    }
+
+    ktxTexture *texture = nullptr;
+    for (uint32_t level = 0; level < etcTexture->numLevels; ++level) {
+        const uint32_t width = std::max(1u, etcTexture->baseWidth >> level);
+        const uint32_t height = std::max(1u, etcTexture->baseHeight >> level);
+        for (uint32_t layer = 0; layer < etcTexture->numLayers; ++layer) {
+            for (uint32_t face = 0; face < etcTexture->numFaces; ++face) {
+                ktx_size_t srcOffset = 0;
+                auto result = ktxTexture_GetImageOffset(etcTexture, level, layer, face,
+                                                        &srcOffset);
+                GLubyte *decoded = nullptr;
+                GLenum format = 0, internalFormat = 0, type = 0;
+                if (result == KTX_SUCCESS) {
+                    result = _ktxUnpackETC(etcTexture->pData + srcOffset,
+                                           etcTexture->glInternalformat, width, height,
+                                           &decoded, &format, &internalFormat, &type,
+                                           _KTX_ALL_R16_FORMATS, KTX_TRUE);
+                }
+                // the output format is only known once the first image is decoded
+                if (result == KTX_SUCCESS && !texture) {
+                    ktxTextureCreateInfo createInfo{
+                            .glInternalformat = widenedInternalformat(internalFormat),
+                            .baseWidth = etcTexture->baseWidth,
+                            .baseHeight = etcTexture->baseHeight,
+                            .baseDepth = 1,
+                            .numDimensions = etcTexture->numDimensions,
+                            .numLevels = etcTexture->numLevels,
+                            .numLayers = etcTexture->numLayers,
+                            .numFaces = etcTexture->numFaces,
+                            .isArray = etcTexture->isArray,
+                            .generateMipmaps = etcTexture->generateMipmaps,
+                    };
+                    result = ktxTexture_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                               &texture);
+                }
+                ktx_size_t dstOffset = 0;
+                if (result == KTX_SUCCESS) {
+                    result = ktxTexture_GetImageOffset(texture, level, layer, face, &dstOffset);
+                }
+                if (result != KTX_SUCCESS) {
+                    free(decoded);
+                    if (texture) {
+                        ktxTexture_Destroy(texture);
+                    }
+                    return result;
+                }
+
+                // decoded rows are tight, the texture's are padded to KTX_GL_UNPACK_ALIGNMENT
+                const uint32_t srcPixelBytes =
+                        channelCount(format) * (type == GL_UNSIGNED_BYTE ? 1 : 2);
+                const uint32_t dstPixelBytes = format == GL_RGB ? 4 : srcPixelBytes;
+                const size_t dstRowBytes = (size_t(width) * dstPixelBytes +
+                                            KTX_GL_UNPACK_ALIGNMENT - 1) &
+                                           ~size_t(KTX_GL_UNPACK_ALIGNMENT - 1);
+                for (uint32_t y = 0; y < height; ++y) {
+                    const GLubyte *src = decoded + size_t(y) * width * srcPixelBytes;
+                    ktx_uint8_t *dst = texture->pData + dstOffset + y * dstRowBytes;
+                    if (format != GL_RGB) {
+                        memcpy(dst, src, size_t(width) * srcPixelBytes);
+                        continue;
+                    }
+                    for (uint32_t x = 0; x < width; ++x, src += 3, dst += 4) {
+                        dst[0] = src[0];
+                        dst[1] = src[1];
+                        dst[2] = src[2];
+                        dst[3] = 255;
+                    }
+                }
+                free(decoded);
+            }
+        }
+    }
+    *unpackedTexture = texture;
+    return KTX_SUCCESS;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+#include <ktx.h>
+
+// software fallback for ETC1 / ETC2 / EAC ktx textures on devices without textureCompressionETC2
+
+bool isEtcFormat(uint32_t glInternalformat);
+
+// decodes every level, layer and face of etcTexture with the ktx etc unpacker into a new
+// uncompressed texture the vulkan loader can upload:
+// rgb8 / rgba8 -> rgba8 (sRGB kept), r11 / rg11 eac -> r16 / rg16 (signed kept)
+// etcTexture's image data is loaded first if it is not yet
+ktxResult unpackEtcTexture(ktxTexture *etcTexture, ktxTexture **unpackedTexture);
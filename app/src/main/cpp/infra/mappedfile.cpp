@@ -0,0 +1,43 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mappedfile.h>
+
+MappedFile::MappedFile(const std::string &filePath) {
+    const int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("MappedFile: cannot open " + filePath + ": " + strerror(errno));
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        const int err = errno;
+        close(fd);
+        throw std::runtime_error("MappedFile: cannot stat " + filePath + ": " + strerror(err));
+    }
+    _size = static_cast<size_t>(st.st_size);
+    // mmap of length 0 is EINVAL, an empty file is simply an empty span
+    if (_size > 0) {
+        _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (_data == MAP_FAILED) {
+            const int err = errno;
+            _data = nullptr;
+            close(fd);
+            throw std::runtime_error("MappedFile: cannot mmap " + filePath + ": " + strerror(err));
+        }
+        // glb is consumed front to back: aggressive read-ahead, pages can be dropped behind us
+        madvise(_data, _size, MADV_SEQUENTIAL);
+    }
+    // the mapping keeps its own reference to the file
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) {
+        munmap(_data, _size);
+    }
+}
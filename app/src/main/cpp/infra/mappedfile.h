@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+// read-only mmap of a whole file
+// pages are served from the page cache, nothing is copied into the heap
+class MappedFile {
+public:
+    // throws std::runtime_error when the file cannot be opened or mapped
+    explicit MappedFile(const std::string &filePath);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    inline std::span<const std::byte> bytes() const {
+        return {static_cast<const std::byte *>(_data), _size};
+    }
+
+private:
+    void *_data{nullptr};
+    size_t _size{0};
+};
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cmath>
+
+#include <misc.h>
+#include <meshlets.h>
+
+static_assert(sizeof(Meshlet) == 64, "Meshlet is read as a std430 struct");
+
+namespace {
+constexpr uint8_t NOT_IN_MESHLET = 0xff;
+
+inline void sub(const float *a, const float *b, float *out) {
+    out[0] = a[0] - b[0];
+    out[1] = a[1] - b[1];
+    out[2] = a[2] - b[2];
+}
+
+inline float dot(const float *a, const float *b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// bounding sphere + normal cone of the meshlet that was just closed
+void computeBounds(Meshlet &meshlet, const MeshletBuffers &buffers,
+                   std::span<const Vertex> vertices) {
+    const uint32_t *remap = buffers.vertices.data() + meshlet.vertexOffset;
+    const uint8_t *triangles = buffers.triangles.data() + meshlet.triangleOffset;
+
+    // sphere: aabb center, radius to the farthest vertex
+    float lo[3] = {vertices[remap[0]].vx, vertices[remap[0]].vy, vertices[remap[0]].vz};
+    float hi[3] = {lo[0], lo[1], lo[2]};
+    for (uint32_t i = 1; i < meshlet.vertexCount; ++i) {
+        const float p[3] = {vertices[remap[i]].vx, vertices[remap[i]].vy, vertices[remap[i]].vz};
+        for (int c = 0; c < 3; ++c) {
+            lo[c] = std::min(lo[c], p[c]);
+            hi[c] = std::max(hi[c], p[c]);
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        meshlet.center[c] = (lo[c] + hi[c]) * 0.5f;
+    }
+    float radius2 = 0;
+    for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+        const float p[3] = {vertices[remap[i]].vx, vertices[remap[i]].vy, vertices[remap[i]].vz};
+        float d[3];
+        sub(p, meshlet.center, d);
+        radius2 = std::max(radius2, dot(d, d));
+    }
+    meshlet.radius = std::sqrt(radius2);
+
+    // cone: axis = average of the unit triangle normals, spread = worst normal against it
+    std::vector<float> normals(meshlet.triangleCount * 3, 0.0f);
+    std::vector<bool> degenerate(meshlet.triangleCount, false);
+    float axis[3] = {0, 0, 0};
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+        const Vertex &a = vertices[remap[triangles[t * 3 + 0]]];
+        const Vertex &b = vertices[remap[triangles[t * 3 + 1]]];
+        const Vertex &c = vertices[remap[triangles[t * 3 + 2]]];
+        const float e0[3] = {b.vx - a.vx, b.vy - a.vy, b.vz - a.vz};
+        const float e1[3] = {c.vx - a.vx, c.vy - a.vy, c.vz - a.vz};
+        float *n = normals.data() + t * 3;
+        n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+        n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+        n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+        const float length = std::sqrt(dot(n, n));
+        if (length == 0.0f) {
+            degenerate[t] = true;
+            continue;
+        }
+        for (int i = 0; i < 3; ++i) {
+            n[i] /= length;
+            axis[i] += n[i];
+        }
+    }
+    const float axisLength = std::sqrt(dot(axis, axis));
+    meshlet.coneCutoff = 1.0f;
+    if (axisLength == 0.0f) {
+        return;
+    }
+    for (auto &c: axis) {
+        c /= axisLength;
+    }
+    meshlet.coneAxis[0] = axis[0];
+    meshlet.coneAxis[1] = axis[1];
+    meshlet.coneAxis[2] = axis[2];
+
+    float minDot = 1.0f;
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+        if (!degenerate[t]) {
+            minDot = std::min(minDot, dot(normals.data() + t * 3, axis));
+        }
+    }
+    // a cone of 90 degrees or more can always be seen from some side of the meshlet
+    if (minDot <= 0.0f) {
+        meshlet.coneApex[0] = meshlet.center[0];
+        meshlet.coneApex[1] = meshlet.center[1];
+        meshlet.coneApex[2] = meshlet.center[2];
+        return;
+    }
+    // apex: pull the sphere center back along the axis until it is behind every triangle plane
+    float maxT = 0.0f;
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t) {
+        if (degenerate[t]) {
+            continue;
+        }
+        const Vertex &a = vertices[remap[triangles[t * 3 + 0]]];
+        const float p[3] = {a.vx, a.vy, a.vz};
+        const float *n = normals.data() + t * 3;
+        float d[3];
+        sub(meshlet.center, p, d);
+        maxT = std::max(maxT, dot(d, n) / dot(axis, n));
+    }
+    for (int c = 0; c < 3; ++c) {
+        meshlet.coneApex[c] = meshlet.center[c] - axis[c] * maxT;
+    }
+    // sin of the spread: the view direction has to be that far past the axis' normal plane
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+}
+
+MeshletBuffers buildMeshlets(std::span<const uint32_t> indices, std::span<const Vertex> vertices,
+                             uint32_t maxVertices, uint32_t maxTriangles) {
+    ASSERT(maxVertices >= 3 && maxVertices < NOT_IN_MESHLET, "meshlet vertex limit out of range");
+    ASSERT(maxTriangles >= 1, "meshlet triangle limit out of range");
+    MeshletBuffers buffers;
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertices.empty()) {
+        return buffers;
+    }
+    buffers.meshlets.reserve(triangleCount / maxTriangles + 1);
+    buffers.vertices.reserve(triangleCount);
+    buffers.triangles.reserve(triangleCount * 3 + triangleCount / maxTriangles * 4 + 4);
+
+    // local slot of each primitive vertex in the meshlet being built
+    std::vector<uint8_t> localIndex(vertices.size(), NOT_IN_MESHLET);
+    Meshlet meshlet;
+
+    auto close = [&]() {
+        if (meshlet.triangleCount == 0) {
+            return;
+        }
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+            localIndex[buffers.vertices[meshlet.vertexOffset + i]] = NOT_IN_MESHLET;
+        }
+        computeBounds(meshlet, buffers, vertices);
+        buffers.meshlets.push_back(meshlet);
+        // next meshlet's triangles start on a word boundary
+        buffers.triangles.resize((buffers.triangles.size() + 3) & ~size_t(3), 0);
+        meshlet = Meshlet{};
+        meshlet.vertexOffset = static_cast<uint32_t>(buffers.vertices.size());
+        meshlet.triangleOffset = static_cast<uint32_t>(buffers.triangles.size());
+    };
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t *triangle = indices.data() + t * 3;
+        if (triangle[0] >= vertices.size() || triangle[1] >= vertices.size() ||
+            triangle[2] >= vertices.size()) {
+            continue;
+        }
+        uint32_t newVertices = 0;
+        for (int i = 0; i < 3; ++i) {
+            // a vertex repeated within the triangle only counts once
+            newVertices += localIndex[triangle[i]] == NOT_IN_MESHLET &&
+                           (i == 0 || triangle[i] != triangle[0]) &&
+                           (i < 2 || triangle[2] != triangle[1]);
+        }
+        if (meshlet.vertexCount + newVertices > maxVertices ||
+            meshlet.triangleCount + 1 > maxTriangles) {
+            close();
+        }
+        for (int i = 0; i < 3; ++i) {
+            auto &local = localIndex[triangle[i]];
+            if (local == NOT_IN_MESHLET) {
+                local = static_cast<uint8_t>(meshlet.vertexCount++);
+                buffers.vertices.push_back(triangle[i]);
+            }
+            buffers.triangles.push_back(local);
+        }
+        ++meshlet.triangleCount;
+    }
+    close();
+    return buffers;
+}
+
+MeshletFill meshletFill(std::span<const Meshlet> meshlets) {
+    MeshletFill fill;
+    fill.meshlets = meshlets.size();
+    for (const auto &meshlet: meshlets) {
+        fill.vertices += meshlet.vertexCount;
+        fill.triangles += meshlet.triangleCount;
+    }
+    return fill;
+}
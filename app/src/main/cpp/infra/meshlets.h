@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <scene.h>
+
+// meshlet builder for the glb loader: fixed-size clusters of a primitive's triangles,
+// each with a bounding sphere and a backface normal cone for gpu culling
+
+// fits the usual mesh shader limits (nvidia/amd/arm recommend 64 / 124-126)
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+struct MeshletBuffers {
+    std::vector<Meshlet> meshlets;
+    // primitive-local vertex indices
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> triangles;
+};
+
+// greedy scan over the index buffer in its current order (run after the vertex cache
+// optimization: its locality is what fills the meshlets); float vertices, before quantization
+MeshletBuffers buildMeshlets(std::span<const uint32_t> indices, std::span<const Vertex> vertices,
+                             uint32_t maxVertices = MESHLET_MAX_VERTICES,
+                             uint32_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+struct MeshletFill {
+    size_t meshlets{0};
+    size_t vertices{0};
+    size_t triangles{0};
+};
+
+// average fill = vertices / (meshlets * maxVertices), triangles / (meshlets * maxTriangles)
+MeshletFill meshletFill(std::span<const Meshlet> meshlets);
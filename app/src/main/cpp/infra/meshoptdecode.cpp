@@ -0,0 +1,596 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#include <meshoptdecode.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MESHOPT_DECODE_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MESHOPT_DECODE_NEON 1
+#endif
+
+// bitstream constants, see meshoptimizer's vertexcodec.cpp / indexcodec.cpp
+namespace {
+constexpr uint8_t VERTEX_HEADER = 0xa0;
+constexpr uint8_t INDEX_HEADER = 0xe0;
+constexpr uint8_t SEQUENCE_HEADER = 0xd0;
+
+constexpr size_t BYTE_GROUP_SIZE = 16;
+// a byte group never reads more than this, the >= 32 byte tail keeps valid streams inside it
+constexpr size_t BYTE_GROUP_DECODE_LIMIT = 24;
+constexpr size_t VERTEX_BLOCK_SIZE_BYTES = 8192;
+constexpr size_t VERTEX_BLOCK_MAX_SIZE = 256;
+constexpr size_t TAIL_MAX_SIZE = 32;
+
+inline size_t vertexBlockSize(size_t stride) {
+    const size_t result = (VERTEX_BLOCK_SIZE_BYTES / stride) & ~(BYTE_GROUP_SIZE - 1);
+    return std::min(result, VERTEX_BLOCK_MAX_SIZE);
+}
+
+// 2-bit codes of one packed byte, most significant bits first
+struct UnpackTable {
+    uint8_t codes[256][4];
+
+    UnpackTable() {
+        for (int b = 0; b < 256; ++b) {
+            for (int i = 0; i < 4; ++i) {
+                codes[b][i] = static_cast<uint8_t>((b >> (6 - 2 * i)) & 3);
+            }
+        }
+    }
+};
+
+const UnpackTable UNPACK_BITS2;
+
+// bit i set: buffer[i] == escape
+inline uint32_t escapeMask(const uint8_t *buffer, uint8_t escape) {
+#if defined(MESHOPT_DECODE_SSE2)
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer));
+    return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(char(escape)))));
+#elif defined(MESHOPT_DECODE_NEON)
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vandq_u8(vceqq_u8(vld1q_u8(buffer), vdupq_n_u8(escape)),
+                                     vld1q_u8(weights));
+    return uint32_t(vaddv_u8(vget_low_u8(bits))) | uint32_t(vaddv_u8(vget_high_u8(bits))) << 8;
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < BYTE_GROUP_SIZE; ++i) {
+        mask |= uint32_t(buffer[i] == escape) << i;
+    }
+    return mask;
+#endif
+}
+
+// 16 values of 0, 2, 4 or 8 bits; 2/4-bit values at their maximum escape to a trailing byte
+const uint8_t *decodeBytesGroup(const uint8_t *data, uint8_t *buffer, int bitsLog2) {
+    if (bitsLog2 == 0) {
+        memset(buffer, 0, BYTE_GROUP_SIZE);
+        return data;
+    }
+    if (bitsLog2 == 3) {
+        memcpy(buffer, data, BYTE_GROUP_SIZE);
+        return data + BYTE_GROUP_SIZE;
+    }
+    size_t packedBytes;
+    uint8_t escape;
+    if (bitsLog2 == 1) {
+        packedBytes = 4;
+        escape = 3;
+        for (size_t i = 0; i < packedBytes; ++i) {
+            memcpy(buffer + i * 4, UNPACK_BITS2.codes[data[i]], 4);
+        }
+    } else {
+        packedBytes = 8;
+        escape = 15;
+#if defined(MESHOPT_DECODE_SSE2)
+        const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(data));
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+        const __m128i lo = _mm_and_si128(v, nibble);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), _mm_unpacklo_epi8(hi, lo));
+#elif defined(MESHOPT_DECODE_NEON)
+        const uint8x8_t v = vld1_u8(data);
+        const uint8x8_t hi = vshr_n_u8(v, 4);
+        const uint8x8_t lo = vand_u8(v, vdup_n_u8(0x0f));
+        vst1q_u8(buffer, vcombine_u8(vzip1_u8(hi, lo), vzip2_u8(hi, lo)));
+#else
+        for (size_t i = 0; i < packedBytes; ++i) {
+            buffer[i * 2] = data[i] >> 4;
+            buffer[i * 2 + 1] = data[i] & 15;
+        }
+#endif
+    }
+    // escaped values follow the packed codes in order
+    const uint8_t *extra = data + packedBytes;
+    for (uint32_t mask = escapeMask(buffer, escape); mask != 0; mask &= mask - 1) {
+        buffer[std::countr_zero(mask)] = *extra++;
+    }
+    return extra;
+}
+
+const uint8_t *decodeBytes(const uint8_t *data, const uint8_t *dataEnd, uint8_t *buffer,
+                           size_t size) {
+    // 2 bits of mode per group, groups rounded up to whole header bytes
+    const uint8_t *header = data;
+    const size_t headerSize = (size / BYTE_GROUP_SIZE + 3) / 4;
+    if (size_t(dataEnd - data) < headerSize) {
+        return nullptr;
+    }
+    data += headerSize;
+    for (size_t i = 0; i < size; i += BYTE_GROUP_SIZE) {
+        if (size_t(dataEnd - data) < BYTE_GROUP_DECODE_LIMIT) {
+            return nullptr;
+        }
+        const size_t group = i / BYTE_GROUP_SIZE;
+        const int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+        data = decodeBytesGroup(data, buffer + i, bitsLog2);
+    }
+    return data;
+}
+
+// zigzag deltas -> running sum seeded with last, 16 lanes at a time
+// returns the sum of the last lane, the seed of the next group
+inline uint8_t unzigzagPrefixSum(const uint8_t *deltas, uint8_t last, uint8_t *out) {
+#if defined(MESHOPT_DECODE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(deltas));
+    // (v >> 1) ^ -(v & 1), sse2 has no 8-bit shift
+    const __m128i half = _mm_and_si128(_mm_srli_epi16(v, 1), _mm_set1_epi8(0x7f));
+    const __m128i sign = _mm_sub_epi8(zero, _mm_and_si128(v, _mm_set1_epi8(1)));
+    v = _mm_xor_si128(half, sign);
+    // log-step inclusive scan
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+    v = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(last)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+#elif defined(MESHOPT_DECODE_NEON)
+    const uint8x16_t zero = vdupq_n_u8(0);
+    uint8x16_t v = vld1q_u8(deltas);
+    const uint8x16_t sign = vreinterpretq_u8_s8(
+            vnegq_s8(vreinterpretq_s8_u8(vandq_u8(v, vdupq_n_u8(1)))));
+    v = veorq_u8(vshrq_n_u8(v, 1), sign);
+    // log-step inclusive scan, vext shifts lanes up and pulls zeros in
+    v = vaddq_u8(v, vextq_u8(zero, v, 15));
+    v = vaddq_u8(v, vextq_u8(zero, v, 14));
+    v = vaddq_u8(v, vextq_u8(zero, v, 12));
+    v = vaddq_u8(v, vextq_u8(zero, v, 8));
+    v = vaddq_u8(v, vdupq_n_u8(last));
+    vst1q_u8(out, v);
+#else
+    for (size_t i = 0; i < BYTE_GROUP_SIZE; ++i) {
+        const uint8_t delta = static_cast<uint8_t>((deltas[i] >> 1) ^ -(deltas[i] & 1));
+        last = static_cast<uint8_t>(last + delta);
+        out[i] = last;
+    }
+#endif
+    return out[BYTE_GROUP_SIZE - 1];
+}
+
+// 4 channel rows of 16 bytes (pitch apart) -> 16 interleaved 4-byte quads
+inline void interleaveChannels(const uint8_t *channels, size_t pitch, uint8_t *quads) {
+#if defined(MESHOPT_DECODE_SSE2)
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(channels));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(channels + pitch));
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(channels + pitch * 2));
+    const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(channels + pitch * 3));
+    const __m128i abLo = _mm_unpacklo_epi8(a, b);
+    const __m128i abHi = _mm_unpackhi_epi8(a, b);
+    const __m128i cdLo = _mm_unpacklo_epi8(c, d);
+    const __m128i cdHi = _mm_unpackhi_epi8(c, d);
+    auto *out = reinterpret_cast<__m128i *>(quads);
+    _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(abLo, cdLo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(abLo, cdLo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(abHi, cdHi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(abHi, cdHi));
+#elif defined(MESHOPT_DECODE_NEON)
+    uint8x16x4_t v;
+    v.val[0] = vld1q_u8(channels);
+    v.val[1] = vld1q_u8(channels + pitch);
+    v.val[2] = vld1q_u8(channels + pitch * 2);
+    v.val[3] = vld1q_u8(channels + pitch * 3);
+    vst4q_u8(quads, v);
+#else
+    for (size_t i = 0; i < BYTE_GROUP_SIZE; ++i) {
+        for (size_t k = 0; k < 4; ++k) {
+            quads[i * 4 + k] = channels[k * pitch + i];
+        }
+    }
+#endif
+}
+
+// one block: every byte channel of the vertices is stored as its own delta stream
+const uint8_t *decodeVertexBlock(const uint8_t *data, const uint8_t *dataEnd, uint8_t *dst,
+                                 size_t count, size_t stride, uint8_t *lastVertex) {
+    uint8_t deltas[VERTEX_BLOCK_MAX_SIZE];
+    // channel k of vertex i at [k * VERTEX_BLOCK_MAX_SIZE + i], a block is at most 8 KB
+    uint8_t transposed[VERTEX_BLOCK_SIZE_BYTES];
+    const size_t alignedCount = (count + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+    const size_t channelPitch = VERTEX_BLOCK_SIZE_BYTES / stride;
+    for (size_t k = 0; k < stride; ++k) {
+        data = decodeBytes(data, dataEnd, deltas, alignedCount);
+        if (!data) {
+            return nullptr;
+        }
+        uint8_t *values = transposed + k * channelPitch;
+        uint8_t last = lastVertex[k];
+        for (size_t i = 0; i < alignedCount; i += BYTE_GROUP_SIZE) {
+            last = unzigzagPrefixSum(deltas + i, last, values + i);
+        }
+        lastVertex[k] = values[count - 1];
+    }
+    // interleave back 4 channels x 16 vertices at a time, stride is a multiple of 4
+    size_t i = 0;
+    for (; i + BYTE_GROUP_SIZE <= count; i += BYTE_GROUP_SIZE) {
+        for (size_t k = 0; k < stride; k += 4) {
+            uint8_t quads[BYTE_GROUP_SIZE * 4];
+            interleaveChannels(transposed + k * channelPitch + i, channelPitch, quads);
+            for (size_t j = 0; j < BYTE_GROUP_SIZE; ++j) {
+                memcpy(dst + (i + j) * stride + k, quads + j * 4, 4);
+            }
+        }
+    }
+    for (; i < count; ++i) {
+        for (size_t k = 0; k < stride; ++k) {
+            dst[i * stride + k] = transposed[k * channelPitch + i];
+        }
+    }
+    return data;
+}
+
+inline uint32_t decodeVByte(const uint8_t *&data) {
+    const uint8_t lead = *data++;
+    if (lead < 128) {
+        return lead;
+    }
+    // 7 bits per byte, up to 5 bytes
+    uint32_t result = lead & 127;
+    uint32_t shift = 7;
+    for (int i = 0; i < 4; ++i) {
+        const uint8_t group = *data++;
+        result |= uint32_t(group & 127) << shift;
+        shift += 7;
+        if (group < 128) {
+            break;
+        }
+    }
+    return result;
+}
+
+inline uint32_t decodeIndex(const uint8_t *&data, uint32_t last) {
+    const uint32_t v = decodeVByte(data);
+    const uint32_t delta = (v >> 1) ^ (0U - (v & 1));
+    return last + delta;
+}
+
+inline void writeIndex(std::byte *dst, size_t i, size_t indexSize, uint32_t index) {
+    if (indexSize == 2) {
+        const auto index16 = static_cast<uint16_t>(index);
+        memcpy(dst + i * 2, &index16, sizeof(index16));
+    } else {
+        memcpy(dst + i * 4, &index, sizeof(index));
+    }
+}
+
+// the fifos have to be updated exactly like the encoder does it
+struct IndexDecodeState {
+    uint32_t edgeFifo[16][2];
+    uint32_t vertexFifo[16];
+    size_t edgeOffset{0};
+    size_t vertexOffset{0};
+
+    IndexDecodeState() {
+        memset(edgeFifo, -1, sizeof(edgeFifo));
+        memset(vertexFifo, -1, sizeof(vertexFifo));
+    }
+
+    inline void pushEdge(uint32_t a, uint32_t b) {
+        edgeFifo[edgeOffset][0] = a;
+        edgeFifo[edgeOffset][1] = b;
+        edgeOffset = (edgeOffset + 1) & 15;
+    }
+
+    inline void pushVertex(uint32_t v, bool advance = true) {
+        vertexFifo[vertexOffset] = v;
+        vertexOffset = (vertexOffset + advance) & 15;
+    }
+
+    // recent entries are counted back from the write position
+    inline uint32_t vertex(size_t back) const {
+        return vertexFifo[(vertexOffset - back) & 15];
+    }
+};
+
+template<typename T>
+void octahedralFilter(T *data, size_t count) {
+    const float one = float((1 << (sizeof(T) * 8 - 1)) - 1);
+    for (size_t i = 0; i < count; ++i) {
+        // the third component holds the encoded 1.0, z is rebuilt from it
+        float x = float(data[i * 4 + 0]);
+        float y = float(data[i * 4 + 1]);
+        const float z = float(data[i * 4 + 2]) - std::fabs(x) - std::fabs(y);
+        // fold back the lower hemisphere
+        const float t = z < 0.0f ? z : 0.0f;
+        x += x >= 0.0f ? t : -t;
+        y += y >= 0.0f ? t : -t;
+        const float scale = one / std::sqrt(x * x + y * y + z * z);
+        data[i * 4 + 0] = T(int(x * scale + (x >= 0.0f ? 0.5f : -0.5f)));
+        data[i * 4 + 1] = T(int(y * scale + (y >= 0.0f ? 0.5f : -0.5f)));
+        data[i * 4 + 2] = T(int(z * scale + (z >= 0.0f ? 0.5f : -0.5f)));
+    }
+}
+
+void quaternionFilter(int16_t *data, size_t count) {
+    const float scale = 1.0f / std::sqrt(2.0f);
+    for (size_t i = 0; i < count; ++i) {
+        int16_t *q = data + i * 4;
+        // three smallest components, the fourth slot carries scale bits + the dropped index
+        const float s = scale / float(q[3] | 3);
+        const float x = float(q[0]) * s;
+        const float y = float(q[1]) * s;
+        const float z = float(q[2]) * s;
+        const float ww = 1.0f - x * x - y * y - z * z;
+        const float w = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+        const int dropped = q[3] & 3;
+        const auto xf = int16_t(int(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f)));
+        const auto yf = int16_t(int(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f)));
+        const auto zf = int16_t(int(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f)));
+        const auto wf = int16_t(int(w * 32767.0f + 0.5f));
+        q[(dropped + 1) & 3] = xf;
+        q[(dropped + 2) & 3] = yf;
+        q[(dropped + 3) & 3] = zf;
+        q[dropped] = wf;
+    }
+}
+
+// 24-bit mantissa, 8-bit exponent -> float, count 32-bit words
+void exponentialFilter(uint32_t *data, size_t count) {
+    size_t i = 0;
+#if defined(MESHOPT_DECODE_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i m = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+        const __m128i e = _mm_srai_epi32(v, 24);
+        // 2^e built directly in the exponent bits
+        const __m128 p = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127)), 23));
+        _mm_storeu_ps(reinterpret_cast<float *>(data + i), _mm_mul_ps(p, _mm_cvtepi32_ps(m)));
+    }
+#elif defined(MESHOPT_DECODE_NEON)
+    for (; i + 4 <= count; i += 4) {
+        const int32x4_t v = vreinterpretq_s32_u32(vld1q_u32(data + i));
+        const int32x4_t m = vshrq_n_s32(vshlq_n_s32(v, 8), 8);
+        const int32x4_t e = vshrq_n_s32(v, 24);
+        // 2^e built directly in the exponent bits
+        const float32x4_t p = vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(e, vdupq_n_s32(127)), 23));
+        vst1q_f32(reinterpret_cast<float *>(data + i), vmulq_f32(p, vcvtq_f32_s32(m)));
+    }
+#endif
+    for (; i < count; ++i) {
+        const int32_t m = int32_t(data[i] << 8) >> 8;
+        const int32_t e = int32_t(data[i]) >> 24;
+        const uint32_t bits = uint32_t(e + 127) << 23;
+        float p;
+        memcpy(&p, &bits, sizeof(p));
+        p *= float(m);
+        memcpy(data + i, &p, sizeof(p));
+    }
+}
+}
+
+bool decodeMeshoptVertexBuffer(std::span<const std::byte> src, size_t count, size_t stride,
+                               std::byte *dst) {
+    if (stride == 0 || stride > VERTEX_BLOCK_MAX_SIZE || stride % 4 != 0 ||
+        src.size() < 1 + stride) {
+        return false;
+    }
+    const auto *data = reinterpret_cast<const uint8_t *>(src.data());
+    const uint8_t *dataEnd = data + src.size();
+    // only version 0 exists in EXT_meshopt_compression
+    if (*data++ != VERTEX_HEADER) {
+        return false;
+    }
+    // the tail holds the first vertex, deltas of the first block are taken against it
+    uint8_t lastVertex[VERTEX_BLOCK_MAX_SIZE];
+    memcpy(lastVertex, dataEnd - stride, stride);
+
+    auto *vertices = reinterpret_cast<uint8_t *>(dst);
+    const size_t blockSize = vertexBlockSize(stride);
+    for (size_t offset = 0; offset < count; offset += blockSize) {
+        const size_t size = std::min(blockSize, count - offset);
+        data = decodeVertexBlock(data, dataEnd, vertices + offset * stride, size, stride,
+                                 lastVertex);
+        if (!data) {
+            return false;
+        }
+    }
+    return size_t(dataEnd - data) == std::max(stride, TAIL_MAX_SIZE);
+}
+
+bool decodeMeshoptIndexBuffer(std::span<const std::byte> src, size_t count, size_t indexSize,
+                              std::byte *dst) {
+    // header, one code byte per triangle, 16-byte codeaux table at the end
+    if (count % 3 != 0 || (indexSize != 2 && indexSize != 4) ||
+        src.size() < 1 + count / 3 + 16) {
+        return false;
+    }
+    const auto *buffer = reinterpret_cast<const uint8_t *>(src.data());
+    if ((buffer[0] & 0xf0) != INDEX_HEADER || (buffer[0] & 0x0f) > 1) {
+        return false;
+    }
+    const int version = buffer[0] & 0x0f;
+    // v1 spends fec 13/14 on +-1 deltas of the last free index
+    const int fecMax = version >= 1 ? 13 : 15;
+
+    IndexDecodeState state;
+    uint32_t next = 0;
+    uint32_t last = 0;
+    const uint8_t *code = buffer + 1;
+    const uint8_t *data = code + count / 3;
+    const uint8_t *dataSafeEnd = buffer + src.size() - 16;
+    const uint8_t *codeauxTable = dataSafeEnd;
+
+    for (size_t i = 0; i < count; i += 3) {
+        // a triangle reads at most 16 bytes, the codeaux table keeps that inside the buffer
+        if (data > dataSafeEnd) {
+            return false;
+        }
+        const uint8_t codeTri = *code++;
+        if (codeTri < 0xf0) {
+            // edge from the fifo + a third vertex
+            const int fe = codeTri >> 4;
+            const uint32_t a = state.edgeFifo[(state.edgeOffset - 1 - fe) & 15][0];
+            const uint32_t b = state.edgeFifo[(state.edgeOffset - 1 - fe) & 15][1];
+            const int fec = codeTri & 15;
+            uint32_t c;
+            bool advance = true;
+            if (fec < fecMax) {
+                c = fec == 0 ? next : state.vertex(1 + fec);
+                next += fec == 0;
+                advance = fec == 0;
+            } else {
+                // 13, 14 -> -1, +1; 15: explicit index
+                c = last = fec != 15 ? last + (fec - (fec ^ 3)) : decodeIndex(data, last);
+            }
+            writeIndex(dst, i + 0, indexSize, a);
+            writeIndex(dst, i + 1, indexSize, b);
+            writeIndex(dst, i + 2, indexSize, c);
+            state.pushVertex(c, advance);
+            state.pushEdge(c, b);
+            state.pushEdge(a, c);
+        } else if (codeTri < 0xfe) {
+            // all three vertices new or from the vertex fifo, codes from the table
+            const uint8_t codeAux = codeauxTable[codeTri & 15];
+            const int feb = codeAux >> 4;
+            const int fec = codeAux & 15;
+            const uint32_t a = next++;
+            const uint32_t b = feb == 0 ? next : state.vertex(feb);
+            next += feb == 0;
+            const uint32_t c = fec == 0 ? next : state.vertex(fec);
+            next += fec == 0;
+            writeIndex(dst, i + 0, indexSize, a);
+            writeIndex(dst, i + 1, indexSize, b);
+            writeIndex(dst, i + 2, indexSize, c);
+            state.pushVertex(a);
+            state.pushVertex(b, feb == 0);
+            state.pushVertex(c, fec == 0);
+            state.pushEdge(b, a);
+            state.pushEdge(c, b);
+            state.pushEdge(a, c);
+        } else {
+            // same with a full codeaux byte, explicit indices allowed
+            const uint8_t codeAux = *data++;
+            const int fea = codeTri == 0xfe ? 0 : 15;
+            const int feb = codeAux >> 4;
+            const int fec = codeAux & 15;
+            // codeaux 0 outside the table: restart the new vertex counter
+            if (codeAux == 0) {
+                next = 0;
+            }
+            uint32_t a = fea == 0 ? next++ : 0;
+            uint32_t b = feb == 0 ? next++ : state.vertex(feb);
+            uint32_t c = fec == 0 ? next++ : state.vertex(fec);
+            if (fea == 15) {
+                last = a = decodeIndex(data, last);
+            }
+            if (feb == 15) {
+                last = b = decodeIndex(data, last);
+            }
+            if (fec == 15) {
+                last = c = decodeIndex(data, last);
+            }
+            writeIndex(dst, i + 0, indexSize, a);
+            writeIndex(dst, i + 1, indexSize, b);
+            writeIndex(dst, i + 2, indexSize, c);
+            state.pushVertex(a);
+            state.pushVertex(b, feb == 0 || feb == 15);
+            state.pushVertex(c, fec == 0 || fec == 15);
+            state.pushEdge(b, a);
+            state.pushEdge(c, b);
+            state.pushEdge(a, c);
+        }
+    }
+    // everything up to the codeaux table has to be consumed
+    return data == dataSafeEnd;
+}
+
+bool decodeMeshoptIndexSequence(std::span<const std::byte> src, size_t count, size_t indexSize,
+                                std::byte *dst) {
+    // header, at least a byte per index, 4-byte tail
+    if ((indexSize != 2 && indexSize != 4) || src.size() < 1 + count + 4) {
+        return false;
+    }
+    const auto *buffer = reinterpret_cast<const uint8_t *>(src.data());
+    if ((buffer[0] & 0xf0) != SEQUENCE_HEADER || (buffer[0] & 0x0f) > 1) {
+        return false;
+    }
+    const uint8_t *data = buffer + 1;
+    const uint8_t *dataSafeEnd = buffer + src.size() - 4;
+    // two baselines, the low bit of each code picks one
+    uint32_t last[2] = {0, 0};
+    for (size_t i = 0; i < count; ++i) {
+        // a vbyte reads at most 5 bytes, the tail keeps that inside the buffer
+        if (data >= dataSafeEnd) {
+            return false;
+        }
+        uint32_t v = decodeVByte(data);
+        const uint32_t baseline = v & 1;
+        v >>= 1;
+        const uint32_t delta = (v >> 1) ^ (0U - (v & 1));
+        last[baseline] += delta;
+        writeIndex(dst, i, indexSize, last[baseline]);
+    }
+    return data == dataSafeEnd;
+}
+
+bool applyMeshoptFilter(MeshoptFilter filter, size_t count, size_t stride, std::byte *data) {
+    switch (filter) {
+        case MESHOPT_FILTER_NONE:
+            return true;
+        case MESHOPT_FILTER_OCTAHEDRAL:
+            // snorm8x4 or snorm16x4
+            if (stride == 4) {
+                octahedralFilter(reinterpret_cast<int8_t *>(data), count);
+                return true;
+            }
+            if (stride == 8) {
+                octahedralFilter(reinterpret_cast<int16_t *>(data), count);
+                return true;
+            }
+            return false;
+        case MESHOPT_FILTER_QUATERNION:
+            if (stride != 8) {
+                return false;
+            }
+            quaternionFilter(reinterpret_cast<int16_t *>(data), count);
+            return true;
+        case MESHOPT_FILTER_EXPONENTIAL:
+            if (stride % 4 != 0) {
+                return false;
+            }
+            exponentialFilter(reinterpret_cast<uint32_t *>(data), count * stride / 4);
+            return true;
+    }
+    return false;
+}
+
+bool decodeMeshoptBufferView(std::span<const std::byte> src, MeshoptMode mode,
+                             MeshoptFilter filter, size_t count, size_t stride, std::byte *dst) {
+    switch (mode) {
+        case MESHOPT_MODE_ATTRIBUTES:
+            return decodeMeshoptVertexBuffer(src, count, stride, dst) &&
+                   applyMeshoptFilter(filter, count, stride, dst);
+        // filters only apply to attributes
+        case MESHOPT_MODE_TRIANGLES:
+            return filter == MESHOPT_FILTER_NONE &&
+                   decodeMeshoptIndexBuffer(src, count, stride, dst);
+        case MESHOPT_MODE_INDICES:
+            return filter == MESHOPT_FILTER_NONE &&
+                   decodeMeshoptIndexSequence(src, count, stride, dst);
+    }
+    return false;
+}
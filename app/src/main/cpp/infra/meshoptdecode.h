@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// EXT_meshopt_compression buffer view decoding: meshoptimizer vertex codec (v0), index codec
+// (v0/v1), index sequence codec (v1) and the three attribute filters
+// https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Vendor/EXT_meshopt_compression
+// every decoder writes exactly count * stride bytes and returns false on a malformed stream
+
+enum MeshoptMode : int
+{
+    MESHOPT_MODE_ATTRIBUTES = 0,
+    MESHOPT_MODE_TRIANGLES,
+    MESHOPT_MODE_INDICES
+};
+
+enum MeshoptFilter : int
+{
+    MESHOPT_FILTER_NONE = 0,
+    MESHOPT_FILTER_OCTAHEDRAL,
+    MESHOPT_FILTER_QUATERNION,
+    MESHOPT_FILTER_EXPONENTIAL
+};
+
+// stride: multiple of 4, at most 256
+bool decodeMeshoptVertexBuffer(std::span<const std::byte> src, size_t count, size_t stride,
+                               std::byte *dst);
+
+// triangle list, count a multiple of 3, indexSize 2 or 4
+bool decodeMeshoptIndexBuffer(std::span<const std::byte> src, size_t count, size_t indexSize,
+                              std::byte *dst);
+
+// any index stream (strips, lists without triangle structure), indexSize 2 or 4
+bool decodeMeshoptIndexSequence(std::span<const std::byte> src, size_t count, size_t indexSize,
+                                std::byte *dst);
+
+// reverses an encode-time filter in place on count elements of stride bytes
+bool applyMeshoptFilter(MeshoptFilter filter, size_t count, size_t stride, std::byte *data);
+
+// mode dispatch followed by the filter: one compressed buffer view -> its plain bytes
+bool decodeMeshoptBufferView(std::span<const std::byte> src, MeshoptMode mode,
+                             MeshoptFilter filter, size_t count, size_t stride, std::byte *dst);
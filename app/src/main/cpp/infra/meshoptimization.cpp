@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include <meshoptimization.h>
+
+// fifo post-transform cache simulated with insertion timestamps: a vertex is still cached
+// while fewer than cacheSize misses happened after it was inserted
+namespace {
+class FifoCache {
+public:
+    FifoCache(size_t vertexCount, uint32_t cacheSize)
+            : _timestamps(vertexCount, 0), _cacheSize(cacheSize), _timestamp(cacheSize + 1) {}
+
+    // true on a miss, the vertex is (re)inserted
+    inline bool access(uint32_t vertex) {
+        if (_timestamp - _timestamps[vertex] > _cacheSize) {
+            _timestamps[vertex] = _timestamp++;
+            return true;
+        }
+        return false;
+    }
+
+    inline uint32_t misses(const uint32_t *triangle) {
+        return uint32_t(access(triangle[0])) + uint32_t(access(triangle[1])) +
+               uint32_t(access(triangle[2]));
+    }
+
+    // age in misses, > cacheSize: not cached
+    inline uint32_t age(uint32_t vertex) const {
+        return _timestamp - _timestamps[vertex];
+    }
+
+    // evicts everything without touching the per-vertex state
+    inline void flush() {
+        _timestamp += _cacheSize + 1;
+    }
+
+private:
+    std::vector<uint32_t> _timestamps;
+    uint32_t _cacheSize;
+    uint32_t _timestamp;
+};
+}
+
+MeshStats analyzeMesh(std::span<const uint32_t> indices, size_t vertexCount, size_t vertexStride) {
+    MeshStats stats;
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0) {
+        return stats;
+    }
+    // fetch: direct-mapped cache of 128 x 64-byte lines, only transformed vertices are fetched
+    constexpr size_t LINE_SIZE = 64;
+    std::array<size_t, 128> lines;
+    lines.fill(SIZE_MAX);
+    size_t fetchedBytes = 0;
+
+    FifoCache cache(vertexCount, MESH_OPT_CACHE_SIZE);
+    std::vector<bool> referenced(vertexCount, false);
+    size_t referencedCount = 0;
+    size_t misses = 0;
+    for (const auto index: indices) {
+        if (index >= vertexCount) {
+            continue;
+        }
+        if (!referenced[index]) {
+            referenced[index] = true;
+            ++referencedCount;
+        }
+        if (!cache.access(index)) {
+            continue;
+        }
+        ++misses;
+        const size_t begin = index * vertexStride;
+        const size_t end = begin + vertexStride;
+        for (size_t line = begin / LINE_SIZE; line <= (end - 1) / LINE_SIZE; ++line) {
+            auto &slot = lines[line % lines.size()];
+            if (slot != line) {
+                slot = line;
+                fetchedBytes += LINE_SIZE;
+            }
+        }
+    }
+    stats.acmr = float(misses) / float(triangleCount);
+    stats.atvr = referencedCount ? float(misses) / float(referencedCount) : 0.0f;
+    stats.overfetch = referencedCount ? float(fetchedBytes) / float(referencedCount * vertexStride)
+                                      : 0.0f;
+    return stats;
+}
+
+void weldVertices(Mesh &mesh) {
+    const size_t vertexCount = mesh.vertices.size();
+    if (vertexCount == 0) {
+        return;
+    }
+    const bool hasNormals = mesh.normals.size() == vertexCount * 3;
+    auto hashVertex = [&](size_t v) {
+        // FNV-1a over the vertex bytes (and its normal)
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const void *data, size_t size) {
+            const auto *bytes = static_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < size; ++i) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+        mix(&mesh.vertices[v], sizeof(Vertex));
+        if (hasNormals) {
+            mix(&mesh.normals[v * 3], 3 * sizeof(float));
+        }
+        return hash;
+    };
+    auto sameVertex = [&](size_t a, size_t b) {
+        return memcmp(&mesh.vertices[a], &mesh.vertices[b], sizeof(Vertex)) == 0 &&
+               (!hasNormals ||
+                memcmp(&mesh.normals[a * 3], &mesh.normals[b * 3], 3 * sizeof(float)) == 0);
+    };
+
+    // open addressing over the compacted prefix: slots hold new indices, which are final
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2) {
+        tableSize <<= 1;
+    }
+    std::vector<uint32_t> table(tableSize, UINT32_MAX);
+    std::vector<uint32_t> remap(vertexCount);
+    uint32_t uniqueCount = 0;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        size_t slot = hashVertex(v) & (tableSize - 1);
+        while (table[slot] != UINT32_MAX && !sameVertex(table[slot], v)) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (table[slot] == UINT32_MAX) {
+            // uniqueCount <= v: compacting in place never overwrites an unvisited vertex
+            mesh.vertices[uniqueCount] = mesh.vertices[v];
+            if (hasNormals) {
+                std::copy_n(&mesh.normals[v * 3], 3, &mesh.normals[uniqueCount * 3]);
+            }
+            table[slot] = uniqueCount++;
+        }
+        remap[v] = table[slot];
+    }
+    mesh.vertices.resize(uniqueCount);
+    if (hasNormals) {
+        mesh.normals.resize(size_t(uniqueCount) * 3);
+    }
+    for (auto &index: mesh.indices) {
+        index = remap[index];
+    }
+}
+
+void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0) {
+        return;
+    }
+    // vertex -> triangles adjacency, compressed rows
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++liveTriangles[indices[i]];
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (size_t k = 0; k < 3; ++k) {
+                adjacency[cursor[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+    }
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnds;
+    deadEnds.reserve(triangleCount * 3);
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    size_t inputCursor = 0;
+    int64_t fanning = indices[0];
+    while (fanning >= 0) {
+        // emit the whole fan of the current vertex
+        candidates.clear();
+        for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a) {
+            const uint32_t t = adjacency[a];
+            if (emitted[t]) {
+                continue;
+            }
+            for (size_t k = 0; k < 3; ++k) {
+                const uint32_t v = indices[t * 3 + k];
+                result.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                cache.access(v);
+            }
+            emitted[t] = true;
+        }
+        // next fan: the candidate that is still cached after emitting its remaining fan,
+        // oldest first (it would be evicted soonest)
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (const auto v: candidates) {
+            if (liveTriangles[v] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            const int64_t age = cache.age(v);
+            if (age + 2 * int64_t(liveTriangles[v]) <= int64_t(cacheSize)) {
+                priority = age;
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+        if (next < 0) {
+            // dead end: most recently referenced vertex with work left, else input order
+            while (!deadEnds.empty()) {
+                const uint32_t v = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveTriangles[v] > 0) {
+                    next = v;
+                    break;
+                }
+            }
+            if (next < 0) {
+                while (inputCursor < vertexCount && liveTriangles[inputCursor] == 0) {
+                    ++inputCursor;
+                }
+                next = inputCursor < vertexCount ? int64_t(inputCursor) : -1;
+            }
+        }
+        fanning = next;
+    }
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void optimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices,
+                      float threshold) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+    // hard boundaries: a triangle missing on all three vertices restarts the cache anyway
+    FifoCache cache(vertices.size(), MESH_OPT_CACHE_SIZE);
+    std::vector<uint32_t> hardBoundaries{0};
+    cache.misses(&indices[0]);
+    for (size_t t = 1; t < triangleCount; ++t) {
+        if (cache.misses(&indices[t * 3]) == 3) {
+            hardBoundaries.push_back(static_cast<uint32_t>(t));
+        }
+    }
+    hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+    // soft boundaries: split a hard cluster wherever its running acmr is already within
+    // threshold of the whole cluster's, smaller clusters sort better
+    std::vector<uint32_t> clusters;
+    for (size_t c = 0; c + 1 < hardBoundaries.size(); ++c) {
+        const uint32_t start = hardBoundaries[c];
+        const uint32_t end = hardBoundaries[c + 1];
+        cache.flush();
+        size_t clusterMisses = 0;
+        for (uint32_t t = start; t < end; ++t) {
+            clusterMisses += cache.misses(&indices[t * 3]);
+        }
+        const float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+        cache.flush();
+        clusters.push_back(start);
+        uint32_t runStart = start;
+        size_t runMisses = 0;
+        for (uint32_t t = start; t < end; ++t) {
+            runMisses += cache.misses(&indices[t * 3]);
+            if (t + 1 < end && float(runMisses) / float(t - runStart + 1) <= clusterThreshold) {
+                clusters.push_back(t + 1);
+                runStart = t + 1;
+                runMisses = 0;
+                cache.flush();
+            }
+        }
+    }
+    clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+    // area weighted centroid and normal per cluster
+    auto position = [&](uint32_t v) {
+        return std::array<float, 3>{vertices[v].vx, vertices[v].vy, vertices[v].vz};
+    };
+    const size_t clusterCount = clusters.size() - 1;
+    std::vector<std::array<float, 7>> clusterData(clusterCount); // centroid, normal, area
+    float meshCentroid[3] = {0, 0, 0};
+    float meshArea = 0;
+    for (size_t c = 0; c < clusterCount; ++c) {
+        auto &data = clusterData[c];
+        data.fill(0.0f);
+        for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const auto p0 = position(indices[t * 3]);
+            const auto p1 = position(indices[t * 3 + 1]);
+            const auto p2 = position(indices[t * 3 + 2]);
+            const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            const float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+                                e1[0] * e2[1] - e1[1] * e2[0]};
+            const float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (size_t k = 0; k < 3; ++k) {
+                data[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * area;
+                data[3 + k] += n[k];
+            }
+            data[6] += area;
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            meshCentroid[k] += data[k];
+        }
+        meshArea += data[6];
+    }
+    if (meshArea <= 0.0f) {
+        return;
+    }
+    for (auto &k: meshCentroid) {
+        k /= meshArea;
+    }
+
+    // clusters pointing away from the center are likely in front of the rest: draw them first
+    std::vector<float> sortKeys(clusterCount, 0.0f);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        const auto &data = clusterData[c];
+        if (data[6] <= 0.0f) {
+            continue;
+        }
+        const float nl = std::sqrt(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+        if (nl <= 0.0f) {
+            continue;
+        }
+        float key = 0.0f;
+        for (size_t k = 0; k < 3; ++k) {
+            key += (data[k] / data[6] - meshCentroid[k]) * data[3 + k] / nl;
+        }
+        sortKeys[c] = key;
+    }
+    std::vector<uint32_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        order[c] = static_cast<uint32_t>(c);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+    for (const auto c: order) {
+        result.insert(result.end(), indices.begin() + clusters[c] * 3,
+                      indices.begin() + clusters[c + 1] * 3);
+    }
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+void optimizeVertexFetch(Mesh &mesh) {
+    const size_t vertexCount = mesh.vertices.size();
+    const bool hasNormals = mesh.normals.size() == vertexCount * 3;
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    uint32_t next = 0;
+    for (auto &index: mesh.indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+    std::vector<Vertex> vertices(next);
+    std::vector<float> normals(hasNormals ? size_t(next) * 3 : 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (remap[v] == UINT32_MAX) {
+            continue;
+        }
+        vertices[remap[v]] = mesh.vertices[v];
+        if (hasNormals) {
+            std::copy_n(&mesh.normals[v * 3], 3, &normals[size_t(remap[v]) * 3]);
+        }
+    }
+    mesh.vertices = std::move(vertices);
+    mesh.normals = std::move(normals);
+}
+
+MeshOptimizationReport optimizeMesh(Mesh &mesh, size_t vertexStride) {
+    MeshOptimizationReport report;
+    report.verticesBefore = mesh.vertices.size();
+    report.before = analyzeMesh(mesh.indices, mesh.vertices.size(), vertexStride);
+    const bool valid = !mesh.indices.empty() && mesh.indices.size() % 3 == 0 &&
+                       std::all_of(mesh.indices.begin(), mesh.indices.end(),
+                                   [&](uint32_t index) { return index < mesh.vertices.size(); });
+    if (valid) {
+        weldVertices(mesh);
+        optimizeVertexCache(mesh.indices, mesh.vertices.size(), MESH_OPT_CACHE_SIZE);
+        optimizeOverdraw(mesh.indices, mesh.vertices, 1.05f);
+        optimizeVertexFetch(mesh);
+    }
+    report.verticesAfter = mesh.vertices.size();
+    report.after = analyzeMesh(mesh.indices, mesh.vertices.size(), vertexStride);
+    return report;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <scene.h>
+
+// offline-style mesh optimization for the glb loader
+// runs per primitive on float vertices, before quantization; the cooked scene keeps the result
+
+// post-transform cache entries assumed by the optimizer and by the stats (mobile gpus: 16-32)
+constexpr uint32_t MESH_OPT_CACHE_SIZE = 16;
+
+struct MeshStats {
+    // average cache miss ratio: transformed vertices per triangle, 0.5 is the lower bound
+    float acmr{0};
+    // average transformed to vertex ratio, 1.0 is optimal
+    float atvr{0};
+    // bytes pulled through 64-byte cache lines / bytes of referenced vertices, 1.0 is optimal
+    float overfetch{0};
+};
+
+struct MeshOptimizationReport {
+    size_t verticesBefore{0};
+    size_t verticesAfter{0};
+    MeshStats before;
+    MeshStats after;
+};
+
+// fifo post-transform cache of MESH_OPT_CACHE_SIZE + a small vertex fetch cache
+MeshStats analyzeMesh(std::span<const uint32_t> indices, size_t vertexCount, size_t vertexStride);
+
+// merges bit-identical vertices (normals included when present), rewrites indices
+void weldVertices(Mesh &mesh);
+
+// tipsify (Sander et al. 2007): triangle order for a post-transform cache of cacheSize
+void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount, uint32_t cacheSize);
+
+// splits an already cache-optimized triangle order into clusters and draws the ones facing
+// away from the mesh center first (view independent); a cluster may cost up to threshold x
+// its own acmr, so the cache order mostly survives
+void optimizeOverdraw(std::span<uint32_t> indices, std::span<const Vertex> vertices,
+                      float threshold);
+
+// vertex order = first use in the index buffer, unreferenced vertices are dropped
+void optimizeVertexFetch(Mesh &mesh);
+
+// weld, vertex cache, overdraw, fetch; stats use vertexStride (the uploaded layout)
+MeshOptimizationReport optimizeMesh(Mesh &mesh, size_t vertexStride);
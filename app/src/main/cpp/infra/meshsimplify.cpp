@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <meshoptimization.h>
+#include <meshsimplify.h>
+
+namespace {
+// sum of squared distances to a set of area weighted planes
+struct Quadric {
+    double a2{0}, b2{0}, c2{0}, ab{0}, ac{0}, bc{0}, ad{0}, bd{0}, cd{0}, d2{0};
+    double weight{0};
+
+    void addPlane(double a, double b, double c, double d, double w) {
+        a2 += w * a * a;
+        b2 += w * b * b;
+        c2 += w * c * c;
+        ab += w * a * b;
+        ac += w * a * c;
+        bc += w * b * c;
+        ad += w * a * d;
+        bd += w * b * d;
+        cd += w * c * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric &q) {
+        a2 += q.a2;
+        b2 += q.b2;
+        c2 += q.c2;
+        ab += q.ab;
+        ac += q.ac;
+        bc += q.bc;
+        ad += q.ad;
+        bd += q.bd;
+        cd += q.cd;
+        d2 += q.d2;
+        weight += q.weight;
+    }
+
+    // mean squared distance of (x, y, z) to the planes
+    double error(double x, double y, double z) const {
+        const double e = a2 * x * x + b2 * y * y + c2 * z * z +
+                         2 * (ab * x * y + ac * x * z + bc * y * z) +
+                         2 * (ad * x + bd * y + cd * z) + d2;
+        return weight > 0 ? std::max(e, 0.0) / weight : 0.0;
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    float cost;
+};
+
+inline void triangleNormal(const Vertex &a, const Vertex &b, const Vertex &c, float *n) {
+    const float e0[3] = {b.vx - a.vx, b.vy - a.vy, b.vz - a.vz};
+    const float e1[3] = {c.vx - a.vx, c.vy - a.vy, c.vz - a.vz};
+    n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+    n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+    n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+}
+
+// one representative vertex per distinct position: seams split a position into several vertices
+std::vector<uint32_t> positionRemap(std::span<const Vertex> vertices) {
+    std::vector<uint32_t> order(vertices.size());
+    for (size_t v = 0; v < order.size(); ++v) {
+        order[v] = static_cast<uint32_t>(v);
+    }
+    auto key = [&](uint32_t v) {
+        return std::array<float, 3>{vertices[v].vx, vertices[v].vy, vertices[v].vz};
+    };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return key(a) < key(b);
+    });
+    std::vector<uint32_t> remap(vertices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        remap[order[i]] = (i > 0 && key(order[i]) == key(order[i - 1])) ? remap[order[i - 1]]
+                                                                        : order[i];
+    }
+    return remap;
+}
+}
+
+std::vector<uint32_t> simplifyMesh(std::span<const uint32_t> indices,
+                                   std::span<const Vertex> vertices,
+                                   size_t targetIndexCount, float maxError,
+                                   float *resultError) {
+    const size_t vertexCount = vertices.size();
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        if (indices[t] < vertexCount && indices[t + 1] < vertexCount &&
+            indices[t + 2] < vertexCount) {
+            result.insert(result.end(), indices.begin() + t, indices.begin() + t + 3);
+        }
+    }
+    if (resultError) {
+        *resultError = 0.0f;
+    }
+    if (result.size() <= targetIndexCount) {
+        return result;
+    }
+
+    // locked: seams (several vertices at one position), borders and non-manifold edges
+    const auto position = positionRemap(vertices);
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::vector<uint32_t> verticesAtPosition(vertexCount, 0);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            ++verticesAtPosition[position[v]];
+        }
+        std::vector<uint64_t> edges;
+        edges.reserve(result.size());
+        for (size_t t = 0; t < result.size(); t += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                const uint32_t a = position[result[t + k]];
+                const uint32_t b = position[result[t + (k + 1) % 3]];
+                edges.push_back(uint64_t(std::min(a, b)) << 32 | std::max(a, b));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        std::vector<bool> lockedPosition(vertexCount, false);
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i]) {
+                ++j;
+            }
+            if (j - i != 2) {
+                lockedPosition[edges[i] >> 32] = true;
+                lockedPosition[edges[i] & 0xffffffffu] = true;
+            }
+            i = j;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            locked[v] = verticesAtPosition[position[v]] > 1 || lockedPosition[position[v]];
+        }
+    }
+
+    // one quadric per position, from the planes of the triangles around it
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t < result.size(); t += 3) {
+        const Vertex &a = vertices[result[t]];
+        float n[3];
+        triangleNormal(a, vertices[result[t + 1]], vertices[result[t + 2]], n);
+        const double length = std::sqrt(double(n[0]) * n[0] + double(n[1]) * n[1] +
+                                        double(n[2]) * n[2]);
+        if (length == 0.0) {
+            continue;
+        }
+        const double nx = n[0] / length, ny = n[1] / length, nz = n[2] / length;
+        const double d = -(nx * a.vx + ny * a.vy + nz * a.vz);
+        for (size_t k = 0; k < 3; ++k) {
+            quadrics[position[result[t + k]]].addPlane(nx, ny, nz, d, length * 0.5);
+        }
+    }
+
+    const double maxCost = double(maxError) * double(maxError);
+    double worstCost = 0.0;
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> bestCollapse(vertexCount);
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> collapseTarget(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    while (result.size() > targetIndexCount) {
+        const size_t triangleCount = result.size() / 3;
+        // vertex -> triangles, compressed rows
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (const auto v: result) {
+            ++adjacencyOffsets[v + 1];
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t t = 0; t < triangleCount; ++t) {
+                for (size_t k = 0; k < 3; ++k) {
+                    adjacency[cursor[result[t * 3 + k]]++] = static_cast<uint32_t>(t);
+                }
+            }
+        }
+
+        // cheapest edge of every vertex that may move, cheapest vertices first
+        std::fill(bestCollapse.begin(), bestCollapse.end(),
+                  Collapse{0, 0, std::numeric_limits<float>::max()});
+        for (size_t t = 0; t < result.size(); t += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                const uint32_t edge[2] = {result[t + k], result[t + (k + 1) % 3]};
+                for (size_t e = 0; e < 2; ++e) {
+                    const uint32_t from = edge[e];
+                    const uint32_t to = edge[1 - e];
+                    if (locked[from] || from == to) {
+                        continue;
+                    }
+                    Quadric q = quadrics[position[from]];
+                    q.add(quadrics[position[to]]);
+                    const auto cost = static_cast<float>(
+                            q.error(vertices[to].vx, vertices[to].vy, vertices[to].vz));
+                    if (cost < bestCollapse[from].cost) {
+                        bestCollapse[from] = {from, to, cost};
+                    }
+                }
+            }
+        }
+        collapses.clear();
+        for (const auto &collapse: bestCollapse) {
+            if (collapse.cost < std::numeric_limits<float>::max()) {
+                collapses.push_back(collapse);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+            return a.cost < b.cost;
+        });
+
+        // independent collapses only: the one-ring of a collapsed vertex is frozen for the pass,
+        // so the flip test below always sees the triangles that end up in the result
+        for (size_t v = 0; v < vertexCount; ++v) {
+            collapseTarget[v] = static_cast<uint32_t>(v);
+        }
+        std::fill(touched.begin(), touched.end(), false);
+        const size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+        size_t removed = 0;
+        size_t collapsed = 0;
+        for (const auto &collapse: collapses) {
+            if (collapse.cost > maxCost || removed >= trianglesToRemove) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+            bool flips = false;
+            size_t collapsedTriangles = 0;
+            for (uint32_t a = adjacencyOffsets[collapse.from];
+                 a < adjacencyOffsets[collapse.from + 1] && !flips; ++a) {
+                const uint32_t *triangle = &result[size_t(adjacency[a]) * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to ||
+                    triangle[2] == collapse.to) {
+                    ++collapsedTriangles;
+                    continue;
+                }
+                const Vertex *before[3];
+                const Vertex *after[3];
+                for (size_t k = 0; k < 3; ++k) {
+                    before[k] = &vertices[triangle[k]];
+                    after[k] = triangle[k] == collapse.from ? &vertices[collapse.to] : before[k];
+                }
+                float n0[3];
+                float n1[3];
+                triangleNormal(*before[0], *before[1], *before[2], n0);
+                triangleNormal(*after[0], *after[1], *after[2], n1);
+                const float dot = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2];
+                const float lengths = std::sqrt((n0[0] * n0[0] + n0[1] * n0[1] + n0[2] * n0[2]) *
+                                                (n1[0] * n1[0] + n1[1] * n1[1] + n1[2] * n1[2]));
+                // flipped or turned by more than ~75 degrees
+                flips = dot <= 0.25f * lengths;
+            }
+            if (flips) {
+                continue;
+            }
+            collapseTarget[collapse.from] = collapse.to;
+            quadrics[position[collapse.to]].add(quadrics[position[collapse.from]]);
+            touched[collapse.to] = true;
+            for (uint32_t a = adjacencyOffsets[collapse.from];
+                 a < adjacencyOffsets[collapse.from + 1]; ++a) {
+                const uint32_t *triangle = &result[size_t(adjacency[a]) * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+            }
+            worstCost = std::max(worstCost, double(collapse.cost));
+            removed += collapsedTriangles;
+            ++collapsed;
+        }
+        if (collapsed == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t t = 0; t < result.size(); t += 3) {
+            const uint32_t a = collapseTarget[result[t]];
+            const uint32_t b = collapseTarget[result[t + 1]];
+            const uint32_t c = collapseTarget[result[t + 2]];
+            if (a == b || b == c || c == a) {
+                continue;
+            }
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+    if (resultError) {
+        *resultError = static_cast<float>(std::sqrt(worstCost));
+    }
+    return result;
+}
+
+void generateLods(Mesh &mesh) {
+    mesh.lods.clear();
+    if (mesh.indices.empty()) {
+        return;
+    }
+    mesh.lods.push_back({.firstIndex = 0,
+                         .indexCount = static_cast<uint32_t>(mesh.indices.size()),
+                         .error = 0.0f});
+    const std::vector<uint32_t> lod0(mesh.indices);
+    size_t previousIndexCount = lod0.size();
+    float previousError = 0.0f;
+    while (mesh.lods.size() < MAX_MESH_LODS) {
+        const size_t targetIndexCount = previousIndexCount / 6 * 3;
+        if (targetIndexCount < LOD_MIN_TRIANGLES * 3) {
+            break;
+        }
+        // from level 0 every time: errors are measured against the source surface
+        float error = 0.0f;
+        auto lod = simplifyMesh(lod0, mesh.vertices, targetIndexCount, std::numeric_limits<float>::max(), &error);
+        // locked borders/seams hold the mesh: another level would barely save anything
+        if (lod.size() * 20 > previousIndexCount * 17) {
+            break;
+        }
+        optimizeVertexCache(lod, mesh.vertices.size(), MESH_OPT_CACHE_SIZE);
+        previousError = std::max(previousError, error);
+        mesh.lods.push_back({.firstIndex = static_cast<uint32_t>(mesh.indices.size()),
+                             .indexCount = static_cast<uint32_t>(lod.size()),
+                             .error = previousError});
+        mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+        previousIndexCount = lod.size();
+    }
+}
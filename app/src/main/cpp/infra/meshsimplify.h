@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <scene.h>
+
+// lod chain generation for the glb loader
+// quadric error metric edge collapse (Garland & Heckbert 1997), index-only: a collapse moves a
+// vertex onto one of its neighbours, so every level shares the primitive's vertex buffer
+// open borders, uv/normal seams and non-manifold edges are never moved
+
+// levels stop once a triangle count would drop below this
+constexpr uint32_t LOD_MIN_TRIANGLES = 32;
+
+// at most targetIndexCount indices when reachable with every collapse under maxError
+// resultError: object-space distance of the worst collapse (rms over its merged planes)
+std::vector<uint32_t> simplifyMesh(std::span<const uint32_t> indices,
+                                   std::span<const Vertex> vertices,
+                                   size_t targetIndexCount, float maxError,
+                                   float *resultError = nullptr);
+
+// mesh.indices stays level 0, coarser levels (half the triangles of the previous one each, up
+// to MAX_MESH_LODS) are appended behind it; fills mesh.lods. float vertices, before
+// quantization; works best on welded vertices (see optimizeMesh)
+void generateLods(Mesh &mesh);
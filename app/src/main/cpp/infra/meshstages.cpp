@@ -0,0 +1,220 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#include <meshoptimization.h>
+#include <meshsimplify.h>
+#include <meshstages.h>
+#include <misc.h>
+#include <vertexkernels.h>
+
+// float vertices -> QuantizedVertex against the primitive's own AABB, drops the float copy
+static void quantizeMesh(Mesh &mesh) {
+    if (mesh.vertices.empty()) {
+        return;
+    }
+    const float minAABB[3] = {mesh.minAABB[COMPONENT::X], mesh.minAABB[COMPONENT::Y],
+                              mesh.minAABB[COMPONENT::Z]};
+    const float maxAABB[3] = {mesh.maxAABB[COMPONENT::X], mesh.maxAABB[COMPONENT::Y],
+                              mesh.maxAABB[COMPONENT::Z]};
+    mesh.quantizedVertices.resize(mesh.vertices.size());
+    quantizeVertices(mesh.vertices.data(), mesh.normals.empty() ? nullptr : mesh.normals.data(),
+                     mesh.vertices.size(), minAABB, maxAABB, mesh.quantizedVertices.data());
+    mesh.vertices.clear();
+    mesh.vertices.shrink_to_fit();
+    mesh.normals.clear();
+    mesh.normals.shrink_to_fit();
+}
+
+std::vector<MeshletBuffers> runMeshStages(std::vector<Mesh> &primitives,
+                                          const MeshStages &stages,
+                                          WorkerPool &workerPool) {
+    const size_t vertexStride = stages.quantizeVertices ? sizeof(QuantizedVertex)
+                                                        : sizeof(Vertex);
+    // weld, vertex cache, overdraw and fetch order; float vertices, so before quantization
+    if (stages.optimizeMeshes) {
+        const auto optimizeStart = std::chrono::steady_clock::now();
+        std::vector<MeshOptimizationReport> reports(primitives.size());
+        workerPool.parallelFor(primitives.size(), [&](size_t i) {
+            reports[i] = optimizeMesh(primitives[i], vertexStride);
+        });
+        const auto optimizeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - optimizeStart).count();
+        for (size_t i = 0; i < reports.size(); ++i) {
+            const auto &report = reports[i];
+            LOGI("Primitive %zu: vertices %zu -> %zu, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, "
+                 "overfetch %.3f -> %.3f", i, report.verticesBefore, report.verticesAfter,
+                 report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr,
+                 report.before.overfetch, report.after.overfetch);
+        }
+        LOGI("Optimized %zu primitives in %lld us", reports.size(),
+             static_cast<long long>(optimizeUs));
+    }
+
+    // meshlets follow the optimized triangle order and need float positions for their bounds
+    std::vector<MeshletBuffers> primitiveMeshlets(stages.buildMeshlets ? primitives.size() : 0);
+    if (stages.buildMeshlets) {
+        const auto meshletStart = std::chrono::steady_clock::now();
+        workerPool.parallelFor(primitives.size(), [&](size_t i) {
+            primitiveMeshlets[i] = buildMeshlets(primitives[i].indices, primitives[i].vertices);
+        });
+        const auto meshletUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - meshletStart).count();
+        MeshletFill fill;
+        size_t triangleCount = 0;
+        size_t cullableCount = 0;
+        for (size_t i = 0; i < primitiveMeshlets.size(); ++i) {
+            const auto primitiveFill = meshletFill(primitiveMeshlets[i].meshlets);
+            fill.meshlets += primitiveFill.meshlets;
+            fill.vertices += primitiveFill.vertices;
+            fill.triangles += primitiveFill.triangles;
+            triangleCount += primitives[i].indices.size() / 3;
+            for (const auto &meshlet: primitiveMeshlets[i].meshlets) {
+                cullableCount += meshlet.coneCutoff < 1.0f;
+            }
+        }
+        LOGI("Built %zu meshlets from %zu triangles in %lld us (%.1f Mtriangles/s), "
+             "fill: %.1f%% vertices, %.1f%% triangles, %zu with a usable normal cone",
+             fill.meshlets, triangleCount, static_cast<long long>(meshletUs),
+             meshletUs > 0 ? double(triangleCount) / double(meshletUs) : 0.0,
+             fill.meshlets ? 100.0 * double(fill.vertices) /
+                             double(fill.meshlets * MESHLET_MAX_VERTICES) : 0.0,
+             fill.meshlets ? 100.0 * double(fill.triangles) /
+                             double(fill.meshlets * MESHLET_MAX_TRIANGLES) : 0.0,
+             cullableCount);
+    }
+
+    // level 0 is final now (meshlets cover it only), coarser levels go behind it
+    if (stages.generateLods) {
+        const auto lodStart = std::chrono::steady_clock::now();
+        workerPool.parallelFor(primitives.size(), [&](size_t i) {
+            generateLods(primitives[i]);
+        });
+        const auto lodUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - lodStart).count();
+        std::array<size_t, MAX_MESH_LODS> levelTriangles{};
+        for (const auto &primitive: primitives) {
+            for (size_t level = 0; level < primitive.lods.size(); ++level) {
+                levelTriangles[level] += primitive.lods[level].indexCount / 3;
+            }
+        }
+        std::ostringstream levels;
+        for (size_t level = 0; level < MAX_MESH_LODS; ++level) {
+            levels << (level ? " / " : "") << levelTriangles[level];
+        }
+        LOGI("Generated LODs in %lld us, triangles per level: %s",
+             static_cast<long long>(lodUs), levels.str().c_str());
+    }
+
+    // opt-in: compact vertices, dequantized in the vertex shader
+    if (stages.quantizeVertices) {
+        workerPool.parallelFor(primitives.size(), [&](size_t i) {
+            quantizeMesh(primitives[i]);
+        });
+        size_t quantizedCount = 0;
+        for (const auto &primitive: primitives) {
+            quantizedCount += primitive.quantizedVertices.size();
+        }
+        LOGI("Quantized %zu vertices: %zu -> %zu bytes per vertex, %zu KB saved",
+             quantizedCount, sizeof(Vertex), sizeof(QuantizedVertex),
+             quantizedCount * (sizeof(Vertex) - sizeof(QuantizedVertex)) / 1024);
+    }
+    return primitiveMeshlets;
+}
+
+void appendMeshlets(Scene &scene, MeshletBuffers &built, uint32_t drawId, uint32_t vertexOffset) {
+    const auto meshletVertexBase = static_cast<uint32_t>(scene.meshletVertices.size());
+    const auto meshletTriangleBase = static_cast<uint32_t>(scene.meshletTriangles.size());
+    for (auto &meshlet: built.meshlets) {
+        meshlet.vertexOffset += meshletVertexBase;
+        meshlet.triangleOffset += meshletTriangleBase;
+        meshlet.drawId = drawId;
+    }
+    for (auto &vertex: built.vertices) {
+        vertex += vertexOffset;
+    }
+    scene.meshlets.insert(scene.meshlets.end(), built.meshlets.begin(), built.meshlets.end());
+    scene.meshletVertices.insert(scene.meshletVertices.end(), built.vertices.begin(),
+                                 built.vertices.end());
+    scene.meshletTriangles.insert(scene.meshletTriangles.end(), built.triangles.begin(),
+                                  built.triangles.end());
+    built = {};
+}
+
+void refineSceneGeometry(Scene &scene, const MeshStages &stages, WorkerPool &workerPool) {
+    if (!stages.any()) {
+        return;
+    }
+    ASSERT(!stages.quantizeVertices && !scene.quantizedVertices && scene.meshlets.empty(),
+           "refineSceneGeometry: float vertices of a scene no stage has run on yet");
+    const auto start = std::chrono::steady_clock::now();
+
+    // every draw gets its streams back out of the composite geometry, indices stay relative
+    // to the draw's own vertices
+    const auto *vertices = reinterpret_cast<const Vertex *>(scene.vertexBytes.data());
+    std::vector<Mesh> primitives(scene.indirectDraw.size());
+    workerPool.parallelFor(primitives.size(), [&](size_t i) {
+        const auto &draw = scene.indirectDraw[i];
+        auto &primitive = primitives[i];
+        primitive = std::move(scene.meshes[draw.meshId]);
+        primitive.vertices.assign(vertices + draw.vertexOffset,
+                                  vertices + draw.vertexOffset + draw.vertexCount);
+        primitive.indices.assign(scene.indices.begin() + draw.firstIndex,
+                                 scene.indices.begin() + draw.firstIndex + draw.indexCount);
+    });
+
+    auto primitiveMeshlets = runMeshStages(primitives, stages, workerPool);
+
+    // same prefix-sum packing as the reader, into a fresh buffer: the old streams may live in
+    // staging memory an upload still reads from
+    std::vector<size_t> vertexOffsets(primitives.size());
+    std::vector<size_t> indexOffsets(primitives.size());
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        vertexOffsets[i] = vertexCount;
+        indexOffsets[i] = indexCount;
+        vertexCount += primitives[i].vertices.size();
+        indexCount += primitives[i].indices.size();
+    }
+    const size_t vertexByteSize = vertexCount * sizeof(Vertex);
+    const size_t indexByteSize = indexCount * sizeof(uint32_t);
+    std::vector<std::byte> geometry(vertexByteSize + indexByteSize);
+    auto *indices = reinterpret_cast<uint32_t *>(geometry.data() + vertexByteSize);
+    workerPool.parallelFor(primitives.size(), [&](size_t i) {
+        auto &primitive = primitives[i];
+        memcpy(geometry.data() + vertexOffsets[i] * sizeof(Vertex), primitive.vertices.data(),
+               primitive.vertices.size() * sizeof(Vertex));
+        memcpy(indices + indexOffsets[i], primitive.indices.data(),
+               primitive.indices.size() * sizeof(uint32_t));
+    });
+    scene.ownedGeometry = std::move(geometry);
+    scene.vertexBytes = std::span<const std::byte>(scene.ownedGeometry).first(vertexByteSize);
+    scene.indices = {indices, indexCount};
+    scene.totalVerticesByteSize = static_cast<uint32_t>(vertexByteSize);
+    scene.totalIndexByteSize = static_cast<uint32_t>(indexByteSize);
+
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        auto &draw = scene.indirectDraw[i];
+        auto &primitive = primitives[i];
+        draw.firstIndex = static_cast<uint32_t>(indexOffsets[i]);
+        draw.vertexOffset = static_cast<uint32_t>(vertexOffsets[i]);
+        draw.vertexCount = static_cast<uint32_t>(primitive.vertices.size());
+        draw.indexCount = static_cast<uint32_t>(primitive.lods.empty()
+                                                ? primitive.indices.size()
+                                                : primitive.lods[0].indexCount);
+        if (!primitiveMeshlets.empty()) {
+            appendMeshlets(scene, primitiveMeshlets[i], static_cast<uint32_t>(i),
+                           draw.vertexOffset);
+        }
+        primitive.vertices = {};
+        primitive.indices = {};
+        scene.meshes[draw.meshId] = std::move(primitive);
+    }
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("Refined %zu draws for the scene cache: %zu vertices, %zu indices in %lld ms",
+         primitives.size(), vertexCount, indexCount, static_cast<long long>(elapsedMs));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include <meshlets.h>
+#include <scene.h>
+#include <workerpool.h>
+
+// the per-primitive geometry stages of the glb loader, always run in this order:
+// optimize -> meshlets -> lods -> quantize, each one needs the float vertices left by the last
+struct MeshStages {
+    bool optimizeMeshes{false};
+    bool buildMeshlets{false};
+    bool generateLods{false};
+    // needs Mesh::normals, which only exist while a glb is being decoded
+    bool quantizeVertices{false};
+
+    inline bool any() const {
+        return optimizeMeshes || buildMeshlets || generateLods || quantizeVertices;
+    }
+};
+
+// runs the enabled stages on primitives holding their own streams, on workerPool, and logs
+// their stats; returns the meshlets of every primitive, empty without buildMeshlets
+std::vector<MeshletBuffers> runMeshStages(std::vector<Mesh> &primitives,
+                                          const MeshStages &stages,
+                                          WorkerPool &workerPool);
+
+// moves one draw's meshlets into the scene's composite meshlet buffers, rebased onto the
+// draw's vertexOffset
+void appendMeshlets(Scene &scene, MeshletBuffers &built, uint32_t drawId, uint32_t vertexOffset);
+
+// cook time: the stages on a scene whose primitives were decoded in place (none ran while
+// reading); the result is repacked into Scene::ownedGeometry, draws and meshes are updated
+// float vertices only, quantization needs the normals an in-place decode does not keep
+void refineSceneGeometry(Scene &scene, const MeshStages &stages, WorkerPool &workerPool);
@@ -16,6 +16,13 @@
 #define LOG_TAG "simpleandroidvk"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+
+#include <cstdio>
+
+// desktop tooling (glb preprocessing, benchmarks): plain stdio
+#define LOGI(...) do { fprintf(stdout, __VA_ARGS__); fputc('\n', stdout); } while (0)
+#define LOGE(...) do { fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } while (0)
 #endif
 
 #define ASSERT(expr, message) \
@@ -84,6 +91,9 @@ struct IndirectDrawForVulkan {
     uint32_t firstInstance;
     uint32_t meshId;
     uint32_t materialIndex;
+    // the primitive's AABB, dequantizes QuantizedVertex positions
+    float boundsMin[3];
+    float boundsMax[3];
 };
 
 inline uint32_t getMipLevelsCount(uint32_t w, uint32_t h) {
@@ -148,7 +148,7 @@ inline mat<T, 4, sizeof(T) * 16> RotationMatrixFromQuaternion(const quaternion<T
 
     res.data[0][0] = T(1) - T(2) * (q22 + q33);
     res.data[0][1] = T(2) * (q12 + q34);
-    res.data[0][2] = T(2) * (q13 + q24);
+    res.data[0][2] = T(2) * (q13 - q24);
 
     res.data[1][0] = T(2) * (q12 - q34);
     res.data[1][1] = T(1) - T(2) * (q11 + q33);
@@ -8,8 +8,8 @@
 
 #include <stb_image_write.h>
 
-Texture::Texture(const std::vector<uint8_t> &rawBuffer) {
-    LOGI("rawBuffer Size: %d", rawBuffer.size());
+Texture::Texture(std::span<const uint8_t> rawBuffer) {
+    LOGI("rawBuffer Size: %zu", rawBuffer.size());
     data = stbi_load_from_memory(rawBuffer.data(), rawBuffer.size(), &width, &height,
                                  &channels, STBI_rgb_alpha);
 }
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <numeric>
+#include <span>
 #include <stb_image.h>
 #include <ktx.h>
 #include <ktxvulkan.h>
@@ -9,6 +10,7 @@
 #include <vector.h>
 #include <matrix.h>
 #include <misc.h>
+#include <scenegraph.h>
 // mimic
 //struct VkDrawIndexedIndirectCommand {
 //    uint32_t    indexCount;
@@ -23,6 +25,8 @@ struct IndirectDrawDef1 {
     uint32_t instanceCount;
     uint32_t firstIndex;
     uint32_t vertexOffset;
+    // vertices of this draw behind vertexOffset
+    uint32_t vertexCount;
     uint32_t firstInstance;
     uint32_t meshId;
     int materialIndex;
@@ -58,23 +62,61 @@ struct Vertex {
     float uy;
     uint32_t material;
 
+    // row vectors: p' = p * m, same as the instance transforms
     void transform(const mat4x4f &m) {
-        auto newp = MatrixMultiplyVector4x4(m, vec4f(std::array<float, 4>{
-                vx,
-                vy,
-                vz,
-                1.0
-        }));
-
-        vx = newp[COMPONENT::X];
-        vy = newp[COMPONENT::X];
-        vz = newp[COMPONENT::X];
+        const float x = vx;
+        const float y = vy;
+        const float z = vz;
+        vx = x * m.data[0][0] + y * m.data[1][0] + z * m.data[2][0] + m.data[3][0];
+        vy = x * m.data[0][1] + y * m.data[1][1] + z * m.data[2][1] + m.data[3][1];
+        vz = x * m.data[0][2] + y * m.data[1][2] + z * m.data[2][2] + m.data[3][2];
     }
 };
 
+// opt-in compact gpu vertex, 12 bytes instead of 24, dequantized in the vertex shader
+// the material is not stored: it comes from the draw record
+struct QuantizedVertex {
+    // unorm16 within the primitive's AABB
+    uint16_t px;
+    uint16_t py;
+    uint16_t pz;
+    // octahedral normal, snorm8 x in the low byte, snorm8 y in the high byte
+    uint16_t normal;
+    // half floats
+    uint16_t u;
+    uint16_t v;
+};
+
+// coarser levels of a primitive, level 0 is the full primitive
+constexpr uint32_t MAX_MESH_LODS = 5;
+
+struct MeshLod {
+    // range of the primitive's index buffer (composite index buffer in DrawLods)
+    uint32_t firstIndex{0};
+    uint32_t indexCount{0};
+    // object-space deviation from level 0, projected to pixels to pick a level
+    float error{0};
+};
+
+// lod chain of one draw record, cooked next to the indirect draws
+struct DrawLods {
+    uint32_t lodCount{0};
+    MeshLod lods[MAX_MESH_LODS]{};
+};
+
+// one gltf primitive: a single material, its own bounds and its own draw record
+// the vertex/index vectors only live while the reader processes the primitive, the final
+// streams end up in Scene::vertexBytes / Scene::indices
 struct Mesh {
     std::vector<Vertex> vertices{};
+    // quantized scene: vertices are moved in here, vertices is left empty
+    std::vector<QuantizedVertex> quantizedVertices{};
+    // vec3f stream, only kept while the primitive still has to be quantized
+    std::vector<float> normals{};
+    // level 0 first, coarser levels (if any) behind it, see lods
     std::vector<uint32_t> indices{};
+    // empty: indices is the only level
+    std::vector<MeshLod> lods{};
     int32_t materialIdx{-1};
 
     vec3f minAABB{std::array{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
@@ -83,6 +125,38 @@ struct Mesh {
                              -std::numeric_limits<float>::max()}};
     vec3f extents;
     vec3f center;
+
+    inline size_t vertexCount() const {
+        return vertices.empty() ? quantizedVertices.size() : vertices.size();
+    }
+
+    // upload view of whichever layout the primitive carries
+    inline std::span<const std::byte> vertexBytes() const {
+        return vertices.empty() ? std::as_bytes(std::span(quantizedVertices))
+                                : std::as_bytes(std::span(vertices));
+    }
+};
+
+// cluster of up to 64 vertices / 124 triangles of one primitive (see meshlets.h)
+// gpu layout (std430 compatible, 64 bytes)
+struct Meshlet {
+    // into the meshlet vertex buffer: vertexCount composite vertex indices
+    uint32_t vertexOffset{0};
+    // into the meshlet triangle buffer, in bytes: triangleCount x 3 local u8 indices,
+    // every meshlet starts 4-byte aligned
+    uint32_t triangleOffset{0};
+    uint32_t vertexCount{0};
+    uint32_t triangleCount{0};
+    // bounding sphere, mesh space
+    float center[3]{0, 0, 0};
+    float radius{0};
+    // backfacing when dot(normalize(coneApex - cameraPos), coneAxis) >= coneCutoff,
+    // coneCutoff 1: the normals spread too much, never cull
+    float coneApex[3]{0, 0, 0};
+    float coneCutoff{1};
+    float coneAxis[3]{0, 0, 0};
+    // draw record (primitive) the meshlet belongs to: material, instances
+    uint32_t drawId{0};
 };
 
 // https://github.com/KhronosGroup/glTF/blob/2.0/specification/2.0/schema/material.schema.json
@@ -97,7 +171,8 @@ struct Material {
 };
 
 struct Texture {
-    Texture(const std::vector<uint8_t> &rawBuffer);
+    // rawBuffer: encoded png/jpeg bytes, only read during construction
+    Texture(std::span<const uint8_t> rawBuffer);
 
 //    {
 //        LOGI("rawBuffer Size: %d", rawBuffer.size());
@@ -123,6 +198,23 @@ struct Scene {
     std::vector<Material> materials;
     std::vector<std::unique_ptr<Texture>> textures;
     std::vector<IndirectDrawDef1> indirectDraw;
+    // default scene's node hierarchy, world transforms resolved
+    SceneGraph graph;
+    // one world transform per mesh node, indexed by firstInstance + instance
+    std::vector<mat4x4f> instanceTransforms;
+    // meshes carry QuantizedVertex instead of Vertex
+    bool quantizedVertices{false};
+    // optional, all primitives: Meshlet::drawId is the draw record, meshletVertices hold
+    // composite vertex indices (draw vertexOffset applied), meshletTriangles local u8 indices
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint8_t> meshletTriangles;
     uint32_t totalVerticesByteSize{0};
     uint32_t totalIndexByteSize{0};
+    // composite vertex / index streams, draw vertexOffset and firstIndex point into them
+    // the meshes give up their own copies once these are written
+    // they view the reader's stageGeometry memory, or ownedGeometry when there was none
+    std::span<const std::byte> vertexBytes;
+    std::span<const uint32_t> indices;
+    std::vector<std::byte> ownedGeometry;
 };
\ No newline at end of file
@@ -0,0 +1,434 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+#include <scenecache.h>
+
+static constexpr uint32_t SCENE_CACHE_MAGIC = 0x434E4353; // "SCNC"
+// bump whenever the cooked layout or the meaning of a section changes
+static constexpr uint32_t SCENE_CACHE_VERSION = 9;
+// every section starts 16-byte aligned, spans over the mapping can be used as typed arrays
+static constexpr size_t SCENE_CACHE_ALIGNMENT = 16;
+
+struct SceneCacheHeader {
+    uint32_t magic{0};
+    uint32_t version{0};
+    uint64_t sourceHash{0};
+    // struct layout guards: a cache written by a build with other structs is stale
+    uint32_t vertexStride{0};
+    uint32_t indirectDrawStride{0};
+    uint32_t materialStride{0};
+    uint32_t textureCount{0};
+    uint32_t instanceTransformStride{0};
+    uint32_t meshletStride{0};
+    uint32_t drawLodsStride{0};
+    uint32_t reserved{0};
+    uint64_t vertexCount{0};
+    uint64_t indexCount{0};
+    uint64_t indirectDrawCount{0};
+    uint64_t materialCount{0};
+    uint64_t instanceTransformCount{0};
+    uint64_t meshletCount{0};
+    uint64_t meshletVertexCount{0};
+    uint64_t meshletTriangleByteSize{0};
+    uint64_t verticesOffset{0};
+    uint64_t indicesOffset{0};
+    uint64_t indirectDrawsOffset{0};
+    uint64_t drawLodsOffset{0};
+    uint64_t materialsOffset{0};
+    uint64_t instanceTransformsOffset{0};
+    uint64_t meshletsOffset{0};
+    uint64_t meshletVerticesOffset{0};
+    uint64_t meshletTrianglesOffset{0};
+    uint64_t texturesOffset{0};
+};
+
+struct SceneCacheTextureEntry {
+    uint32_t width{0};
+    uint32_t height{0};
+    uint32_t mipLevels{0};
+    uint32_t reserved{0};
+    uint64_t texelsOffset{0};
+    uint64_t texelsByteSize{0};
+};
+
+static size_t alignUp(size_t v) {
+    return (v + SCENE_CACHE_ALIGNMENT - 1) & ~(SCENE_CACHE_ALIGNMENT - 1);
+}
+
+uint64_t hashSceneSource(std::span<const std::byte> bytes) {
+    // FNV-1a over 8-byte words (byte-wise is too slow to run over the whole glb every launch),
+    // finished with the murmur3 avalanche so every input bit reaches every output bit
+    constexpr uint64_t FNV_PRIME = 1099511628211ull;
+    uint64_t hash = 14695981039346656037ull;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= bytes.size(); i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes.data() + i, sizeof(word));
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    for (; i < bytes.size(); ++i) {
+        hash = (hash ^ static_cast<uint8_t>(bytes[i])) * FNV_PRIME;
+    }
+    hash = (hash ^ bytes.size()) * FNV_PRIME;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+size_t mipChainByteSize(uint32_t width, uint32_t height, uint32_t mipLevels) {
+    size_t size = 0;
+    for (uint32_t level = 0; level < mipLevels; ++level) {
+        size += size_t(width) * height * 4;
+        width = width > 1 ? width >> 1 : width;
+        height = height > 1 ? height >> 1 : height;
+    }
+    return size;
+}
+
+// sRGB transfer functions, the same curves as toLinear / toEncoded in mipdownsample.glsl
+static float srgbToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float linearToSrgb(float c) {
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// 8-bit sRGB code -> linear, built once
+struct SrgbDecodeTable {
+    float linear[256];
+
+    SrgbDecodeTable() {
+        for (int i = 0; i < 256; ++i) {
+            linear[i] = srgbToLinear(float(i) / 255.0f);
+        }
+    }
+};
+
+static const SrgbDecodeTable SRGB_DECODE;
+
+// 2x2 box filter, same extents as the blit chain: a dimension of 1 stays 1
+// srgb: rgb is averaged in linear space and re-encoded like the compute path does, alpha is
+// always linear; otherwise the bytes are averaged as they are
+static void downsampleRGBA8(const uint8_t *src, uint32_t width, uint32_t height,
+                            uint8_t *dst, uint32_t newWidth, uint32_t newHeight, bool srgb) {
+    for (uint32_t y = 0; y < newHeight; ++y) {
+        const uint32_t y0 = std::min(y * 2, height - 1);
+        const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+        for (uint32_t x = 0; x < newWidth; ++x) {
+            const uint32_t x0 = std::min(x * 2, width - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+            const uint8_t *p00 = src + (size_t(y0) * width + x0) * 4;
+            const uint8_t *p01 = src + (size_t(y0) * width + x1) * 4;
+            const uint8_t *p10 = src + (size_t(y1) * width + x0) * 4;
+            const uint8_t *p11 = src + (size_t(y1) * width + x1) * 4;
+            uint8_t *out = dst + (size_t(y) * newWidth + x) * 4;
+            const int encodedChannels = srgb ? 3 : 0;
+            for (int c = 0; c < encodedChannels; ++c) {
+                const float linear = 0.25f * (SRGB_DECODE.linear[p00[c]] +
+                                              SRGB_DECODE.linear[p01[c]] +
+                                              SRGB_DECODE.linear[p10[c]] +
+                                              SRGB_DECODE.linear[p11[c]]);
+                out[c] = static_cast<uint8_t>(
+                        std::clamp(linearToSrgb(linear), 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+            for (int c = encodedChannels; c < 4; ++c) {
+                out[c] = static_cast<uint8_t>((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+            }
+        }
+    }
+}
+
+static std::vector<uint8_t> generateMipChain(const Texture &texture, uint32_t mipLevels,
+                                             bool srgb) {
+    uint32_t width = texture.width;
+    uint32_t height = texture.height;
+    std::vector<uint8_t> texels(mipChainByteSize(width, height, mipLevels));
+    memcpy(texels.data(), texture.data, size_t(width) * height * 4);
+    size_t offset = 0;
+    for (uint32_t level = 1; level < mipLevels; ++level) {
+        const uint32_t newWidth = width > 1 ? width >> 1 : width;
+        const uint32_t newHeight = height > 1 ? height >> 1 : height;
+        const size_t newOffset = offset + size_t(width) * height * 4;
+        downsampleRGBA8(texels.data() + offset, width, height, texels.data() + newOffset,
+                        newWidth, newHeight, srgb);
+        offset = newOffset;
+        width = newWidth;
+        height = newHeight;
+    }
+    return texels;
+}
+
+// <assetStem>-<16 hex digits>.scene, whatever the hash
+static bool isCookOf(const std::string &fileName, const std::string &assetStem) {
+    static constexpr size_t HASH_DIGITS = 16;
+    static constexpr std::string_view EXTENSION = ".scene";
+    if (fileName.size() != assetStem.size() + 1 + HASH_DIGITS + EXTENSION.size() ||
+        !fileName.starts_with(assetStem + "-") || !fileName.ends_with(EXTENSION)) {
+        return false;
+    }
+    return std::all_of(fileName.begin() + assetStem.size() + 1,
+                       fileName.begin() + assetStem.size() + 1 + HASH_DIGITS,
+                       [](char c) { return std::isxdigit(static_cast<unsigned char>(c)); });
+}
+
+SceneCache::SceneCache(const std::string &directory, const std::string &assetName,
+                       uint64_t sourceHash, uint32_t vertexStride)
+        : _directory(directory),
+          _assetStem(std::filesystem::path(assetName).stem().string()),
+          _sourceHash(sourceHash), _vertexStride(vertexStride) {
+    if (!_directory.empty()) {
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(sourceHash));
+        _path = _directory + "/" + _assetStem + "-" + hash + ".scene";
+    }
+}
+
+bool SceneCache::load() {
+    if (_path.empty() || !std::filesystem::exists(_path)) {
+        return false;
+    }
+    try {
+        _file = std::make_unique<MappedFile>(_path);
+    } catch (const std::exception &e) {
+        LOGE("Scene cache %s: %s", _path.c_str(), e.what());
+        return false;
+    }
+    const auto bytes = _file->bytes();
+    const auto *base = reinterpret_cast<const uint8_t *>(bytes.data());
+    // count * stride may overflow on a corrupt header, divide instead
+    auto inBounds = [&](uint64_t offset, uint64_t count, uint64_t stride = 1) {
+        return offset <= bytes.size() && count <= (bytes.size() - offset) / stride;
+    };
+
+    SceneCacheHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        _file.reset();
+        return false;
+    }
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != SCENE_CACHE_MAGIC || header.version != SCENE_CACHE_VERSION ||
+        header.sourceHash != _sourceHash ||
+        header.vertexStride == 0 || header.vertexStride != _vertexStride ||
+        header.indirectDrawStride != sizeof(IndirectDrawForVulkan) ||
+        header.materialStride != sizeof(Material) ||
+        header.instanceTransformStride != sizeof(mat4x4f) ||
+        header.meshletStride != sizeof(Meshlet) ||
+        header.drawLodsStride != sizeof(DrawLods) ||
+        !inBounds(header.verticesOffset, header.vertexCount, _vertexStride) ||
+        !inBounds(header.indicesOffset, header.indexCount, sizeof(uint32_t)) ||
+        !inBounds(header.indirectDrawsOffset, header.indirectDrawCount,
+                  sizeof(IndirectDrawForVulkan)) ||
+        !inBounds(header.drawLodsOffset, header.indirectDrawCount, sizeof(DrawLods)) ||
+        !inBounds(header.materialsOffset, header.materialCount, sizeof(Material)) ||
+        !inBounds(header.instanceTransformsOffset, header.instanceTransformCount,
+                  sizeof(mat4x4f)) ||
+        !inBounds(header.meshletsOffset, header.meshletCount, sizeof(Meshlet)) ||
+        !inBounds(header.meshletVerticesOffset, header.meshletVertexCount, sizeof(uint32_t)) ||
+        !inBounds(header.meshletTrianglesOffset, header.meshletTriangleByteSize) ||
+        !inBounds(header.texturesOffset, header.textureCount, sizeof(SceneCacheTextureEntry))) {
+        LOGI("Scene cache %s is stale, ignoring it", _path.c_str());
+        _file.reset();
+        return false;
+    }
+
+    CookedScene scene;
+    scene.vertices = {reinterpret_cast<const std::byte *>(base + header.verticesOffset),
+                      header.vertexCount * _vertexStride};
+    scene.indices = {reinterpret_cast<const uint32_t *>(base + header.indicesOffset),
+                     header.indexCount};
+    scene.indirectDraws = {
+            reinterpret_cast<const IndirectDrawForVulkan *>(base + header.indirectDrawsOffset),
+            header.indirectDrawCount};
+    scene.drawLods = {reinterpret_cast<const DrawLods *>(base + header.drawLodsOffset),
+                      header.indirectDrawCount};
+    scene.materials = {reinterpret_cast<const Material *>(base + header.materialsOffset),
+                       header.materialCount};
+    scene.instanceTransforms = {
+            reinterpret_cast<const mat4x4f *>(base + header.instanceTransformsOffset),
+            header.instanceTransformCount};
+    scene.meshlets = {reinterpret_cast<const Meshlet *>(base + header.meshletsOffset),
+                      header.meshletCount};
+    scene.meshletVertices = {
+            reinterpret_cast<const uint32_t *>(base + header.meshletVerticesOffset),
+            header.meshletVertexCount};
+    scene.meshletTriangles = {base + header.meshletTrianglesOffset,
+                              header.meshletTriangleByteSize};
+    scene.textures.reserve(header.textureCount);
+    for (uint32_t i = 0; i < header.textureCount; ++i) {
+        SceneCacheTextureEntry entry{};
+        memcpy(&entry, base + header.texturesOffset + i * sizeof(entry), sizeof(entry));
+        if (entry.mipLevels == 0 || entry.mipLevels > 32 ||
+            entry.texelsByteSize != mipChainByteSize(entry.width, entry.height, entry.mipLevels) ||
+            !inBounds(entry.texelsOffset, entry.texelsByteSize)) {
+            LOGI("Scene cache %s is corrupt, ignoring it", _path.c_str());
+            _file.reset();
+            return false;
+        }
+        scene.textures.push_back(CookedTexture{
+                .width = entry.width,
+                .height = entry.height,
+                .mipLevels = entry.mipLevels,
+                .texels = {base + entry.texelsOffset, entry.texelsByteSize},
+        });
+    }
+    _scene = std::move(scene);
+    return true;
+}
+
+void SceneCache::store(const Scene &scene, std::span<const IndirectDrawForVulkan> indirectDraws,
+                       std::span<const DrawLods> drawLods, const std::vector<bool> &srgbTextures,
+                       WorkerPool &workerPool) const {
+    if (_path.empty()) {
+        return;
+    }
+    if (drawLods.size() != indirectDraws.size()) {
+        LOGE("Scene cache %s: %zu lod chains for %zu draws, not cooking", _path.c_str(),
+             drawLods.size(), indirectDraws.size());
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::vector<uint8_t>> mipChains(scene.textures.size());
+    workerPool.parallelFor(mipChains.size(), [&](size_t i) {
+        const Texture &texture = *scene.textures[i];
+        const bool srgb = i < srgbTextures.size() && srgbTextures[i];
+        mipChains[i] = generateMipChain(texture, getMipLevelsCount(texture.width, texture.height),
+                                        srgb);
+    });
+
+    SceneCacheHeader header{
+            .magic = SCENE_CACHE_MAGIC,
+            .version = SCENE_CACHE_VERSION,
+            .sourceHash = _sourceHash,
+            .vertexStride = static_cast<uint32_t>(scene.quantizedVertices ? sizeof(QuantizedVertex)
+                                                                          : sizeof(Vertex)),
+            .indirectDrawStride = sizeof(IndirectDrawForVulkan),
+            .materialStride = sizeof(Material),
+            .textureCount = static_cast<uint32_t>(scene.textures.size()),
+            .instanceTransformStride = sizeof(mat4x4f),
+            .meshletStride = sizeof(Meshlet),
+            .drawLodsStride = sizeof(DrawLods),
+            .indirectDrawCount = indirectDraws.size(),
+            .materialCount = scene.materials.size(),
+            .instanceTransformCount = scene.instanceTransforms.size(),
+            .meshletCount = scene.meshlets.size(),
+            .meshletVertexCount = scene.meshletVertices.size(),
+            .meshletTriangleByteSize = scene.meshletTriangles.size(),
+    };
+    header.vertexCount = scene.vertexBytes.size() / header.vertexStride;
+    header.indexCount = scene.indices.size();
+    // lay the sections out first, then stream them
+    size_t offset = alignUp(sizeof(header));
+    header.verticesOffset = offset;
+    offset = alignUp(offset + header.vertexCount * header.vertexStride);
+    header.indicesOffset = offset;
+    offset = alignUp(offset + header.indexCount * sizeof(uint32_t));
+    header.indirectDrawsOffset = offset;
+    offset = alignUp(offset + indirectDraws.size_bytes());
+    header.drawLodsOffset = offset;
+    offset = alignUp(offset + drawLods.size_bytes());
+    header.materialsOffset = offset;
+    offset = alignUp(offset + header.materialCount * sizeof(Material));
+    header.instanceTransformsOffset = offset;
+    offset = alignUp(offset + header.instanceTransformCount * sizeof(mat4x4f));
+    header.meshletsOffset = offset;
+    offset = alignUp(offset + header.meshletCount * sizeof(Meshlet));
+    header.meshletVerticesOffset = offset;
+    offset = alignUp(offset + header.meshletVertexCount * sizeof(uint32_t));
+    header.meshletTrianglesOffset = offset;
+    offset = alignUp(offset + header.meshletTriangleByteSize);
+    header.texturesOffset = offset;
+    offset = alignUp(offset + header.textureCount * sizeof(SceneCacheTextureEntry));
+    std::vector<SceneCacheTextureEntry> entries(scene.textures.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Texture &texture = *scene.textures[i];
+        entries[i] = SceneCacheTextureEntry{
+                .width = static_cast<uint32_t>(texture.width),
+                .height = static_cast<uint32_t>(texture.height),
+                .mipLevels = getMipLevelsCount(texture.width, texture.height),
+                .texelsOffset = offset,
+                .texelsByteSize = mipChains[i].size(),
+        };
+        offset = alignUp(offset + mipChains[i].size());
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(_directory, error);
+    // write next to the final file and rename: a crash mid-write never leaves a torn cache
+    const std::string tmpPath = _path + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        LOGE("Could not write scene cache %s", tmpPath.c_str());
+        return;
+    }
+    auto write = [&](const void *data, size_t size) {
+        out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    };
+    auto pad = [&]() {
+        static constexpr char zeros[SCENE_CACHE_ALIGNMENT]{};
+        const size_t position = static_cast<size_t>(out.tellp());
+        write(zeros, alignUp(position) - position);
+    };
+    write(&header, sizeof(header));
+    pad();
+    write(scene.vertexBytes.data(), scene.vertexBytes.size());
+    pad();
+    write(scene.indices.data(), scene.indices.size_bytes());
+    pad();
+    write(indirectDraws.data(), indirectDraws.size_bytes());
+    pad();
+    write(drawLods.data(), drawLods.size_bytes());
+    pad();
+    write(scene.materials.data(), scene.materials.size() * sizeof(Material));
+    pad();
+    write(scene.instanceTransforms.data(), scene.instanceTransforms.size() * sizeof(mat4x4f));
+    pad();
+    write(scene.meshlets.data(), scene.meshlets.size() * sizeof(Meshlet));
+    pad();
+    write(scene.meshletVertices.data(), scene.meshletVertices.size() * sizeof(uint32_t));
+    pad();
+    write(scene.meshletTriangles.data(), scene.meshletTriangles.size());
+    pad();
+    write(entries.data(), entries.size() * sizeof(SceneCacheTextureEntry));
+    pad();
+    for (const auto &mipChain: mipChains) {
+        write(mipChain.data(), mipChain.size());
+        pad();
+    }
+    out.close();
+    if (!out || static_cast<size_t>(std::filesystem::file_size(tmpPath, error)) != offset ||
+        std::rename(tmpPath.c_str(), _path.c_str()) != 0) {
+        LOGE("Could not write scene cache %s", _path.c_str());
+        std::filesystem::remove(tmpPath, error);
+        return;
+    }
+
+    // cooks of previous versions of this asset are never loaded again, drop them; other
+    // assets' cooks in the same directory are left alone
+    // increment(error): the range-for form throws when advancing fails
+    const std::filesystem::directory_iterator end;
+    for (std::filesystem::directory_iterator it(_directory, error); !error && it != end;
+         it.increment(error)) {
+        const auto &path = it->path();
+        if (path != _path && isCookOf(path.filename().string(), _assetStem)) {
+            std::error_code removeError;
+            std::filesystem::remove(path, removeError);
+        }
+    }
+
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("Cooked scene cache %s: %zu bytes in %lld ms", _path.c_str(), offset,
+         static_cast<long long>(elapsedMs));
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <scene.h>
+#include <mappedfile.h>
+#include <workerpool.h>
+
+// rgba8 texture with its whole mip chain, level i follows level i-1 tightly packed
+struct CookedTexture {
+    uint32_t width{0};
+    uint32_t height{0};
+    uint32_t mipLevels{0};
+    std::span<const uint8_t> texels;
+};
+
+// everything loadGLB uploads, in upload-ready layout
+// views into the mapped cache file, valid as long as the SceneCache lives
+struct CookedScene {
+    // Vertex or QuantizedVertex, as requested from the SceneCache
+    std::span<const std::byte> vertices;
+    std::span<const uint32_t> indices;
+    std::span<const IndirectDrawForVulkan> indirectDraws;
+    // one per indirect draw, firstIndex into the composite index buffer
+    std::span<const DrawLods> drawLods;
+    std::span<const Material> materials;
+    std::span<const mat4x4f> instanceTransforms;
+    // empty when the scene was read without meshlets
+    std::span<const Meshlet> meshlets;
+    std::span<const uint32_t> meshletVertices;
+    std::span<const uint8_t> meshletTriangles;
+    std::vector<CookedTexture> textures;
+};
+
+// content hash of the source asset, keys the cooked file
+uint64_t hashSceneSource(std::span<const std::byte> bytes);
+
+// byte size of a tightly packed rgba8 mip chain
+size_t mipChainByteSize(uint32_t width, uint32_t height, uint32_t mipLevels);
+
+// versioned, mmap-able cooked scene: <directory>/<asset stem>-<source hash>.scene
+// a file cooked from another source, by another version or with another struct layout is
+// never loaded, so editing the asset or the loader invalidates it without any bookkeeping
+// the directory may be shared by several assets, each one only ever touches its own cooks
+class SceneCache {
+public:
+    // empty directory: caching disabled, load() always misses and store() does nothing
+    // assetName: path or name of the source asset, its stem prefixes the cooked file
+    // vertexStride: the vertex layout the caller uploads, a cook with another one is stale
+    SceneCache(const std::string &directory, const std::string &assetName, uint64_t sourceHash,
+               uint32_t vertexStride);
+
+    // false without a directory: load() always misses and store() does nothing
+    inline bool enabled() const {
+        return !_path.empty();
+    }
+
+    // maps the cooked file, false on miss or when the file is stale/corrupt
+    bool load();
+
+    inline const CookedScene &scene() const {
+        return _scene;
+    }
+
+    // cooks scene + its draw params and lod chains (mip chains generated on workerPool) and
+    // writes the file atomically; failures are logged, the cache is an optimization only
+    // srgbTextures: per scene texture, true when its texels are sRGB encoded (base color),
+    // those mips are filtered in linear space like on the gpu path
+    void store(const Scene &scene, std::span<const IndirectDrawForVulkan> indirectDraws,
+               std::span<const DrawLods> drawLods, const std::vector<bool> &srgbTextures,
+               WorkerPool &workerPool) const;
+
+private:
+    std::string _directory;
+    std::string _assetStem;
+    std::string _path;
+    uint64_t _sourceHash{0};
+    uint32_t _vertexStride{0};
+    std::unique_ptr<MappedFile> _file;
+    CookedScene _scene;
+};
@@ -0,0 +1,24 @@
+#include <algorithm>
+
+#include <scenegraph.h>
+
+void SceneGraph::updateWorldTransforms(WorkerPool &workerPool) {
+    worldTransforms.resize(size());
+    for (size_t level = 0; level < depth(); ++level) {
+        const size_t begin = levelOffsets[level];
+        const size_t end = levelOffsets[level + 1];
+        const size_t chunkCount = (end - begin + SCENE_GRAPH_CHUNK_SIZE - 1) /
+                                  SCENE_GRAPH_CHUNK_SIZE;
+        // parents live in earlier levels, which are complete by now
+        workerPool.parallelFor(chunkCount, [&](size_t chunk) {
+            const size_t first = begin + chunk * SCENE_GRAPH_CHUNK_SIZE;
+            const size_t last = std::min(first + SCENE_GRAPH_CHUNK_SIZE, end);
+            for (size_t i = first; i < last; ++i) {
+                worldTransforms[i] = parents[i] < 0
+                                     ? localTransforms[i]
+                                     : MatrixMultiply4x4(localTransforms[i],
+                                                         worldTransforms[parents[i]]);
+            }
+        });
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <matrix.h>
+#include <workerpool.h>
+
+// nodes flattened per level when a level is large enough to be worth fanning out
+constexpr size_t SCENE_GRAPH_CHUNK_SIZE = 1024;
+
+// node hierarchy as structure of arrays, sorted by depth: a parent always precedes its
+// children, so world transforms resolve one level at a time with every level in parallel
+struct SceneGraph {
+    // graph index of the parent, -1 for roots
+    std::vector<int32_t> parents;
+    // index of the node in the source document
+    std::vector<uint32_t> sourceNodes;
+    // source mesh index, -1: the node draws nothing
+    std::vector<int32_t> meshes;
+    std::vector<mat4x4f> localTransforms;
+    std::vector<mat4x4f> worldTransforms;
+    // nodes of depth d are [levelOffsets[d], levelOffsets[d + 1])
+    std::vector<uint32_t> levelOffsets;
+
+    inline size_t size() const {
+        return parents.size();
+    }
+
+    inline size_t depth() const {
+        return levelOffsets.empty() ? 0 : levelOffsets.size() - 1;
+    }
+
+    // world = local * parent world (row vectors), level by level
+    void updateWorldTransforms(WorkerPool &workerPool);
+};
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cstring>
+
+#include <spanstream.h>
+
+SpanStreamBuf::SpanStreamBuf(std::span<const std::byte> bytes) {
+    // streambuf api is non-const, but nothing below ever writes through the get area
+    auto begin = const_cast<char *>(reinterpret_cast<const char *>(bytes.data()));
+    setg(begin, begin, begin + bytes.size());
+}
+
+std::streamsize SpanStreamBuf::xsgetn(char_type *s, std::streamsize count) {
+    const auto n = std::min<std::streamsize>(count, egptr() - gptr());
+    if (n <= 0) {
+        return 0;
+    }
+    memcpy(s, gptr(), n);
+    // gbump takes an int, BIN chunks can be larger than that
+    setg(eback(), gptr() + n, egptr());
+    return n;
+}
+
+std::streamsize SpanStreamBuf::showmanyc() {
+    const auto n = egptr() - gptr();
+    return n > 0 ? n : -1;
+}
+
+SpanStreamBuf::pos_type SpanStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                               std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+    char *base{nullptr};
+    switch (dir) {
+        case std::ios_base::beg:
+            base = eback();
+            break;
+        case std::ios_base::cur:
+            base = gptr();
+            break;
+        case std::ios_base::end:
+            base = egptr();
+            break;
+        default:
+            return pos_type(off_type(-1));
+    }
+    // bounds check in offsets, pointer arithmetic past the span is ub
+    const off_type target = (base - eback()) + off;
+    if (target < 0 || target > egptr() - eback()) {
+        return pos_type(off_type(-1));
+    }
+    setg(eback(), eback() + target, egptr());
+    return pos_type(target);
+}
+
+SpanStreamBuf::pos_type SpanStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+SpanInputStream::SpanInputStream(std::span<const std::byte> bytes)
+        : std::istream(nullptr), _buf(bytes) {
+    rdbuf(&_buf);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <span>
+#include <streambuf>
+
+#include <GLTFSDK/IStreamReader.h>
+
+// read-only streambuf over caller-owned memory
+// the get area points straight into the span, nothing is copied until the consumer reads
+class SpanStreamBuf : public std::streambuf {
+public:
+    explicit SpanStreamBuf(std::span<const std::byte> bytes);
+
+protected:
+    std::streamsize xsgetn(char_type *s, std::streamsize count) override;
+
+    std::streamsize showmanyc() override;
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override;
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+class SpanInputStream : public std::istream {
+public:
+    explicit SpanInputStream(std::span<const std::byte> bytes);
+
+private:
+    SpanStreamBuf _buf;
+};
+
+// every GetInputStream() hands out an independent stream (own read cursor) over the same bytes
+// the span must outlive all streams handed out
+class SpanStreamReader : public Microsoft::glTF::IStreamReader {
+public:
+    explicit SpanStreamReader(std::span<const std::byte> bytes) : _bytes(bytes) {}
+
+    std::shared_ptr<std::istream> GetInputStream(const std::string &) const override {
+        return std::make_shared<SpanInputStream>(_bytes);
+    }
+
+private:
+    std::span<const std::byte> _bytes;
+};
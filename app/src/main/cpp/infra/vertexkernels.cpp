@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <vertexkernels.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VERTEX_KERNELS_AVX2 1
+#define VERTEX_KERNELS_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VERTEX_KERNELS_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VERTEX_KERNELS_NEON 1
+#endif
+
+// the interleave kernels write 6 dwords per vertex
+static_assert(sizeof(Vertex) == 6 * sizeof(float), "Vertex layout changed, update the kernels");
+static_assert(offsetof(Vertex, ux) == 3 * sizeof(float) &&
+              offsetof(Vertex, material) == 5 * sizeof(float),
+              "Vertex layout changed, update the kernels");
+// the shader reads QuantizedVertex as 3 dwords
+static_assert(sizeof(QuantizedVertex) == 3 * sizeof(uint32_t),
+              "QuantizedVertex layout changed, update common.glsl");
+
+const char *vertexKernelsIsa() {
+#if defined(VERTEX_KERNELS_AVX2)
+    return "avx2";
+#elif defined(VERTEX_KERNELS_SSE2)
+    return "sse2";
+#elif defined(VERTEX_KERNELS_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void widenIndices(const uint16_t *src, size_t count, uint32_t *dst) {
+    size_t i = 0;
+#if defined(VERTEX_KERNELS_AVX2)
+    for (; i + 16 <= count; i += 16) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_cvtepu16_epi32(lo));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 8), _mm256_cvtepu16_epi32(hi));
+    }
+#elif defined(VERTEX_KERNELS_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_unpacklo_epi16(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), _mm_unpackhi_epi16(v, zero));
+    }
+#elif defined(VERTEX_KERNELS_NEON)
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t v = vld1q_u16(src + i);
+        vst1q_u32(dst + i, vmovl_u16(vget_low_u16(v)));
+        vst1q_u32(dst + i + 4, vmovl_high_u16(v));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+void widenIndices(const uint8_t *src, size_t count, uint32_t *dst) {
+    size_t i = 0;
+#if defined(VERTEX_KERNELS_AVX2)
+    for (; i + 16 <= count; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_cvtepu8_epi32(v));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 8),
+                            _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+    }
+#elif defined(VERTEX_KERNELS_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 12), _mm_unpackhi_epi16(hi, zero));
+    }
+#elif defined(VERTEX_KERNELS_NEON)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t v = vld1q_u8(src + i);
+        const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        const uint16x8_t hi = vmovl_high_u8(v);
+        vst1q_u32(dst + i, vmovl_u16(vget_low_u16(lo)));
+        vst1q_u32(dst + i + 4, vmovl_high_u16(lo));
+        vst1q_u32(dst + i + 8, vmovl_u16(vget_low_u16(hi)));
+        vst1q_u32(dst + i + 12, vmovl_high_u16(hi));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = src[i];
+    }
+}
+
+// scalar on purpose: a convert + multiply loop the compiler vectorizes for every isa above
+template<typename T>
+static void dequantize(const T *src, size_t count, bool normalized, float *dst) {
+    if (!normalized) {
+        for (size_t i = 0; i < count; ++i) {
+            dst[i] = static_cast<float>(src[i]);
+        }
+        return;
+    }
+    constexpr float scale = 1.0f / static_cast<float>(std::numeric_limits<T>::max());
+    for (size_t i = 0; i < count; ++i) {
+        // snorm: the most negative value maps to -1 as well
+        dst[i] = std::max(static_cast<float>(src[i]) * scale, -1.0f);
+    }
+}
+
+void dequantizeComponents(const int8_t *src, size_t count, bool normalized, float *dst) {
+    dequantize(src, count, normalized, dst);
+}
+
+void dequantizeComponents(const uint8_t *src, size_t count, bool normalized, float *dst) {
+    dequantize(src, count, normalized, dst);
+}
+
+void dequantizeComponents(const int16_t *src, size_t count, bool normalized, float *dst) {
+    dequantize(src, count, normalized, dst);
+}
+
+void dequantizeComponents(const uint16_t *src, size_t count, bool normalized, float *dst) {
+    dequantize(src, count, normalized, dst);
+}
+
+void interleaveVertices(const float *positions, const float *uvs, uint32_t material,
+                        size_t count, Vertex *dst) {
+    size_t i = 0;
+    auto *out = reinterpret_cast<float *>(dst);
+#if defined(VERTEX_KERNELS_SSE2)
+    // 4 vertices per step: 3 position regs + 2 uv regs + material -> 6 output regs
+    //   p0 = x0 y0 z0 x1, p1 = y1 z1 x2 y2, p2 = z2 x3 y3 z3
+    //   u0 = u0 v0 u1 v1, u1 = u2 v2 u3 v3
+    const __m128 m = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(material)));
+    for (; i + 4 <= count; i += 4) {
+        const float *p = positions + i * 3;
+        const __m128 p0 = _mm_loadu_ps(p);
+        const __m128 p1 = _mm_loadu_ps(p + 4);
+        const __m128 p2 = _mm_loadu_ps(p + 8);
+        const __m128 u0 = uvs ? _mm_loadu_ps(uvs + i * 2) : _mm_setzero_ps();
+        const __m128 u1 = uvs ? _mm_loadu_ps(uvs + i * 2 + 4) : _mm_setzero_ps();
+
+        // x0 y0 z0 u0
+        const __m128 zu0 = _mm_shuffle_ps(p0, u0, _MM_SHUFFLE(0, 0, 2, 2));
+        const __m128 o0 = _mm_shuffle_ps(p0, zu0, _MM_SHUFFLE(2, 0, 1, 0));
+        // v0 m x1 y1
+        const __m128 vm0 = _mm_shuffle_ps(u0, m, _MM_SHUFFLE(0, 0, 1, 1));
+        const __m128 xy1 = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0, 0, 3, 3));
+        const __m128 o1 = _mm_shuffle_ps(vm0, xy1, _MM_SHUFFLE(2, 0, 2, 0));
+        // z1 u1 v1 m
+        const __m128 zu1 = _mm_shuffle_ps(p1, u0, _MM_SHUFFLE(2, 2, 1, 1));
+        const __m128 vm1 = _mm_shuffle_ps(u0, m, _MM_SHUFFLE(0, 0, 3, 3));
+        const __m128 o2 = _mm_shuffle_ps(zu1, vm1, _MM_SHUFFLE(2, 0, 2, 0));
+        // x2 y2 z2 u2
+        const __m128 xyz2 = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(0, 0, 3, 2));
+        const __m128 zu2 = _mm_shuffle_ps(p2, u1, _MM_SHUFFLE(0, 0, 0, 0));
+        const __m128 o3 = _mm_shuffle_ps(xyz2, zu2, _MM_SHUFFLE(2, 0, 1, 0));
+        // v2 m x3 y3
+        const __m128 vm2 = _mm_shuffle_ps(u1, m, _MM_SHUFFLE(0, 0, 1, 1));
+        const __m128 xy3 = _mm_shuffle_ps(p2, p2, _MM_SHUFFLE(2, 2, 1, 1));
+        const __m128 o4 = _mm_shuffle_ps(vm2, xy3, _MM_SHUFFLE(2, 0, 2, 0));
+        // z3 u3 v3 m
+        const __m128 zu3 = _mm_shuffle_ps(p2, u1, _MM_SHUFFLE(2, 2, 3, 3));
+        const __m128 vm3 = _mm_shuffle_ps(u1, m, _MM_SHUFFLE(0, 0, 3, 3));
+        const __m128 o5 = _mm_shuffle_ps(zu3, vm3, _MM_SHUFFLE(2, 0, 2, 0));
+
+        float *o = out + i * 6;
+        _mm_storeu_ps(o, o0);
+        _mm_storeu_ps(o + 4, o1);
+        _mm_storeu_ps(o + 8, o2);
+        _mm_storeu_ps(o + 12, o3);
+        _mm_storeu_ps(o + 16, o4);
+        _mm_storeu_ps(o + 20, o5);
+    }
+#elif defined(VERTEX_KERNELS_NEON)
+    // a Vertex is 3 float pairs: (x y) (z u) (v m)
+    // zip the pairs, then a 3-way 64-bit interleaving store writes 2 whole vertices
+    const float32x4_t m = vreinterpretq_f32_u32(vdupq_n_u32(material));
+    for (; i + 4 <= count; i += 4) {
+        const float32x4x3_t p = vld3q_f32(positions + i * 3);
+        const float32x4x2_t uv = uvs ? vld2q_f32(uvs + i * 2)
+                                     : float32x4x2_t{{vdupq_n_f32(0.0f), vdupq_n_f32(0.0f)}};
+        uint64x2x3_t lo;
+        lo.val[0] = vreinterpretq_u64_f32(vzip1q_f32(p.val[0], p.val[1]));
+        lo.val[1] = vreinterpretq_u64_f32(vzip1q_f32(p.val[2], uv.val[0]));
+        lo.val[2] = vreinterpretq_u64_f32(vzip1q_f32(uv.val[1], m));
+        uint64x2x3_t hi;
+        hi.val[0] = vreinterpretq_u64_f32(vzip2q_f32(p.val[0], p.val[1]));
+        hi.val[1] = vreinterpretq_u64_f32(vzip2q_f32(p.val[2], uv.val[0]));
+        hi.val[2] = vreinterpretq_u64_f32(vzip2q_f32(uv.val[1], m));
+        vst3q_u64(reinterpret_cast<uint64_t *>(out + i * 6), lo);
+        vst3q_u64(reinterpret_cast<uint64_t *>(out + i * 6 + 12), hi);
+    }
+#endif
+    for (; i < count; ++i) {
+        Vertex &vertex = dst[i];
+        vertex.vx = positions[i * 3];
+        vertex.vy = positions[i * 3 + 1];
+        vertex.vz = positions[i * 3 + 2];
+        vertex.ux = uvs ? uvs[i * 2] : 0.0f;
+        vertex.uy = uvs ? uvs[i * 2 + 1] : 0.0f;
+        vertex.material = material;
+    }
+}
+
+void reducePositionBounds(const float *positions, size_t count, float minOut[3], float maxOut[3]) {
+    size_t i = 0;
+    float lo[12];
+    float hi[12];
+    for (size_t lane = 0; lane < 12; ++lane) {
+        lo[lane] = minOut[lane % 3];
+        hi[lane] = maxOut[lane % 3];
+    }
+#if defined(VERTEX_KERNELS_SSE2)
+    // 4 vertices = 12 floats = 3 regs, lane j always holds component j % 3
+    __m128 lo0 = _mm_loadu_ps(lo), lo1 = _mm_loadu_ps(lo + 4), lo2 = _mm_loadu_ps(lo + 8);
+    __m128 hi0 = _mm_loadu_ps(hi), hi1 = _mm_loadu_ps(hi + 4), hi2 = _mm_loadu_ps(hi + 8);
+    for (; i + 4 <= count; i += 4) {
+        const float *p = positions + i * 3;
+        const __m128 p0 = _mm_loadu_ps(p);
+        const __m128 p1 = _mm_loadu_ps(p + 4);
+        const __m128 p2 = _mm_loadu_ps(p + 8);
+        lo0 = _mm_min_ps(lo0, p0);
+        lo1 = _mm_min_ps(lo1, p1);
+        lo2 = _mm_min_ps(lo2, p2);
+        hi0 = _mm_max_ps(hi0, p0);
+        hi1 = _mm_max_ps(hi1, p1);
+        hi2 = _mm_max_ps(hi2, p2);
+    }
+    _mm_storeu_ps(lo, lo0), _mm_storeu_ps(lo + 4, lo1), _mm_storeu_ps(lo + 8, lo2);
+    _mm_storeu_ps(hi, hi0), _mm_storeu_ps(hi + 4, hi1), _mm_storeu_ps(hi + 8, hi2);
+#elif defined(VERTEX_KERNELS_NEON)
+    // deinterleaving load: one reg per component
+    float32x4_t lox = vdupq_n_f32(minOut[0]), loy = vdupq_n_f32(minOut[1]), loz = vdupq_n_f32(minOut[2]);
+    float32x4_t hix = vdupq_n_f32(maxOut[0]), hiy = vdupq_n_f32(maxOut[1]), hiz = vdupq_n_f32(maxOut[2]);
+    for (; i + 4 <= count; i += 4) {
+        const float32x4x3_t p = vld3q_f32(positions + i * 3);
+        lox = vminq_f32(lox, p.val[0]);
+        loy = vminq_f32(loy, p.val[1]);
+        loz = vminq_f32(loz, p.val[2]);
+        hix = vmaxq_f32(hix, p.val[0]);
+        hiy = vmaxq_f32(hiy, p.val[1]);
+        hiz = vmaxq_f32(hiz, p.val[2]);
+    }
+    lo[0] = vminvq_f32(lox), lo[1] = vminvq_f32(loy), lo[2] = vminvq_f32(loz);
+    hi[0] = vmaxvq_f32(hix), hi[1] = vmaxvq_f32(hiy), hi[2] = vmaxvq_f32(hiz);
+#endif
+    for (size_t lane = 0; lane < 12; ++lane) {
+        minOut[lane % 3] = std::min(minOut[lane % 3], lo[lane]);
+        maxOut[lane % 3] = std::max(maxOut[lane % 3], hi[lane]);
+    }
+    for (; i < count; ++i) {
+        for (size_t c = 0; c < 3; ++c) {
+            minOut[c] = std::min(minOut[c], positions[i * 3 + c]);
+            maxOut[c] = std::max(maxOut[c], positions[i * 3 + c]);
+        }
+    }
+}
+
+// ieee binary16, round to nearest even, overflow to inf
+static uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t magnitude = bits & 0x7fffffffu;
+    if (magnitude >= 0x7f800000u) {
+        // inf stays inf, nan stays a (quiet) nan
+        return static_cast<uint16_t>(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u));
+    }
+    if (magnitude >= 0x477ff000u) {
+        // rounds past 65504
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+    if (magnitude < 0x38800000u) {
+        // below 2^-14: half subnormal (mantissa * 2^-24) or zero
+        if (magnitude < 0x33000000u) {
+            return static_cast<uint16_t>(sign);
+        }
+        const uint32_t shift = 126 - (magnitude >> 23);
+        const uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t midpoint = 1u << (shift - 1);
+        if (remainder > midpoint || (remainder == midpoint && (half & 1u))) {
+            ++half;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+    // rebias the exponent (127 -> 15), a mantissa carry rolls into the exponent
+    const uint32_t rebiased = magnitude - 0x38000000u;
+    return static_cast<uint16_t>(sign | ((rebiased + 0xfffu + ((rebiased >> 13) & 1u)) >> 13));
+}
+
+static uint8_t snorm8(float v) {
+    const float clamped = std::clamp(v, -1.0f, 1.0f);
+    return static_cast<uint8_t>(static_cast<int8_t>(std::lround(clamped * 127.0f)));
+}
+
+// octahedral mapping of a unit vector, packed as 2 x snorm8
+static uint16_t encodeOctahedral(float x, float y, float z) {
+    const float l1 = std::abs(x) + std::abs(y) + std::abs(z);
+    if (l1 == 0.0f) {
+        return static_cast<uint16_t>(snorm8(0.0f) | (snorm8(0.0f) << 8));
+    }
+    float ox = x / l1;
+    float oy = y / l1;
+    if (z < 0.0f) {
+        // fold the lower hemisphere over the diagonals
+        const float fx = (1.0f - std::abs(oy)) * (ox >= 0.0f ? 1.0f : -1.0f);
+        const float fy = (1.0f - std::abs(ox)) * (oy >= 0.0f ? 1.0f : -1.0f);
+        ox = fx;
+        oy = fy;
+    }
+    return static_cast<uint16_t>(snorm8(ox) | (snorm8(oy) << 8));
+}
+
+void quantizeVertices(const Vertex *src, const float *normals, size_t count,
+                      const float boundsMin[3], const float boundsMax[3], QuantizedVertex *dst) {
+    // a flat axis quantizes to 0 and dequantizes back to boundsMin
+    float scale[3];
+    for (size_t c = 0; c < 3; ++c) {
+        const float extent = boundsMax[c] - boundsMin[c];
+        scale[c] = extent > 0.0f ? 65535.0f / extent : 0.0f;
+    }
+    auto unorm16 = [&](float p, size_t c) {
+        const float q = std::clamp((p - boundsMin[c]) * scale[c], 0.0f, 65535.0f);
+        return static_cast<uint16_t>(q + 0.5f);
+    };
+    for (size_t i = 0; i < count; ++i) {
+        const Vertex &vertex = src[i];
+        dst[i] = QuantizedVertex{
+                .px = unorm16(vertex.vx, 0),
+                .py = unorm16(vertex.vy, 1),
+                .pz = unorm16(vertex.vz, 2),
+                .normal = normals ? encodeOctahedral(normals[i * 3], normals[i * 3 + 1],
+                                                     normals[i * 3 + 2])
+                                  : encodeOctahedral(0.0f, 0.0f, 1.0f),
+                .u = floatToHalf(vertex.ux),
+                .v = floatToHalf(vertex.uy),
+        };
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <scene.h>
+
+// bulk kernels for the glb loader
+// compile-time dispatch: avx2 / sse2 on x86, neon on aarch64, scalar otherwise
+// destinations must already be sized, nothing here allocates
+
+// u16 index stream -> u32
+void widenIndices(const uint16_t *src, size_t count, uint32_t *dst);
+
+// u8 index stream -> u32
+void widenIndices(const uint8_t *src, size_t count, uint32_t *dst);
+
+// KHR_mesh_quantization component streams -> float
+// normalized: glTF unorm/snorm rules (c / 255, max(c / 127, -1), ...), otherwise plain casts
+void dequantizeComponents(const int8_t *src, size_t count, bool normalized, float *dst);
+
+void dequantizeComponents(const uint8_t *src, size_t count, bool normalized, float *dst);
+
+void dequantizeComponents(const int16_t *src, size_t count, bool normalized, float *dst);
+
+void dequantizeComponents(const uint16_t *src, size_t count, bool normalized, float *dst);
+
+// positions: vec3f stream, uvs: vec2f stream (nullptr: zero uvs)
+// writes count Vertex {pos, uv, material}
+void interleaveVertices(const float *positions, const float *uvs, uint32_t material,
+                        size_t count, Vertex *dst);
+
+// component-wise min/max of a vec3f stream, folded into minOut/maxOut
+void reducePositionBounds(const float *positions, size_t count, float minOut[3], float maxOut[3]);
+
+// Vertex stream -> QuantizedVertex, positions relative to [boundsMin, boundsMax]
+// normals: vec3f stream (nullptr: +z)
+void quantizeVertices(const Vertex *src, const float *normals, size_t count,
+                      const float boundsMin[3], const float boundsMax[3], QuantizedVertex *dst);
+
+// name of the kernel set compiled in, for logs
+const char *vertexKernelsIsa();
@@ -0,0 +1,99 @@
+#include <algorithm>
+
+#include <workerpool.h>
+
+WorkerPool::WorkerPool(uint32_t concurrency) {
+    const uint32_t numWorkers = std::max(concurrency, 1u) - 1;
+    _workers.reserve(numWorkers);
+    for (uint32_t i = 0; i < numWorkers; ++i) {
+        _workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto &worker: _workers) {
+        worker.join();
+    }
+}
+
+uint32_t WorkerPool::hardwareConcurrency() {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)> &fn) {
+    if (count == 0) {
+        return;
+    }
+    // nothing to fan out: stay on the calling thread
+    if (_workers.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = &fn;
+        _jobCount = count;
+        _next.store(0);
+        _error = nullptr;
+        _busyWorkers = _workers.size();
+        ++_generation;
+    }
+    _wake.notify_all();
+
+    runJob();
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this] { return _busyWorkers == 0; });
+        _job = nullptr;
+        error = _error;
+        _error = nullptr;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkerPool::runJob() {
+    for (size_t i = _next.fetch_add(1); i < _jobCount; i = _next.fetch_add(1)) {
+        try {
+            (*_job)(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_error) {
+                _error = std::current_exception();
+            }
+            // drain the remaining indices
+            _next.store(_jobCount);
+        }
+    }
+}
+
+void WorkerPool::workerLoop() {
+    uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&] { return _stop || _generation != seenGeneration; });
+            if (_stop) {
+                return;
+            }
+            seenGeneration = _generation;
+        }
+        runJob();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busyWorkers == 0) {
+                _done.notify_one();
+            }
+        }
+    }
+}
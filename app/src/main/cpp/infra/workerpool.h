@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed-size pool of worker threads for load-time fork/join work
+// the calling thread takes part in every parallelFor, so concurrency 1 spawns no thread at all
+class WorkerPool {
+public:
+    explicit WorkerPool(uint32_t concurrency);
+
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    inline uint32_t concurrency() const {
+        return static_cast<uint32_t>(_workers.size()) + 1;
+    }
+
+    // runs fn(i) for every i in [0, count) and blocks until all of them returned
+    // the first exception thrown by fn is rethrown here, remaining indices are skipped
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+    // std::thread::hardware_concurrency() may report 0
+    static uint32_t hardwareConcurrency();
+
+private:
+    void workerLoop();
+
+    void runJob();
+
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    bool _stop{false};
+    uint64_t _generation{0};
+    size_t _busyWorkers{0};
+
+    // current job, published under _mutex before _generation is bumped
+    const std::function<void(size_t)> *_job{nullptr};
+    size_t _jobCount{0};
+    std::atomic<size_t> _next{0};
+    std::exception_ptr _error;
+};
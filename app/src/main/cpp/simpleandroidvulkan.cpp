@@ -17,12 +17,18 @@ struct VulkanEngine {
     bool canRender{false};
 };
 
+// app-private storage, some old devices leave it null
+static std::string internalDataPath(struct android_app *app) {
+    return app->activity->internalDataPath ? app->activity->internalDataPath : "";
+}
+
 static void VulkanEngineHandleCmd(struct android_app *app, int32_t cmd) {
     auto *engine = (VulkanEngine *) app->userData;
     switch (cmd) {
         case APP_CMD_START:
             if (engine->androidApp->window != nullptr) {
-                engine->vkApp->reset(app->window, app->activity->assetManager);
+                engine->vkApp->reset(app->window, app->activity->assetManager,
+                                     internalDataPath(app));
                 engine->vkApp->initVulkan();
                 engine->canRender = true;
             }
@@ -31,7 +37,8 @@ static void VulkanEngineHandleCmd(struct android_app *app, int32_t cmd) {
             LOGI("Called - APP_CMD_INIT_WINDOW");
             if (engine->androidApp->window != nullptr) {
                 LOGI("Setting a new surface");
-                engine->vkApp->reset(app->window, app->activity->assetManager);
+                engine->vkApp->reset(app->window, app->activity->assetManager,
+                                     internalDataPath(app));
                 if (!engine->vkApp->isInitialized()) {
                     LOGI("Starting application");
                     engine->vkApp->initVulkan();
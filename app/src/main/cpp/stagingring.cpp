@@ -0,0 +1,131 @@
+#include <cstring>
+
+#include <misc.h>
+#include <stagingring.h>
+
+// host cached when available: a cold load reads the staged geometry back to store the scene
+// cache, uncached reads there would crawl
+static const VmaAllocationCreateInfo STAGING_ALLOCATION_CREATE_INFO = {
+        .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
+                 VMA_ALLOCATION_CREATE_MAPPED_BIT,
+        .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+        .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        .preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+};
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+StagingRing::~StagingRing() {
+    destroy();
+}
+
+void StagingRing::create(VmaAllocator allocator, VkDeviceSize capacity) {
+    ASSERT(_buffer == VK_NULL_HANDLE, "StagingRing created twice");
+    ASSERT(capacity > 0 && capacity % STAGING_RING_MAX_ALIGNMENT == 0,
+           "StagingRing capacity should be a multiple of STAGING_RING_MAX_ALIGNMENT");
+    _allocator = allocator;
+    _capacity = capacity;
+    VkBufferCreateInfo bufferCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = capacity,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    VmaAllocationInfo allocationInfo{};
+    VK_CHECK(vmaCreateBuffer(_allocator, &bufferCreateInfo, &STAGING_ALLOCATION_CREATE_INFO,
+                             &_buffer, &_allocation, &allocationInfo));
+    _mapped = static_cast<std::byte *>(allocationInfo.pMappedData);
+    _head = 0;
+    _tail = 0;
+}
+
+void StagingRing::destroy() {
+    if (_allocator == VK_NULL_HANDLE) {
+        return;
+    }
+    release(UINT64_MAX);
+    for (const auto &dedicated: _dedicated) {
+        vmaDestroyBuffer(_allocator, dedicated.buffer, dedicated.allocation);
+    }
+    _dedicated.clear();
+    if (_buffer != VK_NULL_HANDLE) {
+        vmaDestroyBuffer(_allocator, _buffer, _allocation);
+    }
+    _buffer = VK_NULL_HANDLE;
+    _allocation = VK_NULL_HANDLE;
+    _mapped = nullptr;
+    _allocator = VK_NULL_HANDLE;
+}
+
+StagingRing::Allocation StagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    ASSERT(_buffer != VK_NULL_HANDLE, "StagingRing used before create");
+    ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0 &&
+           alignment <= STAGING_RING_MAX_ALIGNMENT, "StagingRing alignment out of range");
+    if (size > _capacity) {
+        return allocateDedicated(size);
+    }
+    const VkDeviceSize offset = _head % _capacity;
+    VkDeviceSize start = alignUp(offset, alignment);
+    if (start + size > _capacity) {
+        // never straddle the end: the rest of the ring becomes padding of this batch
+        start = 0;
+    }
+    const uint64_t end = _head + (start >= offset ? start - offset : _capacity - offset) + size;
+    if (end - _tail > _capacity) {
+        // the free part is too small until older batches complete, don't wait on them
+        return allocateDedicated(size);
+    }
+    _head = end;
+    return {_buffer, start, {_mapped + start, size}};
+}
+
+StagingRing::Allocation StagingRing::stage(const void *data, VkDeviceSize size,
+                                           VkDeviceSize alignment) {
+    const auto allocation = allocate(size, alignment);
+    memcpy(allocation.memory.data(), data, size);
+    return allocation;
+}
+
+StagingRing::Allocation StagingRing::allocateDedicated(VkDeviceSize size) {
+    LOGI("StagingRing: %llu bytes do not fit (%llu of %llu in flight), dedicated buffer",
+         static_cast<unsigned long long>(size), static_cast<unsigned long long>(inFlight()),
+         static_cast<unsigned long long>(_capacity));
+    VkBufferCreateInfo bufferCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = size,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    Dedicated dedicated;
+    VmaAllocationInfo allocationInfo{};
+    VK_CHECK(vmaCreateBuffer(_allocator, &bufferCreateInfo, &STAGING_ALLOCATION_CREATE_INFO,
+                             &dedicated.buffer, &dedicated.allocation, &allocationInfo));
+    _dedicated.push_back(dedicated);
+    return {dedicated.buffer, 0,
+            {static_cast<std::byte *>(allocationInfo.pMappedData), size}};
+}
+
+void StagingRing::endBatch(uint64_t value) {
+    ASSERT(_batches.empty() || _batches.back().value <= value,
+           "StagingRing batch values should not decrease");
+    const uint64_t previousHead = _batches.empty() ? _tail : _batches.back().head;
+    if (_head == previousHead && _dedicated.empty()) {
+        return;
+    }
+    _batches.push_back({.value = value, .head = _head, .dedicated = std::move(_dedicated)});
+    _dedicated.clear();
+}
+
+void StagingRing::release(uint64_t completedValue) {
+    while (!_batches.empty() && _batches.front().value <= completedValue) {
+        auto &batch = _batches.front();
+        _tail = batch.head;
+        for (const auto &dedicated: batch.dedicated) {
+            vmaDestroyBuffer(_allocator, dedicated.buffer, dedicated.allocation);
+        }
+        _batches.pop_front();
+    }
+}
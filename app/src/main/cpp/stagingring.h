@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+// copy offsets handed out by the ring: covers every texel size we upload
+static constexpr VkDeviceSize STAGING_RING_DEFAULT_ALIGNMENT = 16;
+static constexpr VkDeviceSize STAGING_RING_MAX_ALIGNMENT = 256;
+
+// one persistently mapped, host-visible buffer every host -> device upload stages through
+// allocations are handed out in recording order and retired in batches:
+// endBatch(value) tags everything allocated since the previous batch with a monotonically
+// increasing value (upload serial, timeline semaphore value), release(completedValue) reclaims
+// every batch the device is done with
+// a request that does not fit in the free part of the ring gets a dedicated buffer retired with
+// the same batch: a cold load of a large scene still works, and memory never stays above
+// capacity once its batch completed
+class StagingRing {
+public:
+    struct Allocation {
+        VkBuffer buffer{VK_NULL_HANDLE};
+        // srcOffset / bufferOffset of the copy out of buffer
+        VkDeviceSize offset{0};
+        // mapped and coherent, valid until the batch it belongs to is released
+        std::span<std::byte> memory;
+    };
+
+    StagingRing() = default;
+    StagingRing(const StagingRing &) = delete;
+    StagingRing &operator=(const StagingRing &) = delete;
+    ~StagingRing();
+
+    // capacity: multiple of STAGING_RING_MAX_ALIGNMENT
+    void create(VmaAllocator allocator, VkDeviceSize capacity);
+    // every batch has to be released (or the device idle) by now
+    void destroy();
+
+    // alignment: power of two, at most STAGING_RING_MAX_ALIGNMENT
+    Allocation allocate(VkDeviceSize size,
+                        VkDeviceSize alignment = STAGING_RING_DEFAULT_ALIGNMENT);
+    // allocate + memcpy
+    Allocation stage(const void *data, VkDeviceSize size,
+                     VkDeviceSize alignment = STAGING_RING_DEFAULT_ALIGNMENT);
+
+    // everything allocated since the previous endBatch is in flight until value completes
+    void endBatch(uint64_t value);
+    // reclaims the batches whose value is <= completedValue, oldest first
+    void release(uint64_t completedValue);
+
+    inline VkDeviceSize capacity() const {
+        return _capacity;
+    }
+
+    // ring bytes not yet released, padding included
+    inline VkDeviceSize inFlight() const {
+        return _head - _tail;
+    }
+
+private:
+    struct Dedicated {
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VmaAllocation allocation{VK_NULL_HANDLE};
+    };
+    struct Batch {
+        uint64_t value{0};
+        // ring position right behind the batch's last allocation
+        uint64_t head{0};
+        std::vector<Dedicated> dedicated;
+    };
+
+    Allocation allocateDedicated(VkDeviceSize size);
+
+    VmaAllocator _allocator{VK_NULL_HANDLE};
+    VkBuffer _buffer{VK_NULL_HANDLE};
+    VmaAllocation _allocation{VK_NULL_HANDLE};
+    std::byte *_mapped{nullptr};
+    VkDeviceSize _capacity{0};
+    // absolute byte positions, offset in the buffer is position % capacity
+    // [_tail, _head) is in use: recorded or in flight
+    uint64_t _head{0};
+    uint64_t _tail{0};
+    // dedicated buffers of the batch being recorded
+    std::vector<Dedicated> _dedicated;
+    std::deque<Batch> _batches;
+};
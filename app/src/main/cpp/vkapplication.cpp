@@ -1,3 +1,4 @@
+#include <chrono>
 #include <format>
 #include <vkapplication.h>
 //#define VK_NO_PROTOTYPES // for volk
@@ -11,14 +12,48 @@
 #include <misc.h>
 #include <ktx.h>
 #include <ktxvulkan.h>
+#include <ktxetc.h>
 
 #include <glb.h>
+#include <meshstages.h>
+#include <scenecache.h>
 
 
 // triple-buffer
 static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
 static constexpr int MAX_DESCRIPTOR_SETS = 1 * MAX_FRAMES_IN_FLIGHT + 1 + 4;
 //static constexpr int MAX_DESCRIPTOR_SETS = 1000;
+// opt-in: glb vertices as 12-byte QuantizedVertex, drawn with indirectdraw_quantized.vert
+static constexpr bool QUANTIZE_GLB_VERTICES = false;
+// vertical fov of the projection, radians
+static constexpr float CAMERA_VFOV = 0.8f;
+// a coarser lod is drawn while its error projects to less than this many pixels
+static constexpr float LOD_PIXEL_ERROR = 1.0f;
+// every upload stages through one ring, requests that don't fit get a dedicated buffer
+static constexpr VkDeviceSize STAGING_RING_CAPACITY = 32 * 1024 * 1024;
+// every way an uploaded buffer is consumed by the graphics queue (vertex pulling, index,
+// indirect, shader storage), the acquire side of its ownership transfer waits for all of them
+static constexpr VkPipelineStageFlags UPLOADED_BUFFER_DST_STAGES =
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+static constexpr VkAccessFlags UPLOADED_BUFFER_DST_ACCESS =
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+// glb mip chains: single-pass compute downsampler (mipdownsample.comp), blits when off
+static constexpr bool COMPUTE_MIP_GENERATION = true;
+// the downsampler takes level 7 on out of one 64x64 tile of level 6: at most 13 levels
+static constexpr uint32_t MIP_DOWNSAMPLE_MAX_SIZE = 4096;
+static constexpr uint32_t MIP_DOWNSAMPLE_MAX_LEVELS = 13;
+static constexpr uint32_t MIP_DOWNSAMPLE_TILE_SIZE = 64;
+// push constants of mipdownsample.glsl
+struct MipDownsampleParams {
+    int32_t width;
+    int32_t height;
+    uint32_t levelCount;
+    uint32_t srgb;
+    uint32_t counterIndex;
+};
 // Default fence timeout in nanoseconds
 #define DEFAULT_FENCE_TIMEOUT 100000000000
 
@@ -35,6 +70,7 @@ void VkApplication::initVulkan() {
     createLogicDevice();
     cacheCommandQueue();
     createVMA();
+    _stagingRing.create(_vmaAllocator, STAGING_RING_CAPACITY);
     prepareSwapChainCreation();
     createSwapChain();
     createSwapChainImageViews();
@@ -46,18 +82,24 @@ void VkApplication::initVulkan() {
 
     // application logic
     createGraphicsPipeline();
+    if (COMPUTE_MIP_GENERATION) {
+        createMipDownsamplePipeline();
+    }
     createSwapChainFramebuffers();
     createCommandPool();
     createCommandBuffer();
     createPerFrameSyncObjects();
     // vao, textures and glb all depends on host-device io
-    // one-time commandBuffer _uploadCmd
+    // copies go to _uploadCmd (transfer queue), mips and acquires to _uploadGraphicsCmd
     preHostDeviceIO();
     loadVao();
     // must prior to bindResourceToDescriptorSets due to imageView
     loadTextures();
     loadGLB();
     postHostDeviceIO();
+    // the uploads are submitted: the next launch's cook no longer competes with them
+    startSceneCook();
+    createLodIndirectDrawBuffers();
     bindResourceToDescriptorSets();
 
     _initialized = true;
@@ -75,9 +117,11 @@ debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
     return VK_FALSE;
 }
 
-void VkApplication::reset(ANativeWindow *osWindow, AAssetManager *assetManager) {
+void VkApplication::reset(ANativeWindow *osWindow, AAssetManager *assetManager,
+                          const std::string &cacheDirectory) {
     _osWindow.reset(osWindow);
     _assetManager = assetManager;
+    _cacheDirectory = cacheDirectory;
     if (_initialized) {
         // window properties: size/format changed
         createSurface();
@@ -86,19 +130,27 @@ void VkApplication::reset(ANativeWindow *osWindow, AAssetManager *assetManager)
 }
 
 void VkApplication::teardown() {
+    // a cook still running finishes its file, the scene it reads is its own
+    if (_sceneCookThread.joinable()) {
+        _sceneCookThread.join();
+    }
     vkDeviceWaitIdle(_logicalDevice);
     deleteSwapChain();
 
-    // delete io fence
-    vkDestroyFence(_logicalDevice, _ioFence, nullptr);
-    // free cmdBuffer for io purpose
-    vkFreeCommandBuffers(_logicalDevice, _commandPool, 1, &_uploadCmd);
+    // the device is idle: every upload completed
+    reclaimUploads(UINT64_MAX);
+    vkDestroySemaphore(_logicalDevice, _uploadTimeline, nullptr);
+    vkDestroyCommandPool(_logicalDevice, _transferCommandPool, nullptr);
 
     // texture
     vkDestroyImageView(_logicalDevice, _imageView, nullptr);
+#if defined(LINEAR_TILED_IMAGES)
     vkDestroyImage(_logicalDevice, _image, nullptr);
+#else
+    // vmaDestroyImage through the callbacks that created it: image and allocation together
+    ktxVulkanTexture_DestructWithCallbacks(&_vkTexture, &_ktxUploadCallbacks);
+#endif
     vkDestroySampler(_logicalDevice, _sampler, nullptr);
-    vmaFreeMemory(_vmaAllocator, _vmaImageAllocation);
 
     // glb
     for (const auto &imageView: _glbImageViews) {
@@ -107,9 +159,16 @@ void VkApplication::teardown() {
     ASSERT(_glbImages.size() == _glbImageAllocation.size(),
            "_glbImages'size should == _glbImageAllocation's size");
     for (int i = 0; i < _glbImages.size(); ++i) {
-        vkDestroyImage(_logicalDevice, _glbImages[i], nullptr);
         vmaDestroyImage(_vmaAllocator, _glbImages[i], _glbImageAllocation[i]);
     }
+    for (const auto &[buffer, allocation]: _glbDeviceBuffers) {
+        vmaDestroyBuffer(_vmaAllocator, buffer, allocation);
+    }
+    _glbDeviceBuffers.clear();
+
+    // vao
+    vmaDestroyBuffer(_vmaAllocator, _deviceVb, _deviceVbAllocation);
+    vmaDestroyBuffer(_vmaAllocator, _deviceIb, _deviceIbAllocation);
 
     // shader data
     vkDestroyDescriptorPool(_logicalDevice, _descriptorSetPool, nullptr);
@@ -122,6 +181,10 @@ void VkApplication::teardown() {
         // unmap a buffer not mapped will crash
         // vmaUnmapMemory(_vmaAllocator, _vmaAllocations[i]);
         vmaDestroyBuffer(_vmaAllocator, _uniformBuffers[i], _vmaAllocations[i]);
+        if (!_lodIndirectDrawBuffers.empty()) {
+            vmaDestroyBuffer(_vmaAllocator, _lodIndirectDrawBuffers[i],
+                             _lodIndirectDrawAllocations[i]);
+        }
         // sync
         vkDestroySemaphore(_logicalDevice, _imageCanAcquireSemaphores[i], nullptr);
         vkDestroySemaphore(_logicalDevice, _imageRendereredSemaphores[i], nullptr);
@@ -129,10 +192,15 @@ void VkApplication::teardown() {
     }
 
     vkDestroyCommandPool(_logicalDevice, _commandPool, nullptr);
+    vkDestroyPipeline(_logicalDevice, _mipDownsamplePipeline, nullptr);
+    vkDestroyPipelineLayout(_logicalDevice, _mipDownsamplePipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(_logicalDevice, _mipDownsampleSetLayout, nullptr);
     vkDestroyPipeline(_logicalDevice, _graphicsPipeline, nullptr);
     vkDestroyPipelineLayout(_logicalDevice, _pipelineLayout, nullptr);
     vkDestroyRenderPass(_logicalDevice, _swapChainRenderPass, nullptr);
 
+    // the device is idle: every staging batch is complete
+    _stagingRing.destroy();
     vmaDestroyAllocator(_vmaAllocator);
 
     vkDestroyDevice(_logicalDevice, nullptr);
@@ -155,6 +223,10 @@ void VkApplication::renderPerFrame() {
     // no timeout set
     VK_CHECK(vkWaitForFences(_logicalDevice, 1, &_inFlightFences[_currentFrameId], VK_TRUE,
                              UINT64_MAX));
+    // never waits: recycles whatever uploads the device finished meanwhile
+    uint64_t completedUpload = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(_logicalDevice, _uploadTimeline, &completedUpload));
+    reclaimUploads(completedUpload);
     //VK_CHECK(vkResetFences(device_, 1, &acquireFence_));
     uint32_t swapChainImageIndex;
     VkResult result = vkAcquireNextImageKHR(
@@ -167,6 +239,7 @@ void VkApplication::renderPerFrame() {
     assert(result == VK_SUCCESS ||
            result == VK_SUBOPTIMAL_KHR);  // failed to acquire swap chain image
     updateUniformBuffer(_currentFrameId);
+    selectGlbLods(_currentFrameId);
 
     // vkWaitForFences and reset pattern
     VK_CHECK(vkResetFences(_logicalDevice, 1, &_inFlightFences[_currentFrameId]));
@@ -517,6 +590,10 @@ void VkApplication::queryPhysicalDeviceCaps() {
                 VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
         physicalDevicesProp.pNext = &subgroupProp;
         vkGetPhysicalDeviceProperties2(_selectedPhysicalDevice, &physicalDevicesProp);
+        // quad operations in compute: mipdownsample.comp, mipdownsample_shared.comp otherwise
+        _computeSubgroupQuad = subgroupProp.subgroupSize >= 4 &&
+                               (subgroupProp.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+                               (subgroupProp.supportedOperations & VK_SUBGROUP_FEATURE_QUAD_BIT);
 
         // Get memory properties
         VkPhysicalDeviceMemoryProperties2 memoryProperties_ = {
@@ -657,8 +734,19 @@ void VkApplication::selectFeatures() {
     // enable indirect rendering
     //  enable11Features.shaderDrawParameters = VK_TRUE;
 //    enable12Features.drawIndirectCount = VK_TRUE;
-//    physicalDeviceFeatures.multiDrawIndirect = VK_TRUE;
-//    physicalDeviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+    // glb: one indirect call draws every mesh, instanced meshes start at firstInstance
+    if (_physicalFeatures2.features.multiDrawIndirect) {
+        physicalDeviceFeatures.multiDrawIndirect = VK_TRUE;
+    }
+    if (_physicalFeatures2.features.drawIndirectFirstInstance) {
+        physicalDeviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+    } else {
+        LOGE("drawIndirectFirstInstance is not supported, instanced glb meshes will misplace");
+    }
+    // etc textures are decoded on the cpu when the device cannot sample them, see loadTextures
+    if (_physicalFeatures2.features.textureCompressionETC2) {
+        physicalDeviceFeatures.textureCompressionETC2 = VK_TRUE;
+    }
     // enable independent blending
     physicalDeviceFeatures.independentBlend = VK_TRUE;
     // enable only if physical device support it
@@ -817,8 +905,13 @@ void VkApplication::cacheCommandQueue() {
     vkGetDeviceQueue(_logicalDevice, _computeQueueFamilyIndex, _computeQueueIndex, &_computeQueue);
 
     // Get transfer queue if present
+    // without a transfer-only family, uploads go through the graphics family
     if (_transferQueueFamilyIndex != std::numeric_limits<uint32_t>::max()) {
         vkGetDeviceQueue(_logicalDevice, _transferQueueFamilyIndex, 0, &_transferQueue);
+    } else {
+        LOGI("No transfer-only queue family, uploads share the graphics queue");
+        _transferQueueFamilyIndex = _graphicsComputeQueueFamilyIndex;
+        _transferQueue = _graphicsQueue;
     }
 
     // familyIndexSupportSurface
@@ -1300,6 +1393,46 @@ void VkApplication::createDescriptorSetLayout() {
         _descriptorSetLayouts.push_back(descriptorSetLayout);
         _descriptorSetLayoutForSamplers = descriptorSetLayout;
     }
+
+    {
+        // set 6 ssbo: glb materials
+        VkDescriptorSetLayoutBinding dsLayoutBindings{};
+        dsLayoutBindings.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        dsLayoutBindings.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        dsLayoutBindings.binding = 0;
+        dsLayoutBindings.descriptorCount = 1;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &dsLayoutBindings;
+
+        VkDescriptorSetLayout descriptorSetLayout{VK_NULL_HANDLE};
+        VK_CHECK(vkCreateDescriptorSetLayout(_logicalDevice, &layoutInfo, nullptr,
+                                             &descriptorSetLayout));
+        _descriptorSetLayouts.push_back(descriptorSetLayout);
+        _descriptorSetLayoutForMaterials = descriptorSetLayout;
+    }
+
+    {
+        // set 7 ssbo: glb per-instance transforms, indexed by gl_InstanceIndex
+        VkDescriptorSetLayoutBinding dsLayoutBindings{};
+        dsLayoutBindings.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        dsLayoutBindings.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        dsLayoutBindings.binding = 0;
+        dsLayoutBindings.descriptorCount = 1;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &dsLayoutBindings;
+
+        VkDescriptorSetLayout descriptorSetLayout{VK_NULL_HANDLE};
+        VK_CHECK(vkCreateDescriptorSetLayout(_logicalDevice, &layoutInfo, nullptr,
+                                             &descriptorSetLayout));
+        _descriptorSetLayouts.push_back(descriptorSetLayout);
+        _descriptorSetLayoutForInstanceTransforms = descriptorSetLayout;
+    }
 }
 
 // depends on your glsl
@@ -1310,6 +1443,8 @@ void VkApplication::createDescriptorPool() {
     // layout (set = 2, binding = 0) readonly buffer VertexBuffer
     // layout(set = 5, binding = 0) uniform texture2D BindlessImage2D[];
     // layout(set = 6, binding = 0) uniform sampler BindlessSampler[];
+    // layout(set = 6, binding = 0) readonly buffer MaterialBuffer
+    // layout(set = 7, binding = 0) readonly buffer InstanceBuffer
     std::vector<VkDescriptorPoolSize> descriptorPoolSizes(5);
     // poolSize.descriptorCount = static_cast<uint32_t>(MAX_DESCRIPTOR_SETS);
     descriptorPoolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -1335,9 +1470,9 @@ void VkApplication::createDescriptorPool() {
 }
 
 void VkApplication::allocateDescriptorSets() {
-    ASSERT(_descriptorSetLayouts.size() == 6,
+    ASSERT(_descriptorSetLayouts.size() == 8,
            "DS Layouts: ubo | texture | ssbo (vb) | ssbo(indirectDrawBuffer)"
-           "| texture2d | samplers");
+           "| texture2d | samplers | ssbo(materials) | ssbo(instanceTransforms)");
     // how many ds to allocate ?
     {
         // 1. ubo has MAX_FRAMES_IN_FLIGHT
@@ -1426,6 +1561,34 @@ void VkApplication::allocateDescriptorSets() {
                                          &_descriptorSetsForSampler));
 
     }
+
+    {
+        // 7. ssbo for materials
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = _descriptorSetPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &_descriptorSetLayoutForMaterials;
+
+        VK_CHECK(
+                vkAllocateDescriptorSets(_logicalDevice, &allocInfo,
+                                         &_descriptorSetsForMaterials));
+
+    }
+
+    {
+        // 8. ssbo for instance transforms
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = _descriptorSetPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &_descriptorSetLayoutForInstanceTransforms;
+
+        VK_CHECK(
+                vkAllocateDescriptorSets(_logicalDevice, &allocInfo,
+                                         &_descriptorSetsForInstanceTransforms));
+
+    }
 }
 
 // vma
@@ -1497,7 +1660,7 @@ void VkApplication::updateUniformBuffer(int currentFrameId) {
 //    getPrerotationMatrix(_pretransformFlag, ubo.mvp);
 
     auto view = _camera.viewTransformLH();
-    auto persPrj = PerspectiveProjectionTransformLH(0.0001f, 200000.0f, 0.8f,
+    auto persPrj = PerspectiveProjectionTransformLH(0.0001f, 200000.0f, CAMERA_VFOV,
                                                     (float) _swapChainExtent.width /
                                                     (float) _swapChainExtent.height);
 
@@ -1526,8 +1689,8 @@ void VkApplication::bindResourceToDescriptorSets() {
            "ubo descriptor set has frame_in_flight");
     // extra: 1. texture+sampler, 2. ssbo for vb, 3. ssbo for indirectdraw
     // 4. textures,
-    // 5. samplers
-    uint32_t writeDescriptorSetCount{MAX_FRAMES_IN_FLIGHT + 5};
+    // 5. samplers, 6. ssbo for materials, 7. ssbo for instance transforms
+    uint32_t writeDescriptorSetCount{MAX_FRAMES_IN_FLIGHT + 7};
     _writeDescriptorSetBundle.reserve(writeDescriptorSetCount);
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
@@ -1660,6 +1823,39 @@ void VkApplication::bindResourceToDescriptorSets() {
                 .pBufferInfo = nullptr,
         });
     }
+
+    // read by vkUpdateDescriptorSets below, must outlive the writes
+    const VkDescriptorBufferInfo materialBufferInfo{
+            .buffer = _compositeMatB,
+            .offset = 0,
+            .range = _compositeMatBSizeInByte,
+    };
+    _writeDescriptorSetBundle.emplace_back(VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = _descriptorSetsForMaterials,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = nullptr,
+            .pBufferInfo = &materialBufferInfo,
+    });
+
+    const VkDescriptorBufferInfo instanceTransformBufferInfo{
+            .buffer = _instanceTransformB,
+            .offset = 0,
+            .range = _instanceTransformBSizeInByte,
+    };
+    _writeDescriptorSetBundle.emplace_back(VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = _descriptorSetsForInstanceTransforms,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo = nullptr,
+            .pBufferInfo = &instanceTransformBufferInfo,
+    });
     //Validation Error: [ VUID-VkWriteDescriptorSet-descriptorType-00325 ] Object 0: handle = 0xd10d270000000018, type = VK_OBJECT_TYPE_DESCRIPTOR_SET; Object 1: handle = 0x7fc177270ab3, type = VK_OBJECT_TYPE_SAMPLER; | MessageID = 0xce76343a | vkUpdateDescriptorSets(): pDescriptorWrites[7] Attempted write update to sampler descriptor with invalid sample (VkSampler 0x7fc177270ab3[]).
     // The Vulkan spec states: If descriptorType is VK_DESCRIPTOR_TYPE_SAMPLER or VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
     // and dstSet was not allocated with a layout that included immutable samplers for dstBinding with descriptorType, the sampler member of each element of pImageInfo must be a valid VkSampler object (https://www.khronos.org/registry/vulkan/specs/1.3-extensions/html/vkspec.html#VUID-VkWriteDescriptorSet-descriptorType-00325)
@@ -1697,7 +1893,9 @@ VkShaderModule createShaderModule(VkDevice logicalDevice, const std::vector<uint
 
 void VkApplication::createGraphicsPipeline() {
     auto vertShaderCode =
-            LoadBinaryFile("shaders/indirectdraw_test.vert.spv", _assetManager);
+            LoadBinaryFile(QUANTIZE_GLB_VERTICES ? "shaders/indirectdraw_quantized.vert.spv"
+                                                 : "shaders/indirectdraw_test.vert.spv",
+                           _assetManager);
     auto fragShaderCode =
             LoadBinaryFile("shaders/indirectdraw_test.frag.spv", _assetManager);
 
@@ -1868,6 +2066,63 @@ void VkApplication::createGraphicsPipeline() {
     vkDestroyShaderModule(_logicalDevice, vertShaderModule, nullptr);
 }
 
+void VkApplication::createMipDownsamplePipeline() {
+    const std::array<VkDescriptorSetLayoutBinding, 2> bindings{{
+            {
+                    .binding = 0,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                    .descriptorCount = MIP_DOWNSAMPLE_MAX_LEVELS,
+                    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            },
+            {
+                    .binding = 1,
+                    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                    .descriptorCount = 1,
+                    .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            },
+    }};
+    const VkDescriptorSetLayoutCreateInfo setLayoutInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .bindingCount = static_cast<uint32_t>(bindings.size()),
+            .pBindings = bindings.data(),
+    };
+    VK_CHECK(vkCreateDescriptorSetLayout(_logicalDevice, &setLayoutInfo, nullptr,
+                                         &_mipDownsampleSetLayout));
+    const VkPushConstantRange pushConstantRange{
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset = 0,
+            .size = sizeof(MipDownsampleParams),
+    };
+    const VkPipelineLayoutCreateInfo pipelineLayoutInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount = 1,
+            .pSetLayouts = &_mipDownsampleSetLayout,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges = &pushConstantRange,
+    };
+    VK_CHECK(vkCreatePipelineLayout(_logicalDevice, &pipelineLayoutInfo, nullptr,
+                                    &_mipDownsamplePipelineLayout));
+
+    LOGI("Mip downsampler: %s", _computeSubgroupQuad ? "subgroup quad" : "shared memory");
+    const auto code = LoadBinaryFile(_computeSubgroupQuad ? "shaders/mipdownsample.comp.spv"
+                                                          : "shaders/mipdownsample_shared.comp.spv",
+                                     _assetManager);
+    VkShaderModule shaderModule = createShaderModule(_logicalDevice, code);
+    const VkComputePipelineCreateInfo pipelineInfo{
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage = {
+                    .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                    .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                    .module = shaderModule,
+                    .pName = "main",
+            },
+            .layout = _mipDownsamplePipelineLayout,
+    };
+    VK_CHECK(vkCreateComputePipelines(_logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr,
+                                      &_mipDownsamplePipeline));
+    vkDestroyShaderModule(_logicalDevice, shaderModule, nullptr);
+}
+
 void VkApplication::createSwapChainFramebuffers() {
     _swapChainFramebuffers.resize(_swapChainImageViews.size());
     VkFramebufferCreateInfo framebufferInfo{};
@@ -1899,6 +2154,11 @@ void VkApplication::createCommandPool() {
     poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     poolInfo.queueFamilyIndex = _graphicsComputeQueueFamilyIndex;
     VK_CHECK(vkCreateCommandPool(_logicalDevice, &poolInfo, nullptr, &_commandPool));
+
+    // upload command buffers are recorded once and freed when their upload completed
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = _transferQueueFamilyIndex;
+    VK_CHECK(vkCreateCommandPool(_logicalDevice, &poolInfo, nullptr, &_transferCommandPool));
 }
 
 void VkApplication::createCommandBuffer() {
@@ -1969,6 +2229,12 @@ VkApplication::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t swapC
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             _pipelineLayout, 5, 1, &_descriptorSetsForSampler,
                             0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            _pipelineLayout, 6, 1, &_descriptorSetsForMaterials,
+                            0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            _pipelineLayout, 7, 1, &_descriptorSetsForInstanceTransforms,
+                            0, nullptr);
 //
 //    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
 //                            _pipelineLayout, 1, 1, &skins[node.skin].descriptorSet, 0, nullptr);
@@ -1980,8 +2246,11 @@ VkApplication::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t swapC
 
     vkCmdBindIndexBuffer(commandBuffer, _compositeIB, 0, VK_INDEX_TYPE_UINT32);
     // how many draws are dependent on how many meshes in the scene.
-    vkCmdDrawIndexedIndirect(commandBuffer, _indirectDrawB, 0, _numMeshes,
-                             sizeof(IndirectDrawForVulkan));
+    // with lods, this frame's copy carries the selected firstIndex/indexCount
+    vkCmdDrawIndexedIndirect(commandBuffer,
+                             _lodIndirectDrawBuffers.empty()
+                             ? _indirectDrawB : _lodIndirectDrawBuffers[_currentFrameId],
+                             0, _numMeshes, sizeof(IndirectDrawForVulkan));
 
 //    // draw for textured quad
 //    // for vao driven draw
@@ -2019,6 +2288,17 @@ void VkApplication::createPerFrameSyncObjects() {
                                    &_imageRendereredSemaphores[i]));
         VK_CHECK(vkCreateFence(_logicalDevice, &fenceInfo, nullptr, &_inFlightFences[i]));
     }
+
+    // uploads: the transfer submission signals odd values, the graphics one even values
+    ASSERT(_vk12features.timelineSemaphore, "timelineSemaphore is not supported");
+    VkSemaphoreTypeCreateInfo timelineInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            .initialValue = 0,
+    };
+    semaphoreInfo.pNext = &timelineInfo;
+    VK_CHECK(vkCreateSemaphore(_logicalDevice, &semaphoreInfo, nullptr, &_uploadTimeline));
+    setCorrlationId(_uploadTimeline, VK_OBJECT_TYPE_SEMAPHORE, "Semaphore: upload timeline");
 }
 
 bool VkApplication::checkValidationLayerSupport() {
@@ -2044,14 +2324,18 @@ bool VkApplication::checkValidationLayerSupport() {
     return true;
 }
 
-// create shared _uploadCmd and begin
+// create and begin the two command buffers of an upload:
+// _uploadCmd on the transfer family (copies, ownership release)
+// _uploadGraphicsCmd on the graphics family (ownership acquire, mip blits, final layouts)
 void VkApplication::preHostDeviceIO() {
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = _commandPool;
+    allocInfo.commandPool = _transferCommandPool;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     allocInfo.commandBufferCount = 1;
     VK_CHECK(vkAllocateCommandBuffers(_logicalDevice, &allocInfo, &_uploadCmd));
+    allocInfo.commandPool = _commandPool;
+    VK_CHECK(vkAllocateCommandBuffers(_logicalDevice, &allocInfo, &_uploadGraphicsCmd));
 
     VkCommandBufferBeginInfo cmdBufferBeginInfo{};
     cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -2059,55 +2343,164 @@ void VkApplication::preHostDeviceIO() {
     //  and the command buffer will be reset and recorded again between each submission.
     cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     VK_CHECK(vkBeginCommandBuffer(_uploadCmd, &cmdBufferBeginInfo));
-
-    VkFenceCreateInfo fenceInfo = {
-            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0, // VK_FENCE_CREATE_SIGNALED_BIT: signaled state
-    };
-    VkFence fence;
-    VK_CHECK(vkCreateFence(_logicalDevice, &fenceInfo, nullptr, &_ioFence));
+    VK_CHECK(vkBeginCommandBuffer(_uploadGraphicsCmd, &cmdBufferBeginInfo));
 }
 
-// end recording of buffer.
-// wait for completion using fence
+// end recording, submit without waiting:
+// transfer queue signals the timeline, the graphics submission waits on it, so the copies
+// overlap whatever the graphics queue is doing; frames submitted later are ordered behind the
+// acquire barriers on the graphics queue
 void VkApplication::postHostDeviceIO() {
     VK_CHECK(vkEndCommandBuffer(_uploadCmd));
+    VK_CHECK(vkEndCommandBuffer(_uploadGraphicsCmd));
 
-    const VkPipelineStageFlags flags = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    const uint64_t copiedValue = ++_uploadTimelineValue;
+    const uint64_t acquiredValue = ++_uploadTimelineValue;
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.waitSemaphoreCount = 0;
-    submitInfo.pWaitSemaphores = VK_NULL_HANDLE;
-    // only useful when having waitsemaphore
-    submitInfo.pWaitDstStageMask = &flags;
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &_uploadCmd;
-    submitInfo.signalSemaphoreCount = 0;
-    submitInfo.pSignalSemaphores = VK_NULL_HANDLE;
-    VK_CHECK(vkQueueSubmit(_graphicsQueue, 1, &submitInfo, _ioFence));
-
-    const auto result = vkWaitForFences(_logicalDevice, 1, &_ioFence, VK_TRUE,
-                                        DEFAULT_FENCE_TIMEOUT);
-    if (result == VK_TIMEOUT) {
-        vkDeviceWaitIdle(_logicalDevice);
-    }
-    // clean all the staging resources
-    vkDestroyBuffer(_logicalDevice, _stagingVb, nullptr);
-    vkDestroyBuffer(_logicalDevice, _stagingIb, nullptr);
-    // for texture
-    vkDestroyBuffer(_logicalDevice, _stagingImageBuffer, nullptr);
-    // for glb Scene
-    for (size_t i = 0; i < _stagingVbForMesh.size(); ++i) {
-        vkDestroyBuffer(_logicalDevice, _stagingVbForMesh[i], nullptr);
-    }
-    for (size_t i = 0; i < _stagingIbForMesh.size(); ++i) {
-        vkDestroyBuffer(_logicalDevice, _stagingIbForMesh[i], nullptr);
-    }
-    // for material buffer
-    vkDestroyBuffer(_logicalDevice, _stagingMatBuffer, nullptr);
-    vkDestroyBuffer(_logicalDevice, _stagingIndirectDrawBuffer, nullptr);
+    const VkTimelineSemaphoreSubmitInfo transferTimelineInfo{
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues = &copiedValue,
+    };
+    const VkSubmitInfo transferSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &transferTimelineInfo,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &_uploadCmd,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &_uploadTimeline,
+    };
+    VK_CHECK(vkQueueSubmit(_transferQueue, 1, &transferSubmitInfo, VK_NULL_HANDLE));
+    // the staging memory is free again once the copies are done
+    _stagingRing.endBatch(copiedValue);
+
+    const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    const VkTimelineSemaphoreSubmitInfo graphicsTimelineInfo{
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .waitSemaphoreValueCount = 1,
+            .pWaitSemaphoreValues = &copiedValue,
+            .signalSemaphoreValueCount = 1,
+            .pSignalSemaphoreValues = &acquiredValue,
+    };
+    const VkSubmitInfo graphicsSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &graphicsTimelineInfo,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &_uploadTimeline,
+            .pWaitDstStageMask = &waitStage,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &_uploadGraphicsCmd,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &_uploadTimeline,
+    };
+    VK_CHECK(vkQueueSubmit(_graphicsQueue, 1, &graphicsSubmitInfo, VK_NULL_HANDLE));
+
+    _pendingUploads.push_back({.completedValue = acquiredValue,
+                               .transferCmd = _uploadCmd,
+                               .graphicsCmd = _uploadGraphicsCmd,
+                               .scratch = std::move(_uploadScratch),
+                               .submitTime = std::chrono::steady_clock::now()});
+    _uploadScratch = {};
+    _uploadCmd = VK_NULL_HANDLE;
+    _uploadGraphicsCmd = VK_NULL_HANDLE;
+}
+
+// frees the command buffers and staging memory of every upload at or below completedValue
+void VkApplication::reclaimUploads(uint64_t completedValue) {
+    _stagingRing.release(completedValue);
+    while (!_pendingUploads.empty() && _pendingUploads.front().completedValue <= completedValue) {
+        auto &upload = _pendingUploads.front();
+        vkFreeCommandBuffers(_logicalDevice, _transferCommandPool, 1, &upload.transferCmd);
+        vkFreeCommandBuffers(_logicalDevice, _commandPool, 1, &upload.graphicsCmd);
+        auto &scratch = upload.scratch;
+        if (scratch.queryPool != VK_NULL_HANDLE) {
+            // upload-to-ready: submission until seen complete here (frame granularity),
+            // mip generation alone from the gpu timestamps
+            std::array<uint64_t, 2> timestamps{};
+            VK_CHECK(vkGetQueryPoolResults(_logicalDevice, scratch.queryPool, 0, 2,
+                                           sizeof(timestamps), timestamps.data(),
+                                           sizeof(uint64_t), VK_QUERY_RESULT_64_BIT));
+            const auto readyMs = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - upload.submitTime).count();
+            LOGI("Upload ready after %.2f ms, mip generation (%s): %u images, %.3f ms on the gpu",
+                 readyMs, scratch.computeMipChains ? "compute" : "blit", scratch.mipChainCount,
+                 (timestamps[1] - timestamps[0]) * _physicalDevicesProp1.limits.timestampPeriod /
+                 1e6);
+            vkDestroyQueryPool(_logicalDevice, scratch.queryPool, nullptr);
+        }
+        for (const auto imageView: scratch.imageViews) {
+            vkDestroyImageView(_logicalDevice, imageView, nullptr);
+        }
+        vkDestroyDescriptorPool(_logicalDevice, scratch.descriptorPool, nullptr);
+        if (scratch.buffer != VK_NULL_HANDLE) {
+            vmaDestroyBuffer(_vmaAllocator, scratch.buffer, scratch.allocation);
+        }
+        _pendingUploads.pop_front();
+    }
+}
+
+// the copy into buffer is done on the transfer family, hand it to the graphics family:
+// release in _uploadCmd, matching acquire in _uploadGraphicsCmd
+// one family: a plain transfer -> consumers barrier on the graphics side
+void VkApplication::transferBufferToGraphics(VkBuffer buffer) {
+    const bool ownershipTransfer = _transferQueueFamilyIndex != _graphicsComputeQueueFamilyIndex;
+    VkBufferMemoryBarrier barrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = 0,
+            .srcQueueFamilyIndex = ownershipTransfer ? _transferQueueFamilyIndex
+                                                     : VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = ownershipTransfer ? _graphicsComputeQueueFamilyIndex
+                                                     : VK_QUEUE_FAMILY_IGNORED,
+            .buffer = buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+    };
+    if (ownershipTransfer) {
+        vkCmdPipelineBarrier(_uploadCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0,
+                             nullptr);
+        barrier.srcAccessMask = 0;
+    }
+    barrier.dstAccessMask = UPLOADED_BUFFER_DST_ACCESS;
+    vkCmdPipelineBarrier(_uploadGraphicsCmd,
+                         ownershipTransfer ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+                                           : VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         UPLOADED_BUFFER_DST_STAGES, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+// same for an image written by transfer commands, the layout transition
+// oldLayout -> newLayout is part of the release / acquire pair
+void VkApplication::transferImageToGraphics(VkImage image,
+                                            const VkImageSubresourceRange &subresourceRange,
+                                            VkImageLayout oldLayout, VkImageLayout newLayout,
+                                            VkPipelineStageFlags dstStage,
+                                            VkAccessFlags dstAccess) {
+    const bool ownershipTransfer = _transferQueueFamilyIndex != _graphicsComputeQueueFamilyIndex;
+    VkImageMemoryBarrier barrier{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = 0,
+            .oldLayout = oldLayout,
+            .newLayout = newLayout,
+            .srcQueueFamilyIndex = ownershipTransfer ? _transferQueueFamilyIndex
+                                                     : VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = ownershipTransfer ? _graphicsComputeQueueFamilyIndex
+                                                     : VK_QUEUE_FAMILY_IGNORED,
+            .image = image,
+            .subresourceRange = subresourceRange,
+    };
+    if (ownershipTransfer) {
+        vkCmdPipelineBarrier(_uploadCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1,
+                             &barrier);
+        barrier.srcAccessMask = 0;
+    }
+    barrier.dstAccessMask = dstAccess;
+    vkCmdPipelineBarrier(_uploadGraphicsCmd,
+                         ownershipTransfer ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+                                           : VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
 // cull face be careful
@@ -2125,67 +2518,17 @@ void VkApplication::loadVao() {
     _indexCount = indices.size();
 
     // vao
-    // staging buffer:
-    // 1. usage: VK_BUFFER_USAGE_TRANSFER_SRC_BIT
-    // 2. VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    // staging: both streams go through the staging ring
     const auto vbByteSize = vertices.size() * sizeof(VertexDef1);
     const auto ebByteSize = indices.size() * sizeof(uint32_t);
-    {
-        // create _stagingVb
-        VmaAllocation vmaStagingBufferAllocation{nullptr};
-        VkBufferCreateInfo bufferCreateInfo{
-                .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                .size = vbByteSize,
-                .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-        };
-        const VmaAllocationCreateInfo stagingAllocationCreateInfo = {
-                .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                         VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-                .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
-        VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo, &stagingAllocationCreateInfo,
-                                 &_stagingVb,
-                                 &vmaStagingBufferAllocation, nullptr));
-        void *mappedMemory{nullptr};
-        VK_CHECK(vmaMapMemory(_vmaAllocator, vmaStagingBufferAllocation, &mappedMemory));
-        memcpy(mappedMemory, vertices.data(), vbByteSize);
-        vmaUnmapMemory(_vmaAllocator, vmaStagingBufferAllocation);
-    }
-
-    {
-        // create stagingEb
-        VmaAllocation vmaStagingBufferAllocation{nullptr};
-        VkBufferCreateInfo bufferCreateInfo{
-                .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                .size = ebByteSize,
-                .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-        };
-        const VmaAllocationCreateInfo stagingAllocationCreateInfo = {
-                .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                         VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-                .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
-        VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo, &stagingAllocationCreateInfo,
-                                 &_stagingIb,
-                                 &vmaStagingBufferAllocation, nullptr));
-        void *mappedMemory{nullptr};
-        VK_CHECK(vmaMapMemory(_vmaAllocator, vmaStagingBufferAllocation, &mappedMemory));
-        memcpy(mappedMemory, indices.data(), ebByteSize);
-        vmaUnmapMemory(_vmaAllocator, vmaStagingBufferAllocation);
-    }
+    const auto stagingVb = _stagingRing.stage(vertices.data(), vbByteSize);
+    const auto stagingIb = _stagingRing.stage(indices.data(), ebByteSize);
 
     // device buffer:
     // 1. usage: VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
     // 2. VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
     {
         // create vbo
-        VmaAllocation vmaDeviceBufferAllocation{nullptr};
         VkBufferCreateInfo bufferCreateInfo{
                 .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
                 .size = vbByteSize,
@@ -2201,16 +2544,16 @@ void VkApplication::loadVao() {
         };
         VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo, &bufferAllocationCreateInfo,
                                  &_deviceVb,
-                                 &vmaDeviceBufferAllocation, nullptr));
+                                 &_deviceVbAllocation, nullptr));
 
         // src: bytesOffset, dst: bytesOffset
-        VkBufferCopy region{.srcOffset = 0, .dstOffset = 0, .size = vbByteSize};
-        vkCmdCopyBuffer(_uploadCmd, _stagingVb, _deviceVb, 1, &region);
+        VkBufferCopy region{.srcOffset = stagingVb.offset, .dstOffset = 0, .size = vbByteSize};
+        vkCmdCopyBuffer(_uploadCmd, stagingVb.buffer, _deviceVb, 1, &region);
+        transferBufferToGraphics(_deviceVb);
     }
 
     {
         // create ebo
-        VmaAllocation vmaDeviceBufferAllocation{nullptr};
         VkBufferCreateInfo bufferCreateInfo{
                 .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
                 .size = ebByteSize,
@@ -2226,11 +2569,12 @@ void VkApplication::loadVao() {
         };
         VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo, &bufferAllocationCreateInfo,
                                  &_deviceIb,
-                                 &vmaDeviceBufferAllocation, nullptr));
+                                 &_deviceIbAllocation, nullptr));
 
         // src: bytesOffset, dst: bytesOffset
-        VkBufferCopy region{.srcOffset = 0, .dstOffset = 0, .size = ebByteSize};
-        vkCmdCopyBuffer(_uploadCmd, _stagingIb, _deviceIb, 1, &region);
+        VkBufferCopy region{.srcOffset = stagingIb.offset, .dstOffset = 0, .size = ebByteSize};
+        vkCmdCopyBuffer(_uploadCmd, stagingIb.buffer, _deviceIb, 1, &region);
+        transferBufferToGraphics(_deviceIb);
     }
 }
 
@@ -2240,35 +2584,46 @@ void VkApplication::loadTextures() {
     VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
     ktxResult result;
     ktxTexture *ktxTexture;
+#if defined(LINEAR_TILED_IMAGES)
+    // level 0 is copied out of the loaded image data
+    const ktxTextureCreateFlags createFlags = KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT;
+#else
+    // images are loaded straight into the staging ring, see below
+    const ktxTextureCreateFlags createFlags = KTX_TEXTURE_CREATE_NO_FLAGS;
+#endif
 
 #if defined(__ANDROID__)
-    AAsset *asset = AAssetManager_open(_assetManager, filename.c_str(), AASSET_MODE_STREAMING);
+    // buffer mode: ktx is stored uncompressed (noCompress), the buffer is the mapped apk and the
+    // texture parses it in place, it owns and closes the asset
+    AAsset *asset = AAssetManager_open(_assetManager, filename.c_str(), AASSET_MODE_BUFFER);
     if (!asset) {
         FATAL("Could not load texture from " + filename, -1);
     }
-    size_t size = AAsset_getLength(asset);
-    ASSERT(size > 0, "asset size should larger then 0");
-
-    ktx_uint8_t *textureData = new ktx_uint8_t[size];
-    AAsset_read(asset, textureData, size);
-    AAsset_close(asset);
-    result = ktxTexture_CreateFromMemory(textureData, size, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
-                                         &ktxTexture);
-    delete[] textureData;
+    result = ktxTexture_CreateFromAsset(asset, createFlags, &ktxTexture);
 #else
-    // To Do
+    result = ktxTexture_CreateFromMappedFile(filename.c_str(), createFlags, &ktxTexture);
 #endif
-    ASSERT(result == KTX_SUCCESS, "ktxTexture_CreateFromMemory failed");
-    auto textureWidth = ktxTexture->baseWidth;
-    auto textureHeight = ktxTexture->baseHeight;
+    ASSERT(result == KTX_SUCCESS, "ktxTexture_CreateFrom* failed");
+    // no ETC2 sampling on this device: upload the decoded texels instead
+    if (isEtcFormat(ktxTexture->glInternalformat) &&
+        !_enabledDeviceFeatures.features.textureCompressionETC2) {
+        ::ktxTexture *unpackedTexture;
+        result = unpackEtcTexture(ktxTexture, &unpackedTexture);
+        ASSERT(result == KTX_SUCCESS, "unpackEtcTexture failed");
+        LOGI("textureCompressionETC2 is not supported, %s is decoded on the cpu",
+             filename.c_str());
+        ktxTexture_Destroy(ktxTexture);
+        ktxTexture = unpackedTexture;
+    }
     auto textureMipLevels = ktxTexture->numLevels;
-    ktx_uint8_t *ktxTextureData = ktxTexture_GetData(ktxTexture);
-    ktx_size_t ktxTextureSize = ktxTexture_GetSize(ktxTexture);
 
     // Linear tiled images
     // Optimal tiled images: not accessible by the host, requires some sort of data copy,
     // either from a buffer or	a linear tiled image
 #if defined(LINEAR_TILED_IMAGES)
+    auto textureWidth = ktxTexture->baseWidth;
+    auto textureHeight = ktxTexture->baseHeight;
+    ktx_uint8_t *ktxTextureData = ktxTexture_GetData(ktxTexture);
     VmaAllocation vmaImageAllocation{nullptr};
 
     // linear texture
@@ -2384,149 +2739,63 @@ void VkApplication::loadTextures() {
         vkFreeCommandBuffers(_logicalDevice, _commandPool, 1, &copyCmd);
     }
 #else
-    // This buffer is used as a transfer source for the buffer copy
-    VmaAllocation vmaStagingBufferAllocation{nullptr};
-    VkBufferCreateInfo bufferCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-            .size = size,
-            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT, // for staging buffer
-            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    // the ktx loader records the upload into the shared upload command buffer: the images are
+    // loaded straight into the staging ring, the image is sub-allocated by vma, both go with the
+    // rest of the upload batch instead of a vkAllocateMemory pair and a fence wait per texture
+    // kept for teardown, which hands the image back to destroyImage
+    _ktxUploadCallbacks = ktxVulkanUploadCallbacks{
+            .pUserData = this,
+            .allocateStaging = [](void *userData, VkDeviceSize size, VkBuffer *buffer,
+                                  VkDeviceSize *offset, void **mapped) -> VkResult {
+                auto *app = static_cast<VkApplication *>(userData);
+                // reclaimed once the upload completed
+                const auto staging = app->_stagingRing.allocate(size);
+                *buffer = staging.buffer;
+                *offset = staging.offset;
+                *mapped = staging.memory.data();
+                return VK_SUCCESS;
+            },
+            .createImage = [](void *userData, const VkImageCreateInfo *createInfo, VkImage *image,
+                              void **allocation) -> VkResult {
+                auto *app = static_cast<VkApplication *>(userData);
+                // no need for VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, cpu does not need access
+                const VmaAllocationCreateInfo allocCreateInfo = {
+                        .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+                        .priority = 1.0f,
+                };
+                VmaAllocation vmaAllocation{VK_NULL_HANDLE};
+                const auto res = vmaCreateImage(app->_vmaAllocator, createInfo, &allocCreateInfo,
+                                                image, &vmaAllocation, nullptr);
+                *allocation = vmaAllocation;
+                return res;
+            },
+            .destroyImage = [](void *userData, VkImage image, void *allocation) {
+                vmaDestroyImage(static_cast<VkApplication *>(userData)->_vmaAllocator, image,
+                                static_cast<VmaAllocation>(allocation));
+            },
     };
-    const VmaAllocationCreateInfo stagingAllocationCreateInfo = {
-            .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                     VMA_ALLOCATION_CREATE_MAPPED_BIT,
-            .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+    // the upload command buffer may be on a transfer-only queue: no blits
+    ASSERT(!ktxTexture->generateMipmaps, "ktx mip generation is not supported");
+    // left in TRANSFER_DST for the ownership transfer below
+    result = ktxTexture_VkUploadToCommandBuffer(ktxTexture, _selectedPhysicalDevice, _uploadCmd,
+                                                &_ktxUploadCallbacks, &_vkTexture,
+                                                VK_IMAGE_USAGE_SAMPLED_BIT,
+                                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    ASSERT(result == KTX_SUCCESS, "ktxTexture_VkUploadToCommandBuffer failed");
+    _image = _vkTexture.image;
+    format = _vkTexture.imageFormat;
+
+    // image layout(usage) from dst -> shader read, owned by the graphics family
+    const VkImageSubresourceRange subresourceRange{
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .baseMipLevel = 0,
+            .levelCount = _vkTexture.levelCount,
+            .baseArrayLayer = 0,
+            .layerCount = _vkTexture.layerCount,
     };
-    VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo, &stagingAllocationCreateInfo,
-                             &_stagingImageBuffer,
-                             &vmaStagingBufferAllocation, nullptr));
-    if (vmaStagingBufferAllocation != nullptr) {
-        VmaAllocationInfo stagingBufferAllocationInfo;
-        vmaGetAllocationInfo(_vmaAllocator, vmaStagingBufferAllocation,
-                             &stagingBufferAllocationInfo);
-        // copy to staging buffer (visible both host and device)
-        void *mappedMemory{nullptr};
-        VK_CHECK(vmaMapMemory(_vmaAllocator, vmaStagingBufferAllocation, &mappedMemory));
-        memcpy(mappedMemory, ktxTextureData, ktxTextureSize);
-        vmaUnmapMemory(_vmaAllocator, vmaStagingBufferAllocation);
-        VK_CHECK(vmaFlushAllocation(_vmaAllocator, vmaStagingBufferAllocation, 0, ktxTextureSize));
-
-        // for image
-        // diff1: textureMipLevels,
-        // diff2: VK_IMAGE_TILING_OPTIMAL,
-        // diff3: usage has 1 more flag: VK_IMAGE_USAGE_TRANSFER_DST_BIT
-        // diff4: initial layout: VK_IMAGE_LAYOUT_UNDEFINED
-
-        VkImageCreateInfo imageCreateInfo{};
-        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-        imageCreateInfo.format = format;
-        imageCreateInfo.mipLevels = textureMipLevels;
-        imageCreateInfo.arrayLayers = 1;
-        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-        imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        imageCreateInfo.extent = {textureWidth, textureHeight, 1};
-        // no need for VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, cpu does not need access
-        const VmaAllocationCreateInfo allocCreateInfo = {
-                .flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT,
-                .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-                .priority = 1.0f,
-        };
-        VK_CHECK(vmaCreateImage(_vmaAllocator, &imageCreateInfo, &allocCreateInfo, &_image,
-                                &_vmaImageAllocation, nullptr));
-
-        std::vector<VkBufferImageCopy> bufferCopyRegions;
-        uint32_t offset = 0;
-
-        for (uint32_t i = 0; i < textureMipLevels; ++i) {
-            ktx_size_t offsetForMipMapLevel;
-            auto ret = ktxTexture_GetImageOffset(ktxTexture, i, 0, 0, &offsetForMipMapLevel);
-            ASSERT(ret == KTX_SUCCESS, "ktxTexture_GetImageOffset failed");
-            // Setup a buffer image copy structure for the current mip level
-            VkBufferImageCopy bufferCopyRegion = {};
-            // regarding mipmap
-            bufferCopyRegion.bufferOffset = offsetForMipMapLevel;
-            // could be depth, stencil and color
-            bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            bufferCopyRegion.imageSubresource.mipLevel = i;
-            bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-            bufferCopyRegion.imageSubresource.layerCount = 1;
-            // primad mipmap hierachy
-            bufferCopyRegion.imageExtent.width = ktxTexture->baseWidth >> i;
-            bufferCopyRegion.imageExtent.height = ktxTexture->baseHeight >> i;
-            bufferCopyRegion.imageExtent.depth = 1;
-            bufferCopyRegions.push_back(bufferCopyRegion);
-        }
-
-        // now has mipmap
-        // barrier based on mip level, array layers
-        VkImageSubresourceRange subresourceRange = {};
-        subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        subresourceRange.baseMipLevel = 0;
-        subresourceRange.levelCount = textureMipLevels;
-        subresourceRange.layerCount = 1;
-
-        // transition layout
-        VkImageMemoryBarrier imageMemoryBarrier{};
-        imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        imageMemoryBarrier.image = _image;
-        imageMemoryBarrier.subresourceRange = subresourceRange;
-        imageMemoryBarrier.srcAccessMask = 0;
-        imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        // VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: written into
-        imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-
-        //it defines a memory dependency between commands that were
-        // submitted to the same queue before it, and those submitted to the same queue after it.
-        // ensure the image layout is VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, which could be write to.
-        vkCmdPipelineBarrier(
-                _uploadCmd,
-                VK_PIPELINE_STAGE_HOST_BIT,
-                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                0,
-                0, nullptr,
-                0, nullptr,
-                1, &imageMemoryBarrier);
-        // now image layout(usage) is writable
-        // staging buffer to device-local(image is device local memory)
-        vkCmdCopyBufferToImage(
-                _uploadCmd,
-                _stagingImageBuffer,
-                _image,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                static_cast<uint32_t>(bufferCopyRegions.size()),
-                bufferCopyRegions.data());
-
-        // image layout(usage) from dst -> shader read
-        imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        vkCmdPipelineBarrier(
-                _uploadCmd,
-                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                0,
-                0, nullptr,
-                0, nullptr,
-                1, &imageMemoryBarrier);
-
-//        // Done with the staging buffer
-//        // vmaDestroyBuffer to replace the following
-//        // Clean up staging resources
-//        // vkFreeMemory(_logicalDevice, stagingBuffer, nullptr);
-//        //vmaFreeMemory(_vmaAllocator, vmaImageAllocation);
-//
-//        vkDestroyBuffer(_logicalDevice, stagingBuffer, nullptr);
-//        // cannot free memory bounded to the image.
-//        // vmaDestroyBuffer(_vmaAllocator, stagingBuffer, vmaImageAllocation);
-    }
+    transferImageToGraphics(_image, subresourceRange, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
 #endif
     // done with the cpu texture
     ktxTexture_Destroy(ktxTexture);
@@ -2602,616 +2871,991 @@ void buildCompositeBuffer(const Scene &scene,
 //            VMA_MEMORY_USAGE_GPU_ONLY, "vertex"));
 }
 
+// device-local buffer for the glb scene, read through buffer device address / ssbo
+void VkApplication::createGlbDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                                          VkBuffer &buffer) {
+    VmaAllocation vmaAllocation{VK_NULL_HANDLE};
+    VkBufferCreateInfo bufferCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = size,
+            .usage = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+                     | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                     | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+                     | usage,
+    };
+    // for device buffer
+    // VK_MEMORY_PROPERTY_HOST_CACHED_BIT bit specifies that memory allocated with this type is cached on the host
+    const VmaAllocationCreateInfo deviceBufferAllocationCreateInfo = {
+            .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
+                     VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+            .preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT
+    };
+    VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo,
+                             &deviceBufferAllocationCreateInfo,
+                             &buffer, &vmaAllocation, nullptr));
+    _glbDeviceBuffers.emplace_back(buffer, vmaAllocation);
+}
+
+// every level of every image in TRANSFER_DST, owned by the graphics family, to
+// SHADER_READ_ONLY with level 0 filtered down the chain
+void VkApplication::generateMipChains(std::span<const MipChain> mipChains, VkFormat format) {
+    if (mipChains.empty()) {
+        return;
+    }
+    std::vector<MipChain> computeChains;
+    std::vector<MipChain> blitChains;
+    for (const auto &chain: mipChains) {
+        (chain.compute ? computeChains : blitChains).push_back(chain);
+    }
+    // timestamps around both: upload-to-ready benchmark of the two paths, see reclaimUploads
+    ASSERT(_uploadScratch.queryPool == VK_NULL_HANDLE, "mip chains generated twice per upload");
+    if (_physicalDevicesProp1.limits.timestampComputeAndGraphics) {
+        const VkQueryPoolCreateInfo queryPoolInfo{
+                .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                .queryCount = 2,
+        };
+        VK_CHECK(vkCreateQueryPool(_logicalDevice, &queryPoolInfo, nullptr,
+                                   &_uploadScratch.queryPool));
+        vkCmdResetQueryPool(_uploadGraphicsCmd, _uploadScratch.queryPool, 0, 2);
+        vkCmdWriteTimestamp(_uploadGraphicsCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            _uploadScratch.queryPool, 0);
+    }
+    _uploadScratch.mipChainCount = static_cast<uint32_t>(mipChains.size());
+    _uploadScratch.computeMipChains = !computeChains.empty();
+    downsampleMipChains(computeChains);
+    blitMipChains(blitChains, format);
+    if (_uploadScratch.queryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(_uploadGraphicsCmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                            _uploadScratch.queryPool, 1);
+    }
+}
+
+// single dispatch per image of mipdownsample.comp: no TRANSFER_SRC usage, no per-level layout
+// round trip, every level stays in GENERAL until the final barrier
+// sRGB chains are averaged in linear space
+void VkApplication::downsampleMipChains(std::span<const MipChain> mipChains) {
+    if (mipChains.empty()) {
+        return;
+    }
+    auto &scratch = _uploadScratch;
+    const auto chainCount = static_cast<uint32_t>(mipChains.size());
+    // one workgroup counter per image, the last workgroup of an image does levels 7 on
+    const VkBufferCreateInfo counterBufferInfo{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size = sizeof(uint32_t) * chainCount,
+            .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    const VmaAllocationCreateInfo counterAllocationInfo{
+            .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+    };
+    VK_CHECK(vmaCreateBuffer(_vmaAllocator, &counterBufferInfo, &counterAllocationInfo,
+                             &scratch.buffer, &scratch.allocation, nullptr));
+
+    const std::array<VkDescriptorPoolSize, 2> poolSizes{{
+            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MIP_DOWNSAMPLE_MAX_LEVELS * chainCount},
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, chainCount},
+    }};
+    const VkDescriptorPoolCreateInfo poolInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets = chainCount,
+            .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+            .pPoolSizes = poolSizes.data(),
+    };
+    VK_CHECK(vkCreateDescriptorPool(_logicalDevice, &poolInfo, nullptr, &scratch.descriptorPool));
+    const std::vector<VkDescriptorSetLayout> setLayouts(chainCount, _mipDownsampleSetLayout);
+    const VkDescriptorSetAllocateInfo setAllocateInfo{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = scratch.descriptorPool,
+            .descriptorSetCount = chainCount,
+            .pSetLayouts = setLayouts.data(),
+    };
+    std::vector<VkDescriptorSet> descriptorSets(chainCount);
+    VK_CHECK(vkAllocateDescriptorSets(_logicalDevice, &setAllocateInfo, descriptorSets.data()));
+
+    const VkDescriptorBufferInfo counterInfo{
+            .buffer = scratch.buffer,
+            .offset = 0,
+            .range = VK_WHOLE_SIZE,
+    };
+    std::vector<std::array<VkDescriptorImageInfo, MIP_DOWNSAMPLE_MAX_LEVELS>> levelInfos(
+            chainCount);
+    std::vector<VkWriteDescriptorSet> writes;
+    writes.reserve(chainCount * 2);
+    std::vector<VkImageMemoryBarrier> barriers;
+    barriers.reserve(chainCount);
+    for (uint32_t i = 0; i < chainCount; ++i) {
+        const auto &chain = mipChains[i];
+        ASSERT(chain.levelCount <= MIP_DOWNSAMPLE_MAX_LEVELS, "mip chain too long to downsample");
+        for (uint32_t level = 0; level < MIP_DOWNSAMPLE_MAX_LEVELS; ++level) {
+            if (level >= chain.levelCount) {
+                // never accessed: the shader stops at levelCount
+                levelInfos[i][level] = levelInfos[i][chain.levelCount - 1];
+                continue;
+            }
+            const VkImageViewCreateInfo viewInfo{
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                    .image = chain.image,
+                    .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                    .format = VK_FORMAT_R8G8B8A8_UNORM,
+                    .subresourceRange = {
+                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .baseMipLevel = level,
+                            .levelCount = 1,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1,
+                    },
+            };
+            VkImageView levelView;
+            VK_CHECK(vkCreateImageView(_logicalDevice, &viewInfo, nullptr, &levelView));
+            scratch.imageViews.push_back(levelView);
+            levelInfos[i][level] = {
+                    .sampler = VK_NULL_HANDLE,
+                    .imageView = levelView,
+                    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            };
+        }
+        writes.push_back({
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSets[i],
+                .dstBinding = 0,
+                .descriptorCount = MIP_DOWNSAMPLE_MAX_LEVELS,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo = levelInfos[i].data(),
+        });
+        writes.push_back({
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = descriptorSets[i],
+                .dstBinding = 1,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &counterInfo,
+        });
+        barriers.push_back({
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = chain.image,
+                .subresourceRange = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = chain.levelCount,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                },
+        });
+    }
+    vkUpdateDescriptorSets(_logicalDevice, static_cast<uint32_t>(writes.size()), writes.data(), 0,
+                           nullptr);
+
+    vkCmdFillBuffer(_uploadGraphicsCmd, scratch.buffer, 0, VK_WHOLE_SIZE, 0);
+    const VkBufferMemoryBarrier counterBarrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = scratch.buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+    };
+    vkCmdPipelineBarrier(_uploadGraphicsCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1, &counterBarrier,
+                         static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    // dispatches of different images are independent, nothing between them
+    vkCmdBindPipeline(_uploadGraphicsCmd, VK_PIPELINE_BIND_POINT_COMPUTE, _mipDownsamplePipeline);
+    for (uint32_t i = 0; i < chainCount; ++i) {
+        const auto &chain = mipChains[i];
+        const MipDownsampleParams params{
+                .width = chain.width,
+                .height = chain.height,
+                .levelCount = chain.levelCount,
+                .srgb = chain.srgb ? 1u : 0u,
+                .counterIndex = i,
+        };
+        vkCmdBindDescriptorSets(_uploadGraphicsCmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                _mipDownsamplePipelineLayout, 0, 1, &descriptorSets[i], 0,
+                                nullptr);
+        vkCmdPushConstants(_uploadGraphicsCmd, _mipDownsamplePipelineLayout,
+                           VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+        vkCmdDispatch(_uploadGraphicsCmd,
+                      (chain.width + MIP_DOWNSAMPLE_TILE_SIZE - 1) / MIP_DOWNSAMPLE_TILE_SIZE,
+                      (chain.height + MIP_DOWNSAMPLE_TILE_SIZE - 1) / MIP_DOWNSAMPLE_TILE_SIZE, 1);
+    }
+
+    for (auto &barrier: barriers) {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    vkCmdPipelineBarrier(_uploadGraphicsCmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(barriers.size()), barriers.data());
+    LOGI("Mip chains: %u images downsampled, one dispatch each", chainCount);
+}
+
+// blits level 0 of every image down its chain, level by level across all images:
+// one barrier batch per level instead of one barrier per image per level, and the blits of a
+// level are independent so the GPU overlaps them
+void VkApplication::blitMipChains(std::span<const MipChain> mipChains, VkFormat format) {
+    if (mipChains.empty()) {
+        return;
+    }
+    // sample: texturemipmapgen
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(_selectedPhysicalDevice, format, &formatProperties);
+    ASSERT(formatProperties.optimalTilingFeatures &
+           VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT,
+           "Selected Physical Device cannot generate mipmaps");
+
+    uint32_t maxLevelCount = 0;
+    for (const auto &chain: mipChains) {
+        maxLevelCount = std::max(maxLevelCount, chain.levelCount);
+    }
+    std::vector<VkImageMemoryBarrier> barriers;
+    barriers.reserve(mipChains.size() * 2);
+    std::vector<VkImageBlit> blits;
+    uint32_t barrierBatches = 0;
+    for (uint32_t level = 1; level < maxLevelCount; ++level) {
+        // level - 1 of every image still growing was just written: make it the blit source
+        barriers.clear();
+        for (const auto &chain: mipChains) {
+            if (level >= chain.levelCount) {
+                continue;
+            }
+            barriers.push_back({
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                    .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+                    .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .image = chain.image,
+                    .subresourceRange = {
+                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .baseMipLevel = level - 1,
+                            .levelCount = 1,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1,
+                    },
+            });
+        }
+        vkCmdPipelineBarrier(_uploadGraphicsCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                             static_cast<uint32_t>(barriers.size()), barriers.data());
+        ++barrierBatches;
+
+        for (const auto &chain: mipChains) {
+            if (level >= chain.levelCount) {
+                continue;
+            }
+            const int32_t srcW = std::max(chain.width >> (level - 1), 1);
+            const int32_t srcH = std::max(chain.height >> (level - 1), 1);
+            const VkImageBlit imageBlit{
+                    .srcSubresource = {
+                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .mipLevel = level - 1,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1,
+                    },
+                    .srcOffsets = {{0, 0, 0}, {srcW, srcH, 1}},
+                    .dstSubresource = {
+                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .mipLevel = level,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1,
+                    },
+                    .dstOffsets = {{0, 0, 0},
+                                   {std::max(srcW >> 1, 1), std::max(srcH >> 1, 1), 1}},
+            };
+            vkCmdBlitImage(_uploadGraphicsCmd, chain.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           chain.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageBlit,
+                           VK_FILTER_LINEAR);
+        }
+    }
+
+    // every level but the last is TRANSFER_SRC, the last one was blitted into: TRANSFER_DST
+    barriers.clear();
+    for (const auto &chain: mipChains) {
+        VkImageMemoryBarrier barrier{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = chain.image,
+                .subresourceRange = {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                        .baseMipLevel = 0,
+                        .levelCount = chain.levelCount - 1,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                },
+        };
+        if (chain.levelCount > 1) {
+            barriers.push_back(barrier);
+        }
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.subresourceRange.baseMipLevel = chain.levelCount - 1;
+        barrier.subresourceRange.levelCount = 1;
+        barriers.push_back(barrier);
+    }
+    vkCmdPipelineBarrier(_uploadGraphicsCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(barriers.size()), barriers.data());
+    ++barrierBatches;
+    LOGI("Mip chains: %zu images, %u levels, %u barrier batches", mipChains.size(),
+         maxLevelCount, barrierBatches);
+}
+
+// rgba8 image + view for a glb texture, tracked in _glbImages/_glbImageViews
+VkImage VkApplication::createGlbImage(uint32_t width, uint32_t height, uint32_t mipLevels,
+                                      VkImageUsageFlags mipGenerationUsage) {
+    const auto format{VK_FORMAT_R8G8B8A8_UNORM};
+    VkImageCreateInfo imageCreateInfo{};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = format;
+    imageCreateInfo.mipLevels = mipLevels;
+    imageCreateInfo.arrayLayers = 1;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    // mipGenerationUsage: TRANSFER_SRC to blit levels, STORAGE to downsample them, none when
+    // every level is uploaded; both cost the image its framebuffer compression on some gpus
+    imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                            mipGenerationUsage;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageCreateInfo.extent = {width, height, 1};
+    // no need for VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, cpu does not need access
+    const VmaAllocationCreateInfo allocCreateInfo = {
+            .flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT,
+            .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+            .priority = 1.0f,
+    };
+    VkImage glbImage;
+    VmaAllocation glbImageAllocation;
+    VkImageView glbImageView;
+    VK_CHECK(vmaCreateImage(_vmaAllocator, &imageCreateInfo, &allocCreateInfo, &glbImage,
+                            &glbImageAllocation, nullptr));
+    // image view
+    VkImageViewCreateInfo imageViewInfo = {};
+    imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    imageViewInfo.format = format;
+    // subresource range could limit miplevel and layer ranges, here all are open to access
+    imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    imageViewInfo.subresourceRange.baseMipLevel = 0;
+    imageViewInfo.subresourceRange.baseArrayLayer = 0;
+    imageViewInfo.subresourceRange.layerCount = 1;
+#if defined(LINEAR_TILED_IMAGES)
+    imageViewInfo.subresourceRange.levelCount = 1;
+#else
+    imageViewInfo.subresourceRange.levelCount = mipLevels;
+#endif
+    imageViewInfo.image = glbImage;
+    VK_CHECK(vkCreateImageView(_logicalDevice, &imageViewInfo, nullptr, &glbImageView));
+    this->_glbImages.emplace_back(glbImage);
+    this->_glbImageAllocation.emplace_back(glbImageAllocation);
+    this->_glbImageViews.emplace_back(glbImageView);
+    return glbImage;
+}
+
+void VkApplication::createGlbSampler() {
+    VkSampler sampler;
+    VkSamplerCreateInfo samplerCreateInfo = {};
+    samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
+    samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
+    samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+
+    samplerCreateInfo.mipLodBias = 0.0f;
+    samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
+    samplerCreateInfo.minLod = 0.0f;
+#if defined(LINEAR_TILED_IMAGES)
+    samplerCreateInfo.maxLod = 0.0f;
+#else
+    samplerCreateInfo.maxLod = 10.f;
+#endif
+    // Enable anisotropic filtering
+    if (_enabledDeviceFeatures.features.samplerAnisotropy) {
+        // Use max. level of anisotropy for this example
+        samplerCreateInfo.maxAnisotropy = _physicalDevicesProp1.limits.maxSamplerAnisotropy;
+        samplerCreateInfo.anisotropyEnable = VK_TRUE;
+    } else {
+        samplerCreateInfo.maxAnisotropy = 1.0;
+        samplerCreateInfo.anisotropyEnable = VK_FALSE;
+    }
+    samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    VK_CHECK(vkCreateSampler(_logicalDevice, &samplerCreateInfo, nullptr, &sampler));
+    _glbSamplers.emplace_back(sampler);
+}
+
+// one IndirectDrawForVulkan and lod chain per scene draw, lod 0 until a frame picks a level
+static void buildGlbDraws(const Scene &scene, std::vector<IndirectDrawForVulkan> &draws,
+                          std::vector<DrawLods> &drawLods) {
+    draws.clear();
+    draws.reserve(scene.meshes.size());
+    drawLods.clear();
+    drawLods.reserve(scene.meshes.size());
+    size_t meshId = 0;
+    for (const auto &mesh: scene.meshes) {
+        // instancing was resolved by the reader: draws and meshes are 1:1
+        const auto &draw = scene.indirectDraw[meshId];
+        const uint32_t firstIndex = draw.firstIndex;
+        draws.emplace_back(IndirectDrawForVulkan{
+                .indexCount = draw.indexCount,
+                .instanceCount = draw.instanceCount,
+                .firstIndex = firstIndex,
+                .vertexOffset = static_cast<int>(draw.vertexOffset),
+                .firstInstance = draw.firstInstance,
+                .meshId = static_cast<uint32_t>(meshId),
+                .materialIndex = static_cast<uint32_t>(mesh.materialIdx),
+                .boundsMin = {mesh.minAABB[COMPONENT::X], mesh.minAABB[COMPONENT::Y],
+                              mesh.minAABB[COMPONENT::Z]},
+                .boundsMax = {mesh.maxAABB[COMPONENT::X], mesh.maxAABB[COMPONENT::Y],
+                              mesh.maxAABB[COMPONENT::Z]},
+        });
+        DrawLods lods{.lodCount = 1, .lods = {{.firstIndex = firstIndex,
+                                               .indexCount = draw.indexCount}}};
+        if (!mesh.lods.empty()) {
+            lods.lodCount = static_cast<uint32_t>(std::min<size_t>(mesh.lods.size(),
+                                                                   MAX_MESH_LODS));
+            for (uint32_t level = 0; level < lods.lodCount; ++level) {
+                lods.lods[level] = mesh.lods[level];
+                lods.lods[level].firstIndex += firstIndex;
+            }
+        }
+        drawLods.push_back(lods);
+        ++meshId;
+    }
+}
+
 void VkApplication::loadGLB() {
     std::string filename = getAssetPath() + "AnisotropyBarnLamp.glb";
+    const auto start = std::chrono::steady_clock::now();
 
     // Load GLB
     AAsset *glbAsset = AAssetManager_open(_assetManager, filename.c_str(), AASSET_MODE_BUFFER);
+    ASSERT(glbAsset, "Could not open glb asset");
+    // AASSET_MODE_BUFFER: stored assets are mmapped, the reader parses straight out of it
+    const auto *glbBuffer = static_cast<const std::byte *>(AAsset_getBuffer(glbAsset));
     size_t glbByteSize = AAsset_getLength(glbAsset);
-    std::vector<char> glbContent;
-    glbContent.resize(glbByteSize);
-    AAsset_read(glbAsset, glbContent.data(), glbByteSize);
+    const std::span<const std::byte> glbBytes(glbBuffer, glbByteSize);
+
+    // warm start: the cooked scene is already in upload-ready layout,
+    // no gltf parsing, no accessor reads, no image decoding
+    SceneCache sceneCache(_cacheDirectory, filename, hashSceneSource(glbBytes),
+                          QUANTIZE_GLB_VERTICES ? sizeof(QuantizedVertex) : sizeof(Vertex));
+    if (_vk12features.bufferDeviceAddress && sceneCache.load()) {
+        AAsset_close(glbAsset);
+        uploadCookedScene(sceneCache.scene());
+        const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        LOGI("loadGLB: %s from scene cache in %lld ms", filename.c_str(),
+             static_cast<long long>(elapsedMs));
+        return;
+    }
 
-    GltfBinaryIOReader reader;
-    std::shared_ptr<Scene> scene = reader.read(glbContent);
+    GltfBinaryIOReader reader({
+            .meshDecodeConcurrency = WorkerPool::hardwareConcurrency(),
+            .textureDecodeConcurrency = WorkerPool::hardwareConcurrency(),
+            .quantizeVertices = QUANTIZE_GLB_VERTICES,
+            // quantization needs the normals, which only exist while decoding: then every stage
+            // runs here. otherwise the streams are decoded in place into staging and the stages
+            // run when the scene is cooked, the warm path gets their output
+            .optimizeMeshes = QUANTIZE_GLB_VERTICES,
+            .buildMeshlets = QUANTIZE_GLB_VERTICES,
+            .generateLods = QUANTIZE_GLB_VERTICES,
+            // vertices and indices are written once, into the buffer the upload copies from
+            .stageGeometry = [this](size_t vertexByteSize, size_t indexByteSize) {
+                _stagingGeometry = _stagingRing.allocate(vertexByteSize + indexByteSize);
+                return _stagingGeometry.memory;
+            },
+    });
+    std::shared_ptr<Scene> scene = reader.read(glbBytes);
+    AAsset_close(glbAsset);
     _numMeshes = scene->meshes.size();
 
     // check device feature supported
     if (_vk12features.bufferDeviceAddress) {
+        // ssbo for vertices
+        _compositeVBSizeInByte = scene->totalVerticesByteSize;
+        createGlbDeviceBuffer(_compositeVBSizeInByte, 0, _compositeVB);
+        // ssbo for ib
+        _compositeIBSizeInByte = scene->totalIndexByteSize;
+        createGlbDeviceBuffer(_compositeIBSizeInByte,
+                              VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                              _compositeIB);
+
+        // the reader left the composite streams in the staged geometry:
+        // vertices first, indices right behind them, one copy each
         {
-            // ssbo for vertices
-            auto bufferByteSize = scene->totalVerticesByteSize;
-            _compositeVBSizeInByte = bufferByteSize;
-            VkBufferUsageFlags bufferUsageFlag{
-                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-                    | VK_BUFFER_USAGE_TRANSFER_DST_BIT
-                    //                    | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR
-                    | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
-            VmaMemoryUsage memoryUsage{
-                    VMA_MEMORY_USAGE_GPU_ONLY
-            };
-            VmaAllocation vmaCompositeVerticeBufferAllocation{nullptr};
-            VkBufferCreateInfo bufferCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                    .size = bufferByteSize,
-                    .usage = bufferUsageFlag,
-            };
-            // for device buffer
-            // VK_MEMORY_PROPERTY_HOST_CACHED_BIT bit specifies that memory allocated with this type is cached on the host
-            const VmaAllocationCreateInfo deviceBufferAllocationCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                    .usage = memoryUsage,
-                    .preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT
-            };
-            VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo,
-                                     &deviceBufferAllocationCreateInfo,
-                                     &_compositeVB,
-                                     &vmaCompositeVerticeBufferAllocation, nullptr));
+            VkBufferCopy region{.srcOffset = _stagingGeometry.offset, .dstOffset = 0,
+                    .size = _compositeVBSizeInByte};
+            vkCmdCopyBuffer(_uploadCmd, _stagingGeometry.buffer, _compositeVB, 1, &region);
         }
-
         {
-            // ssbo for ib
-            auto bufferByteSize = scene->totalIndexByteSize;
-            _compositeIBSizeInByte = bufferByteSize;
-            VkBufferUsageFlags bufferUsageFlag{
-                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-                    | VK_BUFFER_USAGE_TRANSFER_DST_BIT
-                    | VK_BUFFER_USAGE_INDEX_BUFFER_BIT
-                    | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
-                    | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT};
-            VmaMemoryUsage memoryUsage{
-                    VMA_MEMORY_USAGE_GPU_ONLY
-            };
-
-            VmaAllocation vmaCompositeIndicesBufferAllocation{VK_NULL_HANDLE};
-            VkBufferCreateInfo bufferCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                    .size = bufferByteSize,
-                    .usage = bufferUsageFlag,
-            };
-
-            // for device buffer
-            // VK_MEMORY_PROPERTY_HOST_CACHED_BIT bit specifies that memory allocated with this type is cached on the host
-            const VmaAllocationCreateInfo deviceBufferAllocationCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                    .usage = memoryUsage,
-                    .preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT
-            };
-
-            VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo,
-                                     &deviceBufferAllocationCreateInfo,
-                                     &_compositeIB,
-                                     &vmaCompositeIndicesBufferAllocation, nullptr));
+            VkBufferCopy region{.srcOffset = _stagingGeometry.offset + _compositeVBSizeInByte,
+                    .dstOffset = 0, .size = _compositeIBSizeInByte};
+            vkCmdCopyBuffer(_uploadCmd, _stagingGeometry.buffer, _compositeIB, 1, &region);
         }
+        transferBufferToGraphics(_compositeVB);
+        transferBufferToGraphics(_compositeIB);
 
-        // upload data to buffer
-        uint32_t currentVertexStartingIndex = 0u;
-        uint32_t currentIndicesStartingIndex = 0u;
-        // firstIndex of the composite index buffer for current draw
-        uint32_t firstIndex = 0u;
-        // offset into composite vertice buffer
-        uint32_t vertexOffset = 0u;
         std::vector<IndirectDrawForVulkan> indirectDrawParams;
-        indirectDrawParams.reserve(scene->meshes.size());
-        uint32_t deviceCompositeVertexBufferOffsetInBytes = 0u;
-        uint32_t deviceCompositeIndicesBufferOffsetInBytes = 0u;
-        size_t meshId = 0;
-        for (const auto &mesh: scene->meshes) {
-            auto vertexByteSizeMesh = sizeof(Vertex) * mesh.vertices.size();
-            auto vertexBufferPtr = reinterpret_cast<const void *>(mesh.vertices.data());
-            // to upload data from host to device, needs stagingBuffer
-            // create stagingVbForMesh to streaming only this mesh to device buffer
-            VmaAllocation vmaStagingMeshVerticesBufferAllocation{nullptr};
-            VkBufferCreateInfo verticeBufferCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                    .size = vertexByteSizeMesh,
-                    .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            };
-            const VmaAllocationCreateInfo stagingVerticeBufferAllocationCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                    .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-                    .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            };
-            VkBuffer stagingVerticeBuffer;
-            VK_CHECK(vmaCreateBuffer(_vmaAllocator, &verticeBufferCreateInfo,
-                                     &stagingVerticeBufferAllocationCreateInfo,
-                                     &stagingVerticeBuffer,
-                                     &vmaStagingMeshVerticesBufferAllocation, nullptr));
-            _stagingVbForMesh.push_back(stagingVerticeBuffer);
-            // copy vb from host to device, region
-            void *mappedMemory{nullptr};
-            VK_CHECK(vmaMapMemory(_vmaAllocator, vmaStagingMeshVerticesBufferAllocation,
-                                  &mappedMemory));
-            memcpy(mappedMemory, vertexBufferPtr, vertexByteSizeMesh);
-            vmaUnmapMemory(_vmaAllocator, vmaStagingMeshVerticesBufferAllocation);
-            // cmd to copy from staging to device
-            VkBufferCopy region{.srcOffset = 0,
-                    .dstOffset = deviceCompositeVertexBufferOffsetInBytes,
-                    .size = vertexByteSizeMesh};
-            vkCmdCopyBuffer(_uploadCmd, stagingVerticeBuffer, _compositeVB, 1, &region);
-
-            deviceCompositeVertexBufferOffsetInBytes += vertexByteSizeMesh;
-
-            // copy ib from host to device
-            auto indicesByteSizeMesh = sizeof(uint32_t) * mesh.indices.size();
-            auto indicesBufferPtr = reinterpret_cast<const void *>(mesh.indices.data());
-
-            VmaAllocation vmaStagingMeshIndiceBufferAllocation{nullptr};
-            VkBufferCreateInfo bufferCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                    .size = indicesByteSizeMesh,
-                    .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            };
-            const VmaAllocationCreateInfo stagingAllocationCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                    .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-                    .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            };
-            VkBuffer stagingIndiceBuffer;
-            VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo, &stagingAllocationCreateInfo,
-                                     &stagingIndiceBuffer,
-                                     &vmaStagingMeshIndiceBufferAllocation, nullptr));
-            _stagingIbForMesh.push_back(stagingIndiceBuffer);
-            // copy ib from host to device, region
-            void *mappedMemoryForIB{nullptr};
-            VK_CHECK(vmaMapMemory(_vmaAllocator, vmaStagingMeshIndiceBufferAllocation,
-                                  &mappedMemoryForIB));
-            memcpy(mappedMemoryForIB, indicesBufferPtr, indicesByteSizeMesh);
-            vmaUnmapMemory(_vmaAllocator, vmaStagingMeshIndiceBufferAllocation);
-
-            // cmd to copy from staging to device
-            VkBufferCopy regionForIB{.srcOffset = 0,
-                    .dstOffset = deviceCompositeIndicesBufferOffsetInBytes,
-                    .size = indicesByteSizeMesh};
-            vkCmdCopyBuffer(_uploadCmd, stagingIndiceBuffer, _compositeIB, 1, &regionForIB);
-
-            deviceCompositeIndicesBufferOffsetInBytes += indicesByteSizeMesh;
-            // reserve still needs push_back/emplace_back
-            indirectDrawParams.emplace_back(IndirectDrawForVulkan{
-                    .indexCount = uint32_t(mesh.indices.size()),
-                    .instanceCount = 1,
-                    .firstIndex = firstIndex,
-                    .vertexOffset = static_cast<int>(vertexOffset),
-                    .firstInstance = 0,
-                    .meshId = static_cast<uint32_t>(meshId),
-                    .materialIndex = static_cast<uint32_t>(mesh.materialIdx),
-            });
-            vertexOffset += mesh.vertices.size();
-            firstIndex += mesh.indices.size();
-            ++meshId;
-        }
+        std::vector<DrawLods> drawLods;
+        buildGlbDraws(*scene, indirectDrawParams, drawLods);
         // textures
         // 1. create image
         // 2. create image view
         // 3. upload through stage buffer
-        for (const auto &texture: scene->textures) {
+        // base color texels are sRGB encoded: their mips are filtered in linear space
+        std::vector<bool> srgbTextures(scene->textures.size(), false);
+        for (const auto &material: scene->materials) {
+            if (material.basecolorTextureId >= 0 &&
+                material.basecolorTextureId < static_cast<int>(srgbTextures.size())) {
+                srgbTextures[material.basecolorTextureId] = true;
+            }
+        }
+        std::vector<MipChain> mipChains;
+        mipChains.reserve(scene->textures.size());
+        for (size_t textureId = 0; textureId < scene->textures.size(); ++textureId) {
+            const auto &texture = scene->textures[textureId];
             const auto textureMipLevels = getMipLevelsCount(texture->width,
                                                             texture->height);
-            const auto format{VK_FORMAT_R8G8B8A8_UNORM};
-            VkImageCreateInfo imageCreateInfo{};
-            imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-            imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-            imageCreateInfo.format = format;
-            imageCreateInfo.mipLevels = textureMipLevels;
-            imageCreateInfo.arrayLayers = 1;
-            imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-            imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-            // usage here: both dst and src as mipmap generation
-            imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT
-                                    | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-            imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-            imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imageCreateInfo.extent = {static_cast<uint32_t>(texture->width),
-                                      static_cast<uint32_t>(texture->height), 1};
-            // no need for VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT, cpu does not need access
-            const VmaAllocationCreateInfo allocCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT,
-                    .usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-                    .priority = 1.0f,
-            };
-            VkImage glbImage;
-            VmaAllocation glbImageAllocation;
-            VkImageView glbImageView;
-            VK_CHECK(vmaCreateImage(_vmaAllocator, &imageCreateInfo, &allocCreateInfo, &glbImage,
-                                    &glbImageAllocation, nullptr));
-            // image view
-            VkImageViewCreateInfo imageViewInfo = {};
-            imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-            imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-            imageViewInfo.format = format;
-            // subresource range could limit miplevel and layer ranges, here all are open to access
-            imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            imageViewInfo.subresourceRange.baseMipLevel = 0;
-            imageViewInfo.subresourceRange.baseArrayLayer = 0;
-            imageViewInfo.subresourceRange.layerCount = 1;
-#if defined(LINEAR_TILED_IMAGES)
-            imageViewInfo.subresourceRange.levelCount = 1;
-#else
-            imageViewInfo.subresourceRange.levelCount = textureMipLevels;
-#endif
-            imageViewInfo.image = glbImage;
-            VK_CHECK(vkCreateImageView(_logicalDevice, &imageViewInfo, nullptr, &glbImageView));
-            this->_glbImages.emplace_back(glbImage);
-            this->_glbImageAllocation.emplace_back(glbImageAllocation);
-            this->_glbImageViews.emplace_back(glbImageView);
+            const bool computeMips = COMPUTE_MIP_GENERATION &&
+                                     std::max(texture->width, texture->height) <=
+                                     static_cast<int>(MIP_DOWNSAMPLE_MAX_SIZE);
+            VkImage glbImage = createGlbImage(texture->width, texture->height, textureMipLevels,
+                                              computeMips ? VK_IMAGE_USAGE_STORAGE_BIT
+                                                          : VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 
             // staging buffer
-            ASSERT(glbImageAllocation, "glbImageAllocation should be defined");
-
-            VmaAllocationInfo glbImageAllocationInfo;
-            vmaGetAllocationInfo(_vmaAllocator, glbImageAllocation, &glbImageAllocationInfo);
-            const auto stagingBufferSize = glbImageAllocationInfo.size;
-
-            VmaAllocation vmaStagingBufferAllocation{nullptr};
-            VkBuffer glbImageStagingBuffer;
-            VkBufferCreateInfo bufferCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                    .size = stagingBufferSize,
-                    .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT, // for staging buffer
-                    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            };
-            const VmaAllocationCreateInfo stagingAllocationCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                    .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-            };
-            VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo, &stagingAllocationCreateInfo,
-                                     &glbImageStagingBuffer,
-                                     &vmaStagingBufferAllocation, nullptr));
-            _glbImageStagingBuffer.emplace_back(glbImageStagingBuffer);
-            if (vmaStagingBufferAllocation != nullptr) {
-                void *imageDataPtr{nullptr};
-                // format: VK_FORMAT_R8G8B8A8_UNORM took 4 bytes
-                const auto imageDataSizeInBytes = texture->width * texture->height * 1 * 4;
-                VK_CHECK(vmaMapMemory(_vmaAllocator, vmaStagingBufferAllocation,
-                                      &imageDataPtr));
-                memcpy(imageDataPtr, texture->data, imageDataSizeInBytes);
-                vmaUnmapMemory(_vmaAllocator, vmaStagingBufferAllocation);
-                // image layout from undefined to write dst
-                // transition layout
-                // barrier based on mip level, array layers
-                VkImageSubresourceRange subresourceRange = {};
-                subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                subresourceRange.baseMipLevel = 0;
-                subresourceRange.levelCount = textureMipLevels;
-                subresourceRange.layerCount = 1;
-
-                VkImageMemoryBarrier imageMemoryBarrier{};
-                imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                imageMemoryBarrier.image = glbImage;
-                imageMemoryBarrier.subresourceRange = subresourceRange;
-                imageMemoryBarrier.srcAccessMask = VK_ACCESS_NONE; //0: VK_ACCESS_NONE
-                imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                // VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: written into
-                imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-
-                vkCmdPipelineBarrier(
-                        _uploadCmd,
-                        VK_PIPELINE_STAGE_HOST_BIT,
-                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                        0,
-                        0, nullptr,
-                        0, nullptr,
-                        1, &imageMemoryBarrier);
-                // now image layout(usage) is writable
-                // staging buffer to device-local(image is device local memory)
-                VkBufferImageCopy bufferCopyRegion = {};
-                // mipmap level0: original copy
-                bufferCopyRegion.bufferOffset = 0;
-                // could be depth, stencil and color
-                bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                bufferCopyRegion.imageSubresource.mipLevel = 0;
-                bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
-                bufferCopyRegion.imageSubresource.layerCount = 1;
-                bufferCopyRegion.imageOffset.x = bufferCopyRegion.imageOffset.y =
-                bufferCopyRegion.imageOffset.z = 0;
-                // primad mipmap hierachy
-                bufferCopyRegion.imageExtent.width = texture->width;
-                bufferCopyRegion.imageExtent.height = texture->height;
-                bufferCopyRegion.imageExtent.depth = 1;
-                vkCmdCopyBufferToImage(
-                        _uploadCmd,
-                        glbImageStagingBuffer,
-                        glbImage,
-                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        1,
-                        &bufferCopyRegion);
-
-                {
-                    // generate mipmaps
-                    // sample: texturemipmapgen
-                    VkFormatProperties formatProperties;
-                    vkGetPhysicalDeviceFormatProperties(_selectedPhysicalDevice,
-                                                        format, &formatProperties);
-                    ASSERT(formatProperties.optimalTilingFeatures &
-                           VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT,
-                           "Selected Physical Device cannot generate mipmaps");
-
-                    VkImageSubresourceRange subresourceRange = {};
-                    subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                    subresourceRange.baseMipLevel = 0;
-                    subresourceRange.levelCount = 1;
-                    subresourceRange.baseArrayLayer = 0;
-                    subresourceRange.layerCount = 1;
-
-                    VkImageMemoryBarrier imageMemoryBarrier{};
-                    imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                    imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                    imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                    imageMemoryBarrier.image = glbImage;
-                    imageMemoryBarrier.subresourceRange = subresourceRange;
-                    imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                    imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-                    imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                    imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-
-                    int32_t w = texture->width;
-                    int32_t h = texture->height;
-                    for (uint32_t i = 1; i <= textureMipLevels; ++i) {
-                        // Prepare current mip level as image blit source for next level
-                        imageMemoryBarrier.subresourceRange.baseMipLevel = i - 1;
-                        vkCmdPipelineBarrier(
-                                _uploadCmd,
-                                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                0,
-                                0, nullptr,
-                                0, nullptr,
-                                1, &imageMemoryBarrier);
-                        // level0 write, barrier, level0 read, level 1write, barrier
-                        // level1 read, ....
-                        if (i == textureMipLevels) {
-                            break;
-                        }
-                        const int32_t newW = w > 1 ? w >> 1 : w;
-                        const int32_t newH = h > 1 ? h >> 1 : h;
-
-                        VkImageBlit imageBlit{};
-                        imageBlit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                        imageBlit.srcSubresource.layerCount = 1;
-                        imageBlit.srcSubresource.baseArrayLayer = 0;
-                        imageBlit.srcSubresource.mipLevel = i - 1;
-                        imageBlit.srcOffsets[0].x = imageBlit.srcOffsets[0].y = imageBlit.srcOffsets[0].z = 0;
-                        imageBlit.srcOffsets[1].x = w;
-                        imageBlit.srcOffsets[1].y = h;
-                        imageBlit.srcOffsets[1].z = 1;
-
-                        imageBlit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-                        imageBlit.dstSubresource.layerCount = 1;
-                        imageBlit.srcSubresource.baseArrayLayer = 0;
-                        imageBlit.dstSubresource.mipLevel = i;
-                        imageBlit.dstOffsets[1].x = newW;
-                        imageBlit.dstOffsets[1].y = newH;
-                        imageBlit.dstOffsets[1].z = 1;
-
-                        vkCmdBlitImage(_uploadCmd,
-                                       glbImage,
-                                       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                       glbImage,
-                                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                       1,
-                                       &imageBlit,
-                                       VK_FILTER_LINEAR);
-                        w = newW;
-                        h = newH;
-                    }
-                    // all mip layers are in TRANSFER_SRC --> SHADER_READ
-                    const VkImageMemoryBarrier convertToShaderReadBarrier = {
-                            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-                            .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                            .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                            .image = glbImage,
-                            .subresourceRange =
-                                    {
-                                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                            .baseMipLevel = 0,
-                                            .levelCount = textureMipLevels,
-                                            .baseArrayLayer = 0,
-                                            .layerCount = 1,
-                                    },
-
-                    };
-                    vkCmdPipelineBarrier(_uploadCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
-                                         nullptr,
-                                         1, &convertToShaderReadBarrier);
-                }
-            }
-        }
-        // sampler
-        {
-            VkSampler sampler;
-            VkSamplerCreateInfo samplerCreateInfo = {};
-            samplerCreateInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-            samplerCreateInfo.magFilter = VK_FILTER_LINEAR;
-            samplerCreateInfo.minFilter = VK_FILTER_LINEAR;
-            samplerCreateInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-            samplerCreateInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-            samplerCreateInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-            samplerCreateInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-
-            samplerCreateInfo.mipLodBias = 0.0f;
-            samplerCreateInfo.compareOp = VK_COMPARE_OP_NEVER;
-            samplerCreateInfo.minLod = 0.0f;
-#if defined(LINEAR_TILED_IMAGES)
-            samplerCreateInfo.maxLod = 0.0f;
-#else
-            samplerCreateInfo.maxLod = 10.f;
-#endif
-            // Enable anisotropic filtering
-            if (_enabledDeviceFeatures.features.samplerAnisotropy) {
-                // Use max. level of anisotropy for this example
-                samplerCreateInfo.maxAnisotropy = _physicalDevicesProp1.limits.maxSamplerAnisotropy;
-                samplerCreateInfo.anisotropyEnable = VK_TRUE;
-            } else {
-                samplerCreateInfo.maxAnisotropy = 1.0;
-                samplerCreateInfo.anisotropyEnable = VK_FALSE;
-            }
-            samplerCreateInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-            VK_CHECK(vkCreateSampler(_logicalDevice, &samplerCreateInfo, nullptr, &sampler));
-            _glbSamplers.emplace_back(sampler);
+            // format: VK_FORMAT_R8G8B8A8_UNORM took 4 bytes
+            const auto imageDataSizeInBytes = texture->width * texture->height * 1 * 4;
+            const auto stagingImage = _stagingRing.stage(texture->data, imageDataSizeInBytes);
+            // image layout from undefined to write dst
+            // transition layout
+            // barrier based on mip level, array layers
+            VkImageSubresourceRange subresourceRange = {};
+            subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            subresourceRange.baseMipLevel = 0;
+            subresourceRange.levelCount = textureMipLevels;
+            subresourceRange.layerCount = 1;
+
+            VkImageMemoryBarrier imageMemoryBarrier{};
+            imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageMemoryBarrier.image = glbImage;
+            imageMemoryBarrier.subresourceRange = subresourceRange;
+            imageMemoryBarrier.srcAccessMask = VK_ACCESS_NONE; //0: VK_ACCESS_NONE
+            imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            // VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: written into
+            imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+            vkCmdPipelineBarrier(
+                    _uploadCmd,
+                    VK_PIPELINE_STAGE_HOST_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0,
+                    0, nullptr,
+                    0, nullptr,
+                    1, &imageMemoryBarrier);
+            // now image layout(usage) is writable
+            // staging buffer to device-local(image is device local memory)
+            VkBufferImageCopy bufferCopyRegion = {};
+            // mipmap level0: original copy
+            bufferCopyRegion.bufferOffset = stagingImage.offset;
+            // could be depth, stencil and color
+            bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            bufferCopyRegion.imageSubresource.mipLevel = 0;
+            bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+            bufferCopyRegion.imageSubresource.layerCount = 1;
+            bufferCopyRegion.imageOffset.x = bufferCopyRegion.imageOffset.y =
+            bufferCopyRegion.imageOffset.z = 0;
+            // primad mipmap hierachy
+            bufferCopyRegion.imageExtent.width = texture->width;
+            bufferCopyRegion.imageExtent.height = texture->height;
+            bufferCopyRegion.imageExtent.depth = 1;
+            vkCmdCopyBufferToImage(
+                    _uploadCmd,
+                    stagingImage.buffer,
+                    glbImage,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    1,
+                    &bufferCopyRegion);
+            // blits need the graphics queue: it takes the image over, still TRANSFER_DST
+            transferImageToGraphics(glbImage, subresourceRange,
+                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                    VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+
+            mipChains.push_back({.image = glbImage, .width = static_cast<int32_t>(texture->width),
+                                 .height = static_cast<int32_t>(texture->height),
+                                 .levelCount = textureMipLevels,
+                                 .srgb = srgbTextures[textureId], .compute = computeMips});
         }
+        generateMipChains(mipChains, VK_FORMAT_R8G8B8A8_UNORM);
+        createGlbSampler();
 
         // packing materials into composite buffer
         const auto materialByteSize = sizeof(Material) * scene->materials.size();
+        _compositeMatBSizeInByte = materialByteSize;
+        createGlbDeviceBuffer(materialByteSize, 0, _compositeMatB);
         {
-            // create device buffer
-            auto bufferByteSize = materialByteSize;
-            _compositeMatBSizeInByte = bufferByteSize;
-            VkBufferUsageFlags bufferUsageFlag{
-                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-                    | VK_BUFFER_USAGE_TRANSFER_DST_BIT
-                    | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT};
-            VmaMemoryUsage memoryUsage{
-                    VMA_MEMORY_USAGE_GPU_ONLY
-            };
-
-            VmaAllocation vmaMaterialBufferAllocation{VK_NULL_HANDLE};
-            VkBufferCreateInfo bufferCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                    .size = bufferByteSize,
-                    .usage = bufferUsageFlag,
-            };
-
-            // for device buffer
-            // VK_MEMORY_PROPERTY_HOST_CACHED_BIT bit specifies that memory allocated with this type is cached on the host
-            const VmaAllocationCreateInfo deviceBufferAllocationCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                    .usage = memoryUsage,
-                    .preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT
-            };
-            VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo,
-                                     &deviceBufferAllocationCreateInfo,
-                                     &_compositeMatB,
-                                     &vmaMaterialBufferAllocation, nullptr));
-        }
-        {
-            // create staging buffer
-            auto materialBufferPtr = reinterpret_cast<const void *>(scene->materials.data());
-            // staging buffer for matBuffer
-            VmaAllocation vmaStagingMatBufferAllocation{nullptr};
-            VkBufferCreateInfo bufferCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                    .size = materialByteSize,
-                    .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            };
-            const VmaAllocationCreateInfo stagingAllocationCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                    .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-                    .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-            };
-            VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo,
-                                     &stagingAllocationCreateInfo,
-                                     &_stagingMatBuffer,
-                                     &vmaStagingMatBufferAllocation, nullptr));
-            // copy matBuffer from host to device, region
-            void *mappedMemoryForMatB{nullptr};
-            VK_CHECK(vmaMapMemory(_vmaAllocator, vmaStagingMatBufferAllocation,
-                                  &mappedMemoryForMatB));
-            memcpy(mappedMemoryForMatB, materialBufferPtr, materialByteSize);
-            vmaUnmapMemory(_vmaAllocator, vmaStagingMatBufferAllocation);
-        }
-        {
+            const auto staging = _stagingRing.stage(scene->materials.data(), materialByteSize);
             // cmd to copy from staging to device
-            VkBufferCopy regionForMatB{.srcOffset = 0,
+            VkBufferCopy regionForMatB{.srcOffset = staging.offset,
                     .dstOffset = 0,
                     .size = materialByteSize};
-            vkCmdCopyBuffer(_uploadCmd, _stagingMatBuffer, _compositeMatB, 1, &regionForMatB);
+            vkCmdCopyBuffer(_uploadCmd, staging.buffer, _compositeMatB, 1, &regionForMatB);
+            transferBufferToGraphics(_compositeMatB);
         }
 
         // packing for indirectDrawBuffer
         const auto indirectDrawBufferByteSize =
                 sizeof(IndirectDrawForVulkan) * indirectDrawParams.size();
+        _indirectDrawBSizeInByte = indirectDrawBufferByteSize;
+        // both ib and indirectDraw buffer have flag: VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+        createGlbDeviceBuffer(indirectDrawBufferByteSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                              _indirectDrawB);
         {
-            // create device buffer for indirectDraw
-            auto bufferByteSize = indirectDrawBufferByteSize;
-            _indirectDrawBSizeInByte = bufferByteSize;
-            // both ib and indirectDraw buffer have flag: VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
-            VkBufferUsageFlags bufferUsageFlag{
-                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-                    | VK_BUFFER_USAGE_TRANSFER_DST_BIT
-                    | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
-                    | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT};
-            VmaMemoryUsage memoryUsage{
-                    VMA_MEMORY_USAGE_GPU_ONLY
-            };
+            const auto staging = _stagingRing.stage(indirectDrawParams.data(),
+                                                    indirectDrawBufferByteSize);
+            // cmd to copy from staging to device
+            VkBufferCopy region{.srcOffset = staging.offset,
+                    .dstOffset = 0,
+                    .size = indirectDrawBufferByteSize};
+            vkCmdCopyBuffer(_uploadCmd, staging.buffer, _indirectDrawB, 1, &region);
+            transferBufferToGraphics(_indirectDrawB);
+        }
 
-            VmaAllocation vmaIndirectDrawBufferAllocation{VK_NULL_HANDLE};
-            VkBufferCreateInfo bufferCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                    .size = bufferByteSize,
-                    .usage = bufferUsageFlag,
-            };
+        // per-instance transforms
+        _instanceTransformBSizeInByte = sizeof(mat4x4f) * scene->instanceTransforms.size();
+        createGlbDeviceBuffer(_instanceTransformBSizeInByte, 0, _instanceTransformB);
+        {
+            const auto staging = _stagingRing.stage(scene->instanceTransforms.data(),
+                                                    _instanceTransformBSizeInByte);
+            VkBufferCopy region{.srcOffset = staging.offset,
+                    .dstOffset = 0,
+                    .size = _instanceTransformBSizeInByte};
+            vkCmdCopyBuffer(_uploadCmd, staging.buffer, _instanceTransformB, 1, &region);
+            transferBufferToGraphics(_instanceTransformB);
+        }
 
-            // for device buffer
-            // VK_MEMORY_PROPERTY_HOST_CACHED_BIT bit specifies that memory allocated with this type is cached on the host
-            const VmaAllocationCreateInfo deviceBufferAllocationCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                    .usage = memoryUsage,
-                    .preferredFlags = VK_MEMORY_PROPERTY_HOST_CACHED_BIT
+        uploadGlbMeshlets(scene->meshlets, scene->meshletVertices, scene->meshletTriangles);
+
+        _instanceTransforms = scene->instanceTransforms;
+
+        // the cook for the next launch, with the stages the cold path skipped, is prepared here
+        // and started by initVulkan once the uploads are submitted (startSceneCook); only the
+        // copy of the streams stays on the load path: the staged ones are reclaimed as soon as
+        // the upload completed, the cook thread reads the scene's own copy
+        if (sceneCache.enabled()) {
+            scene->ownedGeometry.assign(_stagingGeometry.memory.begin(),
+                                        _stagingGeometry.memory.begin() +
+                                        _compositeVBSizeInByte + _compositeIBSizeInByte);
+            scene->vertexBytes = std::span<const std::byte>(scene->ownedGeometry)
+                    .first(_compositeVBSizeInByte);
+            scene->indices = {reinterpret_cast<const uint32_t *>(scene->ownedGeometry.data() +
+                                                                 _compositeVBSizeInByte),
+                              _compositeIBSizeInByte / sizeof(uint32_t)};
+            _sceneCook = [scene, cache = std::make_shared<SceneCache>(std::move(sceneCache)),
+                          srgbTextures, indirectDrawParams, drawLods]() {
+                WorkerPool cookPool(WorkerPool::hardwareConcurrency());
+                if (scene->quantizedVertices) {
+                    cache->store(*scene, indirectDrawParams, drawLods, srgbTextures, cookPool);
+                    return;
+                }
+                refineSceneGeometry(*scene, {.optimizeMeshes = true, .buildMeshlets = true,
+                                             .generateLods = true}, cookPool);
+                std::vector<IndirectDrawForVulkan> cookedDraws;
+                std::vector<DrawLods> cookedLods;
+                buildGlbDraws(*scene, cookedDraws, cookedLods);
+                cache->store(*scene, cookedDraws, cookedLods, srgbTextures, cookPool);
             };
-            VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo,
-                                     &deviceBufferAllocationCreateInfo,
-                                     &_indirectDrawB,
-                                     &vmaIndirectDrawBufferAllocation, nullptr));
         }
-        {
-            // create staging buffer
-            auto indirectDrawBufferPtr = reinterpret_cast<const void *>(indirectDrawParams.data());
-            // staging buffer for indirectDrawBuffer
-            VmaAllocation vmaStagingIndirectDrawBufferAllocation{nullptr};
-            VkBufferCreateInfo bufferCreateInfo{
-                    .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                    .size = indirectDrawBufferByteSize,
-                    .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-            };
-            const VmaAllocationCreateInfo stagingAllocationCreateInfo = {
-                    .flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                             VMA_ALLOCATION_CREATE_MAPPED_BIT,
-                    .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-                    .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+
+        _indirectDrawParams = std::move(indirectDrawParams);
+        _drawLods = std::move(drawLods);
+    }
+    const auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    LOGI("loadGLB: %s parsed in %lld ms", filename.c_str(), static_cast<long long>(elapsedMs));
+}
+
+void VkApplication::startSceneCook() {
+    if (!_sceneCook) {
+        return;
+    }
+    // cpu only: the scene and the cache file, no vulkan object
+    _sceneCookThread = std::thread(std::move(_sceneCook));
+    _sceneCook = nullptr;
+}
+
+// warm start: every stream is contiguous in the cache, one staging buffer and one copy each
+void VkApplication::uploadCookedScene(const CookedScene &scene) {
+    _numMeshes = scene.indirectDraws.size();
+
+    _compositeVBSizeInByte = scene.vertices.size_bytes();
+    createGlbDeviceBuffer(_compositeVBSizeInByte, 0, _compositeVB);
+    _compositeIBSizeInByte = scene.indices.size_bytes();
+    createGlbDeviceBuffer(_compositeIBSizeInByte,
+                          VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                          _compositeIB);
+    // same layout as a cold load: vertices, then indices, in one staging allocation
+    _stagingGeometry = _stagingRing.allocate(_compositeVBSizeInByte + _compositeIBSizeInByte);
+    memcpy(_stagingGeometry.memory.data(), scene.vertices.data(), _compositeVBSizeInByte);
+    memcpy(_stagingGeometry.memory.data() + _compositeVBSizeInByte, scene.indices.data(),
+           _compositeIBSizeInByte);
+    {
+        VkBufferCopy region{.srcOffset = _stagingGeometry.offset, .dstOffset = 0,
+                .size = _compositeVBSizeInByte};
+        vkCmdCopyBuffer(_uploadCmd, _stagingGeometry.buffer, _compositeVB, 1, &region);
+    }
+    {
+        VkBufferCopy region{.srcOffset = _stagingGeometry.offset + _compositeVBSizeInByte,
+                .dstOffset = 0, .size = _compositeIBSizeInByte};
+        vkCmdCopyBuffer(_uploadCmd, _stagingGeometry.buffer, _compositeIB, 1, &region);
+    }
+    transferBufferToGraphics(_compositeVB);
+    transferBufferToGraphics(_compositeIB);
+
+    // textures carry their whole mip chain: copy every level, no blit chain
+    for (const auto &texture: scene.textures) {
+        VkImage glbImage = createGlbImage(texture.width, texture.height, texture.mipLevels, 0);
+        const auto stagingImage = _stagingRing.stage(texture.texels.data(),
+                                                     texture.texels.size());
+
+        const VkImageSubresourceRange subresourceRange = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = texture.mipLevels,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+        };
+        const VkImageMemoryBarrier toTransferDstBarrier = {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                .srcAccessMask = VK_ACCESS_NONE,
+                .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = glbImage,
+                .subresourceRange = subresourceRange,
+        };
+        vkCmdPipelineBarrier(_uploadCmd, VK_PIPELINE_STAGE_HOST_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                             1, &toTransferDstBarrier);
+
+        // the chain is tightly packed: level i starts right after level i-1
+        std::vector<VkBufferImageCopy> bufferCopyRegions(texture.mipLevels);
+        VkDeviceSize bufferOffset = stagingImage.offset;
+        uint32_t w = texture.width;
+        uint32_t h = texture.height;
+        for (uint32_t level = 0; level < texture.mipLevels; ++level) {
+            bufferCopyRegions[level] = VkBufferImageCopy{
+                    .bufferOffset = bufferOffset,
+                    .imageSubresource = {
+                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                            .mipLevel = level,
+                            .baseArrayLayer = 0,
+                            .layerCount = 1,
+                    },
+                    .imageExtent = {w, h, 1},
             };
-            VK_CHECK(vmaCreateBuffer(_vmaAllocator, &bufferCreateInfo,
-                                     &stagingAllocationCreateInfo,
-                                     &_stagingIndirectDrawBuffer,
-                                     &vmaStagingIndirectDrawBufferAllocation, nullptr));
-            // copy IndirectDrawBuffer from host to device, region
-            void *mappedMemoryForIndirectDrawBuffer{nullptr};
-            VK_CHECK(vmaMapMemory(_vmaAllocator, vmaStagingIndirectDrawBufferAllocation,
-                                  &mappedMemoryForIndirectDrawBuffer));
-            memcpy(mappedMemoryForIndirectDrawBuffer, indirectDrawBufferPtr,
-                   indirectDrawBufferByteSize);
-            vmaUnmapMemory(_vmaAllocator, vmaStagingIndirectDrawBufferAllocation);
+            bufferOffset += VkDeviceSize(w) * h * 4;
+            w = w > 1 ? w >> 1 : w;
+            h = h > 1 ? h >> 1 : h;
         }
-        {
-            // cmd to copy from staging to device
-            VkBufferCopy region{.srcOffset = 0,
-                    .dstOffset = 0,
-                    .size = indirectDrawBufferByteSize};
-            vkCmdCopyBuffer(_uploadCmd, _stagingIndirectDrawBuffer, _indirectDrawB, 1, &region);
+        vkCmdCopyBufferToImage(_uploadCmd, stagingImage.buffer, glbImage,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(bufferCopyRegions.size()),
+                               bufferCopyRegions.data());
+
+        transferImageToGraphics(glbImage, subresourceRange, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+    createGlbSampler();
+
+    _compositeMatBSizeInByte = scene.materials.size_bytes();
+    createGlbDeviceBuffer(_compositeMatBSizeInByte, 0, _compositeMatB);
+    {
+        const auto staging = _stagingRing.stage(scene.materials.data(), _compositeMatBSizeInByte);
+        VkBufferCopy region{.srcOffset = staging.offset, .dstOffset = 0,
+                .size = _compositeMatBSizeInByte};
+        vkCmdCopyBuffer(_uploadCmd, staging.buffer, _compositeMatB, 1, &region);
+        transferBufferToGraphics(_compositeMatB);
+    }
+
+    _indirectDrawBSizeInByte = scene.indirectDraws.size_bytes();
+    createGlbDeviceBuffer(_indirectDrawBSizeInByte, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                          _indirectDrawB);
+    {
+        const auto staging = _stagingRing.stage(scene.indirectDraws.data(),
+                                                _indirectDrawBSizeInByte);
+        VkBufferCopy region{.srcOffset = staging.offset, .dstOffset = 0,
+                .size = _indirectDrawBSizeInByte};
+        vkCmdCopyBuffer(_uploadCmd, staging.buffer, _indirectDrawB, 1, &region);
+        transferBufferToGraphics(_indirectDrawB);
+    }
+
+    _instanceTransformBSizeInByte = scene.instanceTransforms.size_bytes();
+    createGlbDeviceBuffer(_instanceTransformBSizeInByte, 0, _instanceTransformB);
+    {
+        const auto staging = _stagingRing.stage(scene.instanceTransforms.data(),
+                                                _instanceTransformBSizeInByte);
+        VkBufferCopy region{.srcOffset = staging.offset, .dstOffset = 0,
+                .size = _instanceTransformBSizeInByte};
+        vkCmdCopyBuffer(_uploadCmd, staging.buffer, _instanceTransformB, 1, &region);
+        transferBufferToGraphics(_instanceTransformB);
+    }
+
+    uploadGlbMeshlets(scene.meshlets, scene.meshletVertices, scene.meshletTriangles);
+
+    _instanceTransforms.assign(scene.instanceTransforms.begin(), scene.instanceTransforms.end());
+    _indirectDrawParams.assign(scene.indirectDraws.begin(), scene.indirectDraws.end());
+    _drawLods.assign(scene.drawLods.begin(), scene.drawLods.end());
+}
+
+// meshlet buffers for gpu cluster culling, next to the composite vb/ib they index into
+void VkApplication::uploadGlbMeshlets(std::span<const Meshlet> meshlets,
+                                      std::span<const uint32_t> meshletVertices,
+                                      std::span<const uint8_t> meshletTriangles) {
+    if (meshlets.empty()) {
+        return;
+    }
+    auto upload = [&](const void *data, uint32_t size, VkBuffer &buffer) {
+        createGlbDeviceBuffer(size, 0, buffer);
+        const auto staging = _stagingRing.stage(data, size);
+        VkBufferCopy region{.srcOffset = staging.offset, .dstOffset = 0, .size = size};
+        vkCmdCopyBuffer(_uploadCmd, staging.buffer, buffer, 1, &region);
+        transferBufferToGraphics(buffer);
+    };
+    _meshletBSizeInByte = meshlets.size_bytes();
+    _meshletVertexBSizeInByte = meshletVertices.size_bytes();
+    _meshletTriangleBSizeInByte = meshletTriangles.size_bytes();
+    upload(meshlets.data(), _meshletBSizeInByte, _meshletB);
+    upload(meshletVertices.data(), _meshletVertexBSizeInByte, _meshletVertexB);
+    upload(meshletTriangles.data(), _meshletTriangleBSizeInByte, _meshletTriangleB);
+    LOGI("Uploaded %zu meshlets: %u + %u + %u bytes", meshlets.size(), _meshletBSizeInByte,
+         _meshletVertexBSizeInByte, _meshletTriangleBSizeInByte);
+}
+
+// the cpu rewrites frame i's copy only after frame i's fence, the gpu never reads a torn one
+void VkApplication::createLodIndirectDrawBuffers() {
+    const bool hasLods = std::any_of(_drawLods.begin(), _drawLods.end(),
+                                     [](const DrawLods &lods) { return lods.lodCount > 1; });
+    if (!hasLods || _drawLods.size() != _indirectDrawParams.size()) {
+        return;
+    }
+    const VkDeviceSize size = sizeof(IndirectDrawForVulkan) * _indirectDrawParams.size();
+    _lodIndirectDrawBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    _lodIndirectDrawAllocations.resize(MAX_FRAMES_IN_FLIGHT);
+    _lodIndirectDrawAllocationInfos.resize(MAX_FRAMES_IN_FLIGHT);
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+        createPersistentBuffer(size, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                               "Lod indirect draws " + std::to_string(i),
+                               _lodIndirectDrawBuffers[i],
+                               _lodIndirectDrawAllocations[i],
+                               _lodIndirectDrawAllocationInfos[i]);
+    }
+}
+
+// coarsest level whose error projects under LOD_PIXEL_ERROR at the nearest instance
+void VkApplication::selectGlbLods(int currentFrameId) {
+    if (_lodIndirectDrawBuffers.empty()) {
+        return;
+    }
+    const auto viewPos = _camera.viewPos();
+    const float camera[3] = {viewPos[COMPONENT::X], viewPos[COMPONENT::Y],
+                             viewPos[COMPONENT::Z]};
+    // pixels covered by one object-space unit at distance 1
+    const float pixelsPerUnit =
+            float(_swapChainExtent.height) / (2.0f * std::tan(CAMERA_VFOV * 0.5f));
+
+    void *mappedMemory{nullptr};
+    VK_CHECK(vmaMapMemory(_vmaAllocator, _lodIndirectDrawAllocations[currentFrameId],
+                          &mappedMemory));
+    auto *draws = static_cast<IndirectDrawForVulkan *>(mappedMemory);
+    size_t drawnTriangles = 0;
+    size_t fullTriangles = 0;
+    for (size_t d = 0; d < _indirectDrawParams.size(); ++d) {
+        IndirectDrawForVulkan draw = _indirectDrawParams[d];
+        const auto &lods = _drawLods[d];
+        const uint32_t lodCount = std::min(lods.lodCount, MAX_MESH_LODS);
+        // bounding sphere of the primitive, mesh space
+        float center[3];
+        float radius2 = 0.0f;
+        for (int c = 0; c < 3; ++c) {
+            center[c] = (draw.boundsMin[c] + draw.boundsMax[c]) * 0.5f;
+            const float half = (draw.boundsMax[c] - draw.boundsMin[c]) * 0.5f;
+            radius2 += half * half;
         }
+        const float radius = std::sqrt(radius2);
+        // instances share the draw: the one covering the most pixels per unit decides
+        float maxScaleOverDistance = 0.0f;
+        const size_t lastInstance = std::min<size_t>(size_t(draw.firstInstance) +
+                                                     draw.instanceCount,
+                                                     _instanceTransforms.size());
+        for (size_t i = draw.firstInstance; i < lastInstance; ++i) {
+            // row vectors: world = p * m
+            const auto &m = _instanceTransforms[i].data;
+            float distance2 = 0.0f;
+            float scale2 = 0.0f;
+            for (int c = 0; c < 3; ++c) {
+                const float world = center[0] * m[0][c] + center[1] * m[1][c] +
+                                    center[2] * m[2][c] + m[3][c];
+                distance2 += (world - camera[c]) * (world - camera[c]);
+                scale2 = std::max(scale2, m[c][0] * m[c][0] + m[c][1] * m[c][1] +
+                                          m[c][2] * m[c][2]);
+            }
+            const float scale = std::sqrt(scale2);
+            const float distance = std::max(std::sqrt(distance2) - radius * scale, 0.0001f);
+            maxScaleOverDistance = std::max(maxScaleOverDistance, scale / distance);
+        }
+        uint32_t level = 0;
+        while (level + 1 < lodCount &&
+               lods.lods[level + 1].error * maxScaleOverDistance * pixelsPerUnit <=
+               LOD_PIXEL_ERROR) {
+            ++level;
+        }
+        if (lodCount > 0) {
+            draw.firstIndex = lods.lods[level].firstIndex;
+            draw.indexCount = lods.lods[level].indexCount;
+        }
+        draws[d] = draw;
+        drawnTriangles += size_t(draw.indexCount / 3) * draw.instanceCount;
+        fullTriangles += size_t(_indirectDrawParams[d].indexCount / 3) * draw.instanceCount;
     }
+    vmaUnmapMemory(_vmaAllocator, _lodIndirectDrawAllocations[currentFrameId]);
 
-}
\ No newline at end of file
+    if (_lodFrameCount++ % 300 == 0) {
+        LOGI("LOD: drawing %zu of %zu triangles (%.1f%%)", drawnTriangles, fullTriangles,
+             fullTriangles ? 100.0 * double(drawnTriangles) / double(fullTriangles) : 0.0);
+    }
+}
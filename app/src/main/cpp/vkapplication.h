@@ -17,7 +17,11 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <numeric>
 
 // #define VK_NO_PROTOTYPES // for volk
@@ -41,6 +45,8 @@
 #include <misc.h>
 #include <camera.h>
 #include <glb.h>
+#include <scenecache.h>
+#include <stagingring.h>
 
 // functor for custom deleter for unique_ptr
 struct AndroidNativeWindowDeleter {
@@ -51,7 +57,9 @@ class VkApplication {
 public:
     void initVulkan();
 
-    void reset(ANativeWindow *newWindow, AAssetManager *newManager);
+    // cacheDirectory: app-private writable dir for cooked assets, empty disables the cache
+    void reset(ANativeWindow *newWindow, AAssetManager *newManager,
+               const std::string &cacheDirectory = {});
 
     void teardown();
 
@@ -170,7 +178,42 @@ private:
 
     // io reader
     void loadGLB();
+    void uploadCookedScene(const CookedScene &scene);
+    // runs the cook loadGLB prepared on _sceneCookThread, call once the uploads are submitted
+    void startSceneCook();
+    void uploadGlbMeshlets(std::span<const Meshlet> meshlets,
+                           std::span<const uint32_t> meshletVertices,
+                           std::span<const uint8_t> meshletTriangles);
+    // device-local buffer, kept in _glbDeviceBuffers until teardown
+    void createGlbDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer &buffer);
+    VkImage createGlbImage(uint32_t width, uint32_t height, uint32_t mipLevels,
+                           VkImageUsageFlags mipGenerationUsage);
+    // level 0 uploaded, every level in TRANSFER_DST
+    struct MipChain {
+        VkImage image;
+        int32_t width;
+        int32_t height;
+        uint32_t levelCount;
+        // texels are sRGB encoded
+        bool srgb;
+        // downsampled by mipdownsample.comp (STORAGE usage), blitted otherwise (TRANSFER_SRC)
+        bool compute;
+    };
+    void generateMipChains(std::span<const MipChain> mipChains, VkFormat format);
+    void downsampleMipChains(std::span<const MipChain> mipChains);
+    void blitMipChains(std::span<const MipChain> mipChains, VkFormat format);
+    void createMipDownsamplePipeline();
+    void createGlbSampler();
     void postHostDeviceIO();
+    void reclaimUploads(uint64_t completedValue);
+    // queue family ownership of what _uploadCmd wrote goes to the graphics family
+    void transferBufferToGraphics(VkBuffer buffer);
+    void transferImageToGraphics(VkImage image, const VkImageSubresourceRange &subresourceRange,
+                                 VkImageLayout oldLayout, VkImageLayout newLayout,
+                                 VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+    // per-frame copies of the indirect draws, patched with the selected lod every frame
+    void createLodIndirectDrawBuffers();
+    void selectGlbLods(int currentFrameId);
 
     bool _initialized{false};
     bool _enableValidationLayers{true};
@@ -202,6 +245,8 @@ private:
     // android specific
     std::unique_ptr <ANativeWindow, AndroidNativeWindowDeleter> _osWindow;
     AAssetManager *_assetManager;
+    // cooked scene cache lives here (internalDataPath)
+    std::string _cacheDirectory;
 
     VkInstance _instance{VK_NULL_HANDLE};
     VkSurfaceKHR _surface{VK_NULL_HANDLE};
@@ -279,6 +324,7 @@ private:
 
     VkDevice _logicalDevice{VK_NULL_HANDLE};
     bool _bindlessSupported{false};
+    bool _computeSubgroupQuad{false};
     bool _protectedMemory{false};
 
     uint32_t _graphicsComputeQueueFamilyIndex{std::numeric_limits<uint32_t>::max()};
@@ -339,6 +385,10 @@ private:
     VkDescriptorSetLayout _descriptorSetLayoutForTextures;
     // for glb samplers
     VkDescriptorSetLayout _descriptorSetLayoutForSamplers;
+    // for glb materials
+    VkDescriptorSetLayout _descriptorSetLayoutForMaterials;
+    // for glb per-instance transforms
+    VkDescriptorSetLayout _descriptorSetLayoutForInstanceTransforms;
 
     VkDescriptorPool _descriptorSetPool{VK_NULL_HANDLE};
     // why vector ? triple-buffer
@@ -352,6 +402,10 @@ private:
     VkDescriptorSet _descriptorSetsForTexture;
     // for glb samplers
     VkDescriptorSet _descriptorSetsForSampler;
+    // for glb materials
+    VkDescriptorSet _descriptorSetsForMaterials;
+    // for glb per-instance transforms
+    VkDescriptorSet _descriptorSetsForInstanceTransforms;
     // for bind resource to descriptor sets
     std::vector<VkWriteDescriptorSet> _writeDescriptorSetBundle;
 
@@ -365,6 +419,10 @@ private:
     // for multiple sets + bindings
     VkPipelineLayout _pipelineLayout;
     VkPipeline _graphicsPipeline;
+    // glb mip chains
+    VkDescriptorSetLayout _mipDownsampleSetLayout{VK_NULL_HANDLE};
+    VkPipelineLayout _mipDownsamplePipelineLayout{VK_NULL_HANDLE};
+    VkPipeline _mipDownsamplePipeline{VK_NULL_HANDLE};
 
     // cmd
     VkCommandPool _commandPool;
@@ -381,45 +439,93 @@ private:
     // vao, vbo, index buffer
     uint32_t _indexCount{0};
     // for vkCmdBindVertexBuffers and vkCmdBindIndexBuffer
-    VkBuffer _deviceVb, _deviceIb;
+    VkBuffer _deviceVb{VK_NULL_HANDLE}, _deviceIb{VK_NULL_HANDLE};
+    VmaAllocation _deviceVbAllocation{VK_NULL_HANDLE}, _deviceIbAllocation{VK_NULL_HANDLE};
     // need to destroy staging buffer when io is completed
-    VkBuffer _stagingVb, _stagingIb;
 
-    // host-device io (during initialization)
-    VkCommandBuffer _uploadCmd;
-    VkFence _ioFence;
+    // host-device io
+    // copies on the transfer family, ownership acquire and mip blits on the graphics family
+    VkCommandPool _transferCommandPool{VK_NULL_HANDLE};
+    VkCommandBuffer _uploadCmd{VK_NULL_HANDLE};
+    VkCommandBuffer _uploadGraphicsCmd{VK_NULL_HANDLE};
+    // submitted uploads signal it, nothing on the host waits for it
+    VkSemaphore _uploadTimeline{VK_NULL_HANDLE};
+    uint64_t _uploadTimelineValue{0};
+    // objects the upload command buffers use, destroyed once the upload completed
+    struct UploadScratch {
+        std::vector<VkImageView> imageViews;
+        VkDescriptorPool descriptorPool{VK_NULL_HANDLE};
+        VkBuffer buffer{VK_NULL_HANDLE};
+        VmaAllocation allocation{VK_NULL_HANDLE};
+        // timestamps around the mip generation
+        VkQueryPool queryPool{VK_NULL_HANDLE};
+        uint32_t mipChainCount{0};
+        bool computeMipChains{false};
+    };
+    UploadScratch _uploadScratch;
+    struct PendingUpload {
+        uint64_t completedValue;
+        VkCommandBuffer transferCmd;
+        VkCommandBuffer graphicsCmd;
+        UploadScratch scratch;
+        std::chrono::steady_clock::time_point submitTime;
+    };
+    std::deque<PendingUpload> _pendingUploads;
+    // staging memory of every upload, reclaimed per completed timeline value
+    StagingRing _stagingRing;
 
     // texture
     VkImageView _imageView{VK_NULL_HANDLE};
     VkImage _image{VK_NULL_HANDLE};
     VkSampler _sampler{VK_NULL_HANDLE};
-    VmaAllocation _vmaImageAllocation{VK_NULL_HANDLE};
-    VkBuffer _stagingImageBuffer;
+    // the ktx image and its vma allocation, released through _ktxUploadCallbacks.destroyImage
+    ktxVulkanTexture _vkTexture{};
+    ktxVulkanUploadCallbacks _ktxUploadCallbacks{};
 
     // glb scene
-    // a lot of stageBuffers
-    vector<VkBuffer> _stagingVbForMesh;
-    vector<VkBuffer> _stagingIbForMesh;
-    VkBuffer _stagingMatBuffer;
-    VkBuffer _stagingIndirectDrawBuffer;
+    // composite vertices then indices, written in place by the reader
+    StagingRing::Allocation _stagingGeometry;
     // device buffer
     VkBuffer _compositeVB{VK_NULL_HANDLE};
     VkBuffer _compositeIB{VK_NULL_HANDLE};
     VkBuffer _compositeMatB{VK_NULL_HANDLE};
     VkBuffer _indirectDrawB{VK_NULL_HANDLE};
+    VkBuffer _instanceTransformB{VK_NULL_HANDLE};
+    // meshlet descriptors / vertex remap / u8 local triangles, left null without meshlets
+    VkBuffer _meshletB{VK_NULL_HANDLE};
+    VkBuffer _meshletVertexB{VK_NULL_HANDLE};
+    VkBuffer _meshletTriangleB{VK_NULL_HANDLE};
+    // every buffer createGlbDeviceBuffer made (the ones above), with its allocation
+    std::vector<std::pair<VkBuffer, VmaAllocation>> _glbDeviceBuffers;
     // each buffer's size is needed when bindResourceToDescriptorSet
     uint32_t _compositeVBSizeInByte;
     uint32_t _compositeIBSizeInByte;
     uint32_t _compositeMatBSizeInByte;
     uint32_t _indirectDrawBSizeInByte;
-    // number of meshes in the scene
+    uint32_t _instanceTransformBSizeInByte;
+    uint32_t _meshletBSizeInByte{0};
+    uint32_t _meshletVertexBSizeInByte{0};
+    uint32_t _meshletTriangleBSizeInByte{0};
+    // number of draw records in the scene, one per mesh primitive
     uint32_t _numMeshes;
+    // host copies for lod selection: level 0 draws, their lod chains and the instances to
+    // measure the distance to
+    std::vector<IndirectDrawForVulkan> _indirectDrawParams;
+    std::vector<DrawLods> _drawLods;
+    // cold start: refines the scene and writes the cache for the next launch, off the load path
+    std::function<void()> _sceneCook;
+    std::thread _sceneCookThread;
+    std::vector<mat4x4f> _instanceTransforms;
+    // host-visible, one per frame in flight, empty when no draw has more than one level
+    std::vector<VkBuffer> _lodIndirectDrawBuffers;
+    std::vector<VmaAllocation> _lodIndirectDrawAllocations;
+    std::vector<VmaAllocationInfo> _lodIndirectDrawAllocationInfos;
+    uint64_t _lodFrameCount{0};
 
     // textures in the glb scene
     std::vector<VkImage> _glbImages;
     std::vector<VkImageView> _glbImageViews;
     std::vector<VmaAllocation> _glbImageAllocation;
-    std::vector<VkBuffer> _glbImageStagingBuffer;
 
     // samplers in the glb scene
     std::vector<VkSampler> _glbSamplers;
@@ -19,6 +19,9 @@ struct IndirectDrawDef1 {
     uint firstInstance;
     uint meshId;
     int materialIndex;
+    // primitive AABB, QuantizedVertex positions are unorm16 within it
+    float boundsMin[3];
+    float boundsMax[3];
 };
 
 // 32 bit alignment
@@ -40,9 +43,22 @@ layout (set = 0, binding = 0) uniform UBO
         float lodBias;
         } ubo;
 
+#ifdef QUANTIZED_VERTICES
+// QuantizedVertex (infra/scene.h), read as dwords
+struct QuantizedVertex {
+    uint posXY;      // unorm16 x | unorm16 y
+    uint posZNormal; // unorm16 z | octahedral snorm8 x, y
+    uint uv;         // half2
+};
+
+layout(set = 3, binding = 0) readonly buffer VertexBuffer {
+QuantizedVertex vertices[];
+};
+#else
 layout(set = 3, binding = 0) readonly buffer VertexBuffer {
 Vertex vertices[];
 };
+#endif
 
 layout(set = 2, binding = 0) readonly buffer IndirectDrawBuffer {
 IndirectDrawDef1 indirectDraws[];
@@ -52,6 +68,11 @@ layout(set = 6, binding = 0) readonly buffer MaterialBuffer {
 Material materials[];
 };
 
+// mesh-space -> world, one per mesh node: instances of a draw start at its firstInstance
+layout(set = 7, binding = 0) readonly buffer InstanceBuffer {
+mat4 instanceTransforms[];
+};
+
 layout(set = 4, binding = 0) uniform texture2D BindlessImage2D[];
 layout(set = 5, binding = 0) uniform sampler BindlessSampler[];
 
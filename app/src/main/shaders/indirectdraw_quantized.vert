@@ -0,0 +1,42 @@
+#version 460 // gl_BaseVertex and gl_DrawID
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_GOOGLE_include_directive : require
+
+// same as indirectdraw_test.vert, over QuantizedVertex
+#define QUANTIZED_VERTICES
+#include "common.glsl"
+
+// output from vs to fs
+// flat: no interpolation
+layout(location = 0) out vec2 outTexCoord;
+layout(location = 1) out flat uint outMeshId;
+layout(location = 2) out flat int outMaterialId;
+layout(location = 3) out vec3 outNormal;
+
+vec3 decodeOctahedral(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+void main() {
+  QuantizedVertex vertex = vertices[gl_VertexIndex];
+  IndirectDrawDef1 draw = indirectDraws[gl_DrawID];
+
+  vec3 boundsMin = vec3(draw.boundsMin[0], draw.boundsMin[1], draw.boundsMin[2]);
+  vec3 boundsMax = vec3(draw.boundsMax[0], draw.boundsMax[1], draw.boundsMax[2]);
+  vec3 t = vec3(unpackUnorm2x16(vertex.posXY), unpackUnorm2x16(vertex.posZNormal).x);
+  vec3 pos = mix(boundsMin, boundsMax, t);
+
+  outTexCoord = unpackHalf2x16(vertex.uv);
+  // gl_DrawID: for multi-draw commands
+  outMeshId = draw.meshId;
+  // material is per draw, not per vertex
+  outMaterialId = draw.materialIndex;
+  outNormal = decodeOctahedral(unpackSnorm4x8(vertex.posZNormal).zw);
+
+  // gl_InstanceIndex already includes the draw's firstInstance
+  gl_Position = ubo.mvp * instanceTransforms[gl_InstanceIndex] * vec4(pos, 1.0f);
+}
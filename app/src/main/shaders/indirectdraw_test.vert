@@ -22,5 +22,7 @@ void main() {
   outMeshId = indirectDraws[gl_DrawID].meshId;
   outMaterialId = vertex.materialId;
 
-  gl_Position = ubo.mvp * vec4(vertex.posX, vertex.posY, vertex.posZ, 1.0f);
+  // gl_InstanceIndex already includes the draw's firstInstance
+  gl_Position = ubo.mvp * instanceTransforms[gl_InstanceIndex] *
+                vec4(vertex.posX, vertex.posY, vertex.posZ, 1.0f);
 }
\ No newline at end of file
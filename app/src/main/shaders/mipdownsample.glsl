@@ -0,0 +1,187 @@
+#ifndef MIP_DOWNSAMPLE_GLSL
+#define MIP_DOWNSAMPLE_GLSL
+
+// single-pass mip chain generation, one dispatch per image:
+// every workgroup reduces a 64x64 tile of level 0 into levels 1..6 without leaving the
+// workgroup, the last workgroup to finish reduces level 6 (at most 64x64) into levels 7..12
+// level 0 is at most 4096x4096, every level is in GENERAL
+
+#define MAX_MIP_LEVELS 13
+
+layout(local_size_x = 256) in;
+
+// one storage view per level, unused tail entries repeat the last level
+layout(set = 0, binding = 0, rgba8) uniform coherent image2D mips[MAX_MIP_LEVELS];
+// zeroed before the dispatches: workgroups of image counterIndex done with levels 1..6
+layout(set = 0, binding = 1) buffer Counters {
+    uint workgroupsDone[];
+};
+
+layout(push_constant) uniform Params {
+    ivec2 size;
+    uint levelCount;
+    // rgb holds sRGB encoded values (base color): filter in linear space
+    uint srgb;
+    uint counterIndex;
+} params;
+
+shared vec4 reduced[8][8];
+shared uint lastWorkgroup;
+#ifndef MIP_DOWNSAMPLE_SUBGROUP_QUAD
+shared vec4 reduced16[16][16];
+#endif
+
+// constant indices only: dynamic indexing of storage image arrays is an optional feature
+#define LOAD_LEVEL(i) case i: return imageLoad(mips[i], p);
+#define STORE_LEVEL(i) case i: imageStore(mips[i], p, value); break;
+
+vec4 loadLevel(uint level, ivec2 p) {
+    switch (level) {
+        LOAD_LEVEL(0) LOAD_LEVEL(1) LOAD_LEVEL(2) LOAD_LEVEL(3) LOAD_LEVEL(4)
+        LOAD_LEVEL(5) LOAD_LEVEL(6) LOAD_LEVEL(7) LOAD_LEVEL(8) LOAD_LEVEL(9)
+        LOAD_LEVEL(10) LOAD_LEVEL(11) LOAD_LEVEL(12)
+    }
+    return vec4(0.0);
+}
+
+void storeLevel(uint level, ivec2 p, vec4 value) {
+    switch (level) {
+        STORE_LEVEL(0) STORE_LEVEL(1) STORE_LEVEL(2) STORE_LEVEL(3) STORE_LEVEL(4)
+        STORE_LEVEL(5) STORE_LEVEL(6) STORE_LEVEL(7) STORE_LEVEL(8) STORE_LEVEL(9)
+        STORE_LEVEL(10) STORE_LEVEL(11) STORE_LEVEL(12)
+    }
+}
+
+ivec2 levelSize(uint level) {
+    return max(params.size >> int(level), ivec2(1));
+}
+
+vec4 toLinear(vec4 c) {
+    if (params.srgb == 0u) {
+        return c;
+    }
+    vec3 rgb = mix(pow((c.rgb + 0.055) / 1.055, vec3(2.4)), c.rgb / 12.92,
+                   lessThanEqual(c.rgb, vec3(0.04045)));
+    return vec4(rgb, c.a);
+}
+
+vec4 toEncoded(vec4 c) {
+    if (params.srgb == 0u) {
+        return c;
+    }
+    vec3 rgb = mix(1.055 * pow(c.rgb, vec3(1.0 / 2.4)) - 0.055, c.rgb * 12.92,
+                   lessThanEqual(c.rgb, vec3(0.0031308)));
+    return vec4(rgb, c.a);
+}
+
+// 2x2 box of level base under texel p of level base + 1, edges clamped
+vec4 reduceLevel(uint base, ivec2 p) {
+    ivec2 last = levelSize(base) - 1;
+    ivec2 s = p * 2;
+    return 0.25 * (toLinear(loadLevel(base, min(s, last))) +
+                   toLinear(loadLevel(base, min(s + ivec2(1, 0), last))) +
+                   toLinear(loadLevel(base, min(s + ivec2(0, 1), last))) +
+                   toLinear(loadLevel(base, min(s + ivec2(1, 1), last))));
+}
+
+void writeLevel(uint level, ivec2 p, vec4 value) {
+    if (all(lessThan(p, levelSize(level)))) {
+        storeLevel(level, p, toEncoded(value));
+    }
+}
+
+// levels base + 1 .. base + 6 of the 64x64 tile of level base, values stay linear in between
+// every early return depends on uniforms only: barriers stay in uniform control flow
+void downsampleTile(uint base, uvec2 tile) {
+    uint lastLevel = min(base + 6u, params.levelCount - 1u);
+    if (base + 1u > lastLevel) {
+        return;
+    }
+    // 16x16 invocations, every 4 consecutive ones cover a 2x2 block
+    uint l = gl_LocalInvocationIndex;
+    uvec2 xy = uvec2(bitfieldInsert(bitfieldExtract(l, 2, 3), l, 0, 1),
+                     bitfieldInsert(bitfieldExtract(l, 3, 3), bitfieldExtract(l, 1, 2), 0, 2));
+    xy += uvec2(8u * ((l >> 6u) & 1u), 8u * (l >> 7u));
+
+    // base + 1: 2x2 texels per invocation, 32x32 per workgroup
+    ivec2 p = ivec2(tile * 32u + xy * 2u);
+    vec4 v00 = reduceLevel(base, p);
+    vec4 v10 = reduceLevel(base, p + ivec2(1, 0));
+    vec4 v01 = reduceLevel(base, p + ivec2(0, 1));
+    vec4 v11 = reduceLevel(base, p + ivec2(1, 1));
+    writeLevel(base + 1u, p, v00);
+    writeLevel(base + 1u, p + ivec2(1, 0), v10);
+    writeLevel(base + 1u, p + ivec2(0, 1), v01);
+    writeLevel(base + 1u, p + ivec2(1, 1), v11);
+    if (base + 2u > lastLevel) {
+        return;
+    }
+
+    // base + 2: one texel per invocation, 16x16
+    vec4 v = 0.25 * (v00 + v10 + v01 + v11);
+    writeLevel(base + 2u, ivec2(tile * 16u + xy), v);
+    if (base + 3u > lastLevel) {
+        return;
+    }
+
+    // base + 3: 8x8, out of the 2x2 blocks
+#ifdef MIP_DOWNSAMPLE_SUBGROUP_QUAD
+    // a quad is 4 consecutive invocations, i.e. one 2x2 block
+    v += subgroupQuadSwapHorizontal(v);
+    v = 0.25 * (v + subgroupQuadSwapVertical(v));
+    if ((l & 3u) == 0u) {
+        reduced[xy.y >> 1u][xy.x >> 1u] = v;
+        writeLevel(base + 3u, ivec2(tile * 8u + (xy >> 1u)), v);
+    }
+#else
+    reduced16[xy.y][xy.x] = v;
+    barrier();
+    if (l < 64u) {
+        uvec2 q = uvec2(l & 7u, l >> 3u);
+        v = 0.25 * (reduced16[2u * q.y][2u * q.x] + reduced16[2u * q.y][2u * q.x + 1u] +
+                    reduced16[2u * q.y + 1u][2u * q.x] + reduced16[2u * q.y + 1u][2u * q.x + 1u]);
+        reduced[q.y][q.x] = v;
+        writeLevel(base + 3u, ivec2(tile * 8u + q), v);
+    }
+#endif
+    barrier();
+
+    // base + 4 .. base + 6: 4x4, 2x2, 1x1 through shared memory
+    uint size = 4u;
+    for (uint level = base + 4u; level <= lastLevel; ++level, size >>= 1u) {
+        uvec2 q = uvec2(l % size, l / size);
+        if (l < size * size) {
+            v = 0.25 * (reduced[2u * q.y][2u * q.x] + reduced[2u * q.y][2u * q.x + 1u] +
+                        reduced[2u * q.y + 1u][2u * q.x] + reduced[2u * q.y + 1u][2u * q.x + 1u]);
+            writeLevel(level, ivec2(tile * size + q), v);
+        }
+        barrier();
+        if (l < size * size) {
+            reduced[q.y][q.x] = v;
+        }
+        barrier();
+    }
+}
+
+void main() {
+    downsampleTile(0u, gl_WorkGroupID.xy);
+    if (params.levelCount <= 7u) {
+        return;
+    }
+    // level 6 of every tile is written: the last workgroup to get here carries on alone
+    memoryBarrierImage();
+    barrier();
+    if (gl_LocalInvocationIndex == 0u) {
+        uint workgroups = gl_NumWorkGroups.x * gl_NumWorkGroups.y;
+        lastWorkgroup = atomicAdd(workgroupsDone[params.counterIndex], 1u) == workgroups - 1u
+                        ? 1u : 0u;
+    }
+    barrier();
+    if (lastWorkgroup == 0u) {
+        return;
+    }
+    memoryBarrierImage();
+    downsampleTile(6u, uvec2(0u));
+}
+
+#endif
@@ -336,6 +336,26 @@ KTX_error_code
 ktxTexture_CreateFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
                             ktxTextureCreateFlags createFlags,
                             ktxTexture** newTex);
+
+/*
+ * Creates a ktxTexture reading from a read-only memory mapping of a named
+ * file containing KTX data.
+ */
+KTX_error_code
+ktxTexture_CreateFromMappedFile(const char* const filename,
+                                ktxTextureCreateFlags createFlags,
+                                ktxTexture** newTex);
+
+#if defined(__ANDROID__)
+typedef struct AAsset AAsset;
+/*
+ * Creates a ktxTexture reading from the buffer of an Android asset containing
+ * KTX data. Takes ownership of the asset.
+ */
+KTX_error_code
+ktxTexture_CreateFromAsset(AAsset* asset, ktxTextureCreateFlags createFlags,
+                           ktxTexture** newTex);
+#endif
 /*
  * Destroys a ktxTexture object.
  */
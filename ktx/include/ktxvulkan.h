@@ -89,11 +89,49 @@ typedef struct ktxVulkanTexture
     uint32_t depth; /*!< The depth of the image. */
     uint32_t levelCount; /*!< The number of MIP levels in the image. */
     uint32_t layerCount; /*!< The number of array layers in the image. */
+    void* allocation; /*!< The allocation returned by
+                           ktxVulkanUploadCallbacks::createImage when the
+                           image was created by
+                           ktxTexture_VkUploadToCommandBuffer(), NULL
+                           otherwise. */
 } ktxVulkanTexture;
 
+/**
+ * @class ktxVulkanUploadCallbacks
+ * @brief Struct for passing the application's allocator to
+ *        ktxTexture_VkUploadToCommandBuffer().
+ *
+ * Lets the application provide the staging and image memory, e.g.
+ * sub-allocated by its own memory allocator, instead of the loader calling
+ * @c vkAllocateMemory for each texture.
+ */
+typedef struct ktxVulkanUploadCallbacks {
+    void* pUserData; /*!< Passed unchanged to every callback. */
+    /** Provide @p size bytes of host-visible, mapped and coherent memory in a
+     *  buffer created with @c VK_BUFFER_USAGE_TRANSFER_SRC_BIT. @p *pOffset
+     *  need not be aligned, @p *ppMapped points to the byte at @p *pOffset.
+     *  The memory must stay valid until the command buffer the upload was
+     *  recorded into completes.
+     */
+    VkResult (*allocateStaging)(void* pUserData, VkDeviceSize size,
+                                VkBuffer* pBuffer, VkDeviceSize* pOffset,
+                                void** ppMapped);
+    /** Create an image from @p pCreateInfo and bind device-local memory to
+     *  it. @p *pAllocation is stored in ktxVulkanTexture::allocation.
+     */
+    VkResult (*createImage)(void* pUserData,
+                            const VkImageCreateInfo* pCreateInfo,
+                            VkImage* pImage, void** pAllocation);
+    /** Destroy an image created by @c createImage and free its memory. */
+    void (*destroyImage)(void* pUserData, VkImage image, void* allocation);
+} ktxVulkanUploadCallbacks;
+
 void
 ktxVulkanTexture_Destruct(ktxVulkanTexture* This, VkDevice device,
                           const VkAllocationCallbacks* pAllocator);
+void
+ktxVulkanTexture_DestructWithCallbacks(ktxVulkanTexture* This,
+                                      const ktxVulkanUploadCallbacks* callbacks);
 
 /**
  * @class ktxVulkanDeviceInfo
@@ -160,6 +198,15 @@ KTX_error_code
 ktxTexture_VkUpload(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
                     ktxVulkanTexture *vkTexture);
 
+KTX_error_code
+ktxTexture_VkUploadToCommandBuffer(ktxTexture* This,
+                                   VkPhysicalDevice physicalDevice,
+                                   VkCommandBuffer cmdBuffer,
+                                   const ktxVulkanUploadCallbacks* callbacks,
+                                   ktxVulkanTexture* vkTexture,
+                                   VkImageUsageFlags usageFlags,
+                                   VkImageLayout finalLayout);
+
 VkFormat
 ktxTexture_GetVkFormat(ktxTexture* This);
 
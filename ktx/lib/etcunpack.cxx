@@ -30,12 +30,31 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define ETC_UNPACK_SSE2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+  #include <arm_neon.h>
+  #define ETC_UNPACK_NEON 1
+#endif
 
-#include "GL/glcorearb.h"
-// Not defined in glcorearb.h.
-#define GL_ETC1_RGB8_OES                0x8D64
 #include "ktx.h"
 #include "ktxint.h"
+// The Vulkan build has no GL headers. gl_format.h has every enum used here
+// and ktx.h the GL types, but for GLshort and the booleans.
+#include "gl_format.h"
+#if !defined(GL_NO_ERROR)
+typedef short GLshort;
+#define GL_FALSE                        0
+#define GL_TRUE                         1
+#endif
 
 #if SUPPORT_SOFTWARE_ETC_UNPACK
 typedef unsigned int uint;
@@ -55,12 +74,189 @@ extern void setupAlphaTable();
 // This global variable affects the behaviour of decompressBlockAlpha16bitC.
 extern int formatSigned;
 
+// AF_11BIT is used to compress R11 & RG11 though its not alpha data.
+enum AlphaFormat {AF_NONE, AF_1BIT, AF_8BIT, AF_11BIT};
+
+// Below this many rows of blocks per thread, starting the thread costs
+// more than it saves.
+#define MIN_BLOCK_ROWS_PER_THREAD 16
+
+// Everything the block row decoders need, shared read-only by all threads.
+struct UnpackInfo {
+	const GLubyte* src;
+	GLubyte* dst;
+	GLenum srcFormat;
+	AlphaFormat alphaFormat;
+	unsigned int width;
+	unsigned int height;
+	int dstChannels;
+	int dstChannelBytes;
+	unsigned int blockBytes;
+};
+
+// Intensity modifiers of the 8 ETC1 tables, in the order the 2-bit pixel
+// index (msb << 1 | lsb) selects them: etcdec.cxx's compressParams after
+// unscramble.
+static const short modifierTable[8][4] = {
+	{  2,   8,   -2,   -8},
+	{  5,  17,   -5,  -17},
+	{  9,  29,   -9,  -29},
+	{ 13,  42,  -13,  -42},
+	{ 18,  60,  -18,  -60},
+	{ 24,  80,  -24,  -80},
+	{ 33, 106,  -33, -106},
+	{ 47, 183,  -47, -183},
+};
+
 static void
 readBigEndian4byteWord(ktx_uint32_t* pBlock, const GLubyte *s)
 {
 	*pBlock = (s[0] << 24) | (s[1] << 16) | (s[2] << 8) | s[3];
 }
 
+/*
+ * Compute the 4 colors each half of an individual or differential mode block
+ * can take, as RGBX, in pixel index order. X is garbage.
+ */
+static void
+buildPalettes(const int baseColor[2][3], const int table[2], GLubyte palette[2][16])
+{
+	for (int half = 0; half < 2; half++) {
+		const int* base = baseColor[half];
+		const short* modifiers = modifierTable[table[half]];
+#if ETC_UNPACK_SSE2
+		__m128i b = _mm_setr_epi16(base[0], base[1], base[2], 0,
+								   base[0], base[1], base[2], 0);
+		__m128i m = _mm_loadl_epi64((const __m128i*)modifiers);
+		m = _mm_unpacklo_epi16(m, m);
+		__m128i m01 = _mm_unpacklo_epi32(m, m);
+		__m128i m23 = _mm_unpackhi_epi32(m, m);
+		_mm_storeu_si128((__m128i*)palette[half],
+						 _mm_packus_epi16(_mm_add_epi16(b, m01),
+										  _mm_add_epi16(b, m23)));
+#elif ETC_UNPACK_NEON
+		const int16_t lanes[4] = {(int16_t)base[0], (int16_t)base[1], (int16_t)base[2], 0};
+		int16x4_t b4 = vld1_s16(lanes);
+		int16x8_t b = vcombine_s16(b4, b4);
+		int16x4_t m = vld1_s16(modifiers);
+		int16x8_t m01 = vcombine_s16(vdup_lane_s16(m, 0), vdup_lane_s16(m, 1));
+		int16x8_t m23 = vcombine_s16(vdup_lane_s16(m, 2), vdup_lane_s16(m, 3));
+		vst1q_u8(palette[half], vcombine_u8(vqmovun_s16(vaddq_s16(b, m01)),
+											vqmovun_s16(vaddq_s16(b, m23))));
+#else
+		for (int i = 0; i < 4; i++) {
+			for (int c = 0; c < 3; c++) {
+				int v = base[c] + modifiers[i];
+				palette[half][4*i + c] = (GLubyte)(v < 0 ? 0 : (v > 255 ? 255 : v));
+			}
+		}
+#endif
+	}
+}
+
+/*
+ * Decode the RGB of an ETC1 / ETC2 color block. Same result as
+ * decompressBlockETC2c, which handles the T, H and planar modes, but
+ * individual and differential mode blocks are decoded through a per half
+ * block palette instead of clamping every channel of every pixel.
+ */
+static void
+decompressBlockRGB(uint block_part1, uint block_part2, GLubyte* img,
+				   int width, int startx, int starty, int channels)
+{
+	int baseColor[2][3];
+	int table[2];
+	int c;
+
+	if (block_part1 & 0x2) {
+		// Differential mode, unless the second color overflows, which
+		// selects one of the ETC2 modes.
+		for (c = 0; c < 3; c++) {
+			int color1 = (block_part1 >> (27 - 8*c)) & 0x1f;
+			int diff = (int)((block_part1 >> (24 - 8*c)) & 0x7);
+			int color2 = color1 + (diff ^ 4) - 4;
+			if (color2 < 0 || color2 > 31) {
+				decompressBlockETC2c(block_part1, block_part2, img,
+									 width, 0, startx, starty, channels);
+				return;
+			}
+			baseColor[0][c] = (color1 << 3) | (color1 >> 2);
+			baseColor[1][c] = (color2 << 3) | (color2 >> 2);
+		}
+	} else {
+		// Individual mode: two 4-bit colors.
+		for (c = 0; c < 3; c++) {
+			baseColor[0][c] = ((block_part1 >> (28 - 8*c)) & 0xf) * 17;
+			baseColor[1][c] = ((block_part1 >> (24 - 8*c)) & 0xf) * 17;
+		}
+	}
+	table[0] = (block_part1 >> 5) & 0x7;
+	table[1] = (block_part1 >> 2) & 0x7;
+
+	alignas(16) GLubyte palette[2][16];
+	buildPalettes(baseColor, table, palette);
+
+	// Pixel (x, y) uses bit x*4 + y of each index plane. The flip bit
+	// splits the block in top and bottom instead of left and right halves.
+	int flip = block_part1 & 0x1;
+	for (int y = 0; y < 4; y++) {
+		GLubyte* dst = img + channels * ((starty + y) * width + startx);
+		for (int x = 0; x < 4; x++) {
+			int bit = x*4 + y;
+			int index = ((block_part2 >> (bit + 15)) & 0x2) | ((block_part2 >> bit) & 0x1);
+			const GLubyte* color = &palette[flip ? y >> 1 : x >> 1][4*index];
+			dst[0] = color[0];
+			dst[1] = color[1];
+			dst[2] = color[2];
+			dst += channels;
+		}
+	}
+}
+
+/*
+ * Decode the rows of blocks [firstRow, endRow). Rows are independent: each
+ * writes only its own 4 rows of pixels.
+ */
+static void
+unpackBlockRows(const UnpackInfo& info, unsigned int firstRow, unsigned int endRow)
+{
+	unsigned int blocksPerRow = info.width / 4;
+	const GLubyte* src = info.src + (size_t)firstRow * blocksPerRow * info.blockBytes;
+	unsigned int block_part1, block_part2;
+	unsigned int x, y;
+	bool rg = info.srcFormat == GL_COMPRESSED_RG11_EAC
+			  || info.srcFormat == GL_COMPRESSED_SIGNED_RG11_EAC;
+
+	// NOTE: none of the decompress functions actually use the <height> parameter
+	for (y = firstRow; y < endRow; y++) {
+		for (x = 0; x < blocksPerRow; x++) {
+			if (info.alphaFormat == AF_11BIT) {
+				// One or two 11-bit alpha channels for R or RG.
+				decompressBlockAlpha16bitC((uint8*)src, info.dst, info.width, info.height, 4*x, 4*y, info.dstChannels);
+				src += 8;
+				if (rg) {
+					decompressBlockAlpha16bitC((uint8*)src, info.dst + info.dstChannelBytes, info.width, info.height, 4*x, 4*y, info.dstChannels);
+					src += 8;
+				}
+				continue;
+			}
+			// Decode alpha channel for RGBA
+			if (info.alphaFormat == AF_8BIT) {
+				decompressBlockAlphaC((uint8*)src, info.dst + 3, info.width, info.height, 4*x, 4*y, info.dstChannels);
+				src += 8;
+			}
+			// Decode color dstChannels
+			readBigEndian4byteWord(&block_part1, src);
+			src += 4;
+			readBigEndian4byteWord(&block_part2, src);
+			src += 4;
+			if (info.alphaFormat == AF_1BIT)
+				decompressBlockETC21BitAlphaC(block_part1, block_part2, info.dst, 0, info.width, info.height, 4*x, 4*y, info.dstChannels);
+			else
+				decompressBlockRGB(block_part1, block_part2, info.dst, info.width, 4*x, 4*y, info.dstChannels);
+		}
+	}
+}
 
 /* Unpack an ETC1_RGB8_OES format compressed texture */
 extern "C" KTX_error_code
@@ -71,11 +267,7 @@ _ktxUnpackETC(const GLubyte* srcETC, const GLenum srcFormat,
 			  GLint R16Formats, GLboolean supportsSRGB)
 {
 	unsigned int width, height;
-	unsigned int block_part1, block_part2;
-	unsigned int x, y;
-	/*const*/ GLubyte* src = (GLubyte*)srcETC;
-	// AF_11BIT is used to compress R11 & RG11 though its not alpha data.
-	enum {AF_NONE, AF_1BIT, AF_8BIT, AF_11BIT} alphaFormat = AF_NONE;
+	AlphaFormat alphaFormat = AF_NONE;
 	int dstChannels, dstChannelBytes;
 
 	switch (srcFormat) {
@@ -214,42 +406,44 @@ _ktxUnpackETC(const GLubyte* srcETC, const GLenum srcFormat,
 		return KTX_OUT_OF_MEMORY;
 	}
 	
+	// Set up the tables the decoders share before any thread starts.
 	if (alphaFormat != AF_NONE)
 		setupAlphaTable();
 
-	// NOTE: none of the decompress functions actually use the <height> parameter
-	if (alphaFormat == AF_11BIT) {
-		// One or two 11-bit alpha channels for R or RG.
-		for (y=0; y < height/4; y++) {
-			for (x=0; x < width/4; x++) {
-				decompressBlockAlpha16bitC(src, *dstImage, width, height, 4*x, 4*y, dstChannels);
-				src += 8;
-				if (srcFormat == GL_COMPRESSED_RG11_EAC || srcFormat == GL_COMPRESSED_SIGNED_RG11_EAC) {
-					decompressBlockAlpha16bitC(src, *dstImage + dstChannelBytes, width, height, 4*x, 4*y, dstChannels);
-					src += 8;
-				}
-			}
-		}
-	} else {
-		for (y=0; y < height/4; y++) {
-			for (x=0; x < width/4; x++) {
-				// Decode alpha channel for RGBA
-				if (alphaFormat == AF_8BIT) {
-					decompressBlockAlphaC(src, *dstImage + 3, width, height, 4*x, 4*y, dstChannels);
-					src += 8;
-				}
-				// Decode color dstChannels
-				readBigEndian4byteWord(&block_part1, src);
-				src += 4;
-				readBigEndian4byteWord(&block_part2, src);
-				src += 4;
-				if (alphaFormat == AF_1BIT)
-				    decompressBlockETC21BitAlphaC(block_part1, block_part2, *dstImage, 0, width, height, 4*x, 4*y, dstChannels);
-				else
-				    decompressBlockETC2c(block_part1, block_part2, *dstImage, width, height, 4*x, 4*y, dstChannels);
-			}
+	UnpackInfo info;
+	info.src = srcETC;
+	info.dst = *dstImage;
+	info.srcFormat = srcFormat;
+	info.alphaFormat = alphaFormat;
+	info.width = width;
+	info.height = height;
+	info.dstChannels = dstChannels;
+	info.dstChannelBytes = dstChannelBytes;
+	info.blockBytes = 8;
+	if (alphaFormat == AF_8BIT || srcFormat == GL_COMPRESSED_RG11_EAC
+		|| srcFormat == GL_COMPRESSED_SIGNED_RG11_EAC)
+		info.blockBytes = 16;
+
+	// Split the rows of blocks evenly between the hardware threads, the
+	// calling thread taking the last share. Should a thread fail to start,
+	// the calling thread decodes what is left.
+	unsigned int numBlockRows = height/4;
+	unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+	numThreads = std::min(numThreads, std::max(1u, numBlockRows / MIN_BLOCK_ROWS_PER_THREAD));
+	std::vector<std::thread> threads;
+	unsigned int firstRow = 0;
+	try {
+		threads.reserve(numThreads - 1);
+		for (unsigned int t = 1; t < numThreads; t++) {
+			unsigned int endRow = (unsigned int)((size_t)numBlockRows * t / numThreads);
+			threads.emplace_back(unpackBlockRows, std::cref(info), firstRow, endRow);
+			firstRow = endRow;
 		}
+	} catch (const std::exception&) {
 	}
+	unpackBlockRows(info, firstRow, numBlockRows);
+	for (std::thread& thread : threads)
+		thread.join();
 
 	/* Ok, now write out the active pixels to the destination image.
 	 * (But only if the active pixels differ from the total pixels)
@@ -260,8 +454,7 @@ _ktxUnpackETC(const GLubyte* srcETC, const GLenum srcFormat,
 		int dstRowBytes = dstPixelBytes * width;
 		int activeRowBytes = activeWidth * dstPixelBytes;
 		GLubyte *newimg = (GLubyte*)malloc(dstPixelBytes * activeWidth * activeHeight);
-		unsigned int xx, yy;
-		int zz;
+		unsigned int yy;
 
 		if (!newimg) {
 			free(*dstImage);
@@ -271,11 +464,7 @@ _ktxUnpackETC(const GLubyte* srcETC, const GLenum srcFormat,
 		/* Convert from total area to active area: */
 
 		for (yy = 0; yy < activeHeight; yy++) {
-			for (xx = 0; xx < activeWidth; xx++) {
-				for (zz = 0; zz < dstPixelBytes; zz++) {
-					newimg[ yy*activeRowBytes + xx*dstPixelBytes + zz ] = (*dstImage)[ yy*dstRowBytes + xx*dstPixelBytes + zz];
-				}
-			}
+			memcpy(newimg + yy*activeRowBytes, *dstImage + yy*dstRowBytes, activeRowBytes);
 		}
 
 		free(*dstImage);
@@ -32,6 +32,11 @@
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__ANDROID__)
+#include <android/asset_manager.h>
+#endif
 
 #include "ktx.h"
 #include "ktxint.h"
@@ -53,6 +58,13 @@ struct ktxMem
     ktx_size_t alloc_size;       /*!< allocated size of the memory block. */
     ktx_size_t used_size;        /*!< bytes used. Effectively the write position. */
     ktx_off_t pos;               /*!< read position. */
+    void* mapping;               /*!< mmap'ed region robytes points into, unmapped
+                                      on destruct, or NULL. */
+    ktx_size_t mapping_size;     /*!< length of the mmap'ed region. */
+#if defined(__ANDROID__)
+    AAsset* asset;               /*!< asset whose buffer robytes points into, closed
+                                      on destruct, or NULL. */
+#endif
 };
 
 static KTX_error_code ktxMem_expand(ktxMem* pMem, const ktx_size_t size);
@@ -72,11 +84,7 @@ static KTX_error_code ktxMem_expand(ktxMem* pMem, const ktx_size_t size);
 static KTX_error_code
 ktxMem_construct(ktxMem* pMem)
 {
-    pMem->pos = 0;
-    pMem->alloc_size = 0;
-    pMem->robytes = 0;
-    pMem->bytes = 0;
-    pMem->used_size = 0;
+    memset(pMem, 0, sizeof(ktxMem));
     return ktxMem_expand(pMem, KTX_MEM_DEFAULT_ALLOCATED_SIZE);
 }
 
@@ -119,9 +127,8 @@ ktxMem_create(ktxMem** ppMem)
 static void
 ktxMem_construct_ro(ktxMem* pMem, const void* bytes, ktx_size_t numBytes)
 {
-    pMem->pos = 0;
+    memset(pMem, 0, sizeof(ktxMem));
     pMem->robytes = bytes;
-    pMem->bytes = 0;
     pMem->used_size = numBytes;
     pMem->alloc_size = numBytes;
 }
@@ -173,6 +180,14 @@ ktxMem_destroy(ktxMem* pMem, ktx_bool_t freeData)
     if (freeData) {
         free(pMem->bytes);
     }
+    if (pMem->mapping) {
+        munmap(pMem->mapping, pMem->mapping_size);
+    }
+#if defined(__ANDROID__)
+    if (pMem->asset) {
+        AAsset_close(pMem->asset);
+    }
+#endif
     free(pMem);
 }
 
@@ -561,6 +576,149 @@ KTX_error_code ktxMemStream_construct_ro(ktxStream* str,
     return result;
 }
 
+/**
+ * @internal
+ * @~English
+ * @brief Initialize a read-only ktxMemStream reading from a memory mapped
+ *        file.
+ *
+ * The whole file is mapped read-only and the stream reads straight from the
+ * mapped pages, no copy of the file is made. The mapping is owned by the
+ * stream and unmapped when it is destructed. @p fd is not needed once this
+ * returns and may be closed by the caller.
+ *
+ * @param [in] str      pointer to a ktxStream struct to initialize.
+ * @param [in] fd       file descriptor of a file opened for reading.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p str is @c NULL or @p fd is negative.
+ * @exception KTX_FILE_READ_ERROR   the file could not be queried or mapped.
+ * @exception KTX_FILE_UNEXPECTED_EOF the file is empty.
+ * @exception KTX_OUT_OF_MEMORY     system failed to allocate sufficient memory.
+ */
+KTX_error_code ktxMemStream_construct_mmap(ktxStream* str, int fd)
+{
+    ktxMem* mem;
+    struct stat st;
+    void* mapping;
+    KTX_error_code result;
+
+    if (!str || fd < 0)
+        return KTX_INVALID_VALUE;
+
+    if (fstat(fd, &st) != 0)
+        return KTX_FILE_READ_ERROR;
+    if (st.st_size <= 0)
+        return KTX_FILE_UNEXPECTED_EOF;
+
+    mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+        return KTX_FILE_READ_ERROR;
+    /* Header, key/value data, then the levels in order: one front to back pass. */
+    madvise(mapping, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    result = ktxMem_create_ro(&mem, mapping, (ktx_size_t)st.st_size);
+    if (result != KTX_SUCCESS) {
+        munmap(mapping, (size_t)st.st_size);
+        return result;
+    }
+    mem->mapping = mapping;
+    mem->mapping_size = (ktx_size_t)st.st_size;
+    str->data.mem = mem;
+    ktxMemStream_setup(str);
+    str->closeOnDestruct = KTX_FALSE;
+    return KTX_SUCCESS;
+}
+
+#if defined(__ANDROID__)
+/**
+ * @internal
+ * @~English
+ * @brief Initialize a read-only ktxMemStream reading from the buffer of an
+ *        Android asset.
+ *
+ * The stream reads from AAsset_getBuffer(). For an asset stored uncompressed
+ * in the APK that buffer is a window into the mapped APK, so no copy of the
+ * asset is made; open the asset with @c AASSET_MODE_BUFFER. A compressed
+ * asset is inflated once by the asset manager.
+ *
+ * @param [in] str             pointer to a ktxStream struct to initialize.
+ * @param [in] asset           the asset to read.
+ * @param [in] closeOnDestruct If not KTX_FALSE the asset is closed when the
+ *                             stream is destructed, otherwise it must stay
+ *                             open for the lifetime of the stream.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p str or @p asset is @c NULL.
+ * @exception KTX_FILE_READ_ERROR   the asset has no buffer.
+ * @exception KTX_FILE_UNEXPECTED_EOF the asset is empty.
+ * @exception KTX_OUT_OF_MEMORY     system failed to allocate sufficient memory.
+ */
+KTX_error_code ktxMemStream_construct_asset(ktxStream* str, AAsset* asset,
+                                            ktx_bool_t closeOnDestruct)
+{
+    ktxMem* mem;
+    const void* bytes;
+    ktx_size_t size;
+    KTX_error_code result;
+
+    if (!str || !asset)
+        return KTX_INVALID_VALUE;
+
+    size = (ktx_size_t)AAsset_getLength64(asset);
+    if (size == 0)
+        return KTX_FILE_UNEXPECTED_EOF;
+    bytes = AAsset_getBuffer(asset);
+    if (!bytes)
+        return KTX_FILE_READ_ERROR;
+
+    result = ktxMem_create_ro(&mem, bytes, size);
+    if (result != KTX_SUCCESS)
+        return result;
+    if (closeOnDestruct)
+        mem->asset = asset;
+    str->data.mem = mem;
+    ktxMemStream_setup(str);
+    str->closeOnDestruct = KTX_FALSE;
+    return KTX_SUCCESS;
+}
+#endif
+
+/**
+ * @internal
+ * @~English
+ * @brief Get a pointer to the next bytes of a read-only ktxMemStream.
+ *
+ * Lets a reader use data in place, e.g. straight from mapped pages, instead
+ * of copying it out with read(). The read position is not moved; skip the
+ * bytes once done with them.
+ *
+ * @param [in] str    pointer to the ktxStream to peek into.
+ * @param [in] count  number of bytes the caller is going to use.
+ *
+ * @return      pointer to @p count bytes at the read position, or @c NULL if
+ *              @p str is not a read-only ktxMemStream or has less than
+ *              @p count bytes left.
+ */
+const ktx_uint8_t* ktxMemStream_peek(ktxStream* str, const ktx_size_t count)
+{
+    ktxMem* mem;
+    ktx_off_t newpos;
+
+    if (!str || str->type != eStreamTypeMemory || !(mem = str->data.mem)
+        || !mem->robytes)
+        return NULL;
+
+    newpos = mem->pos + count;
+    /* The first clause checks for overflow. */
+    if (newpos < mem->pos || newpos > mem->used_size)
+        return NULL;
+
+    return mem->robytes + mem->pos;
+}
+
 /**
  * @internal
  * @~English
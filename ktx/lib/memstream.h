@@ -48,8 +48,28 @@ KTX_error_code ktxMemStream_construct(ktxStream* str,
 KTX_error_code ktxMemStream_construct_ro(ktxStream* str,
                                          const ktx_uint8_t* pBytes,
                                          const ktx_size_t size);
+/*
+ * Initialize a ktxStream to a read-only ktxMemStream reading from
+ * a read-only mapping of the file open on fd. Unmaps on destruct.
+ */
+KTX_error_code ktxMemStream_construct_mmap(ktxStream* str, int fd);
+#if defined(__ANDROID__)
+typedef struct AAsset AAsset;
+/*
+ * Initialize a ktxStream to a read-only ktxMemStream reading from
+ * the AAsset_getBuffer() of an asset.
+ */
+KTX_error_code ktxMemStream_construct_asset(ktxStream* str, AAsset* asset,
+                                            ktx_bool_t closeOnDestruct);
+#endif
 void ktxMemStream_destruct(ktxStream* str);
 
+/*
+ * Pointer to the next count bytes of a read-only ktxMemStream, NULL
+ * for any other stream.
+ */
+const ktx_uint8_t* ktxMemStream_peek(ktxStream* str, const ktx_size_t count);
+
 KTX_error_code ktxMemStream_getdata(ktxStream* str, ktx_uint8_t** ppBytes);
 
 #endif /* MEMSTREAM_H */
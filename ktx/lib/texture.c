@@ -32,6 +32,11 @@
 #endif
 
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__ANDROID__)
+#include <android/asset_manager.h>
+#endif
 
 #include "ktx.h"
 #include "ktxint.h"
@@ -63,6 +68,7 @@ ktx_size_t ktxTexture_GetSize(ktxTexture* This);
 KTX_error_code ktxTexture_LoadImageData(ktxTexture* This,
                                         ktx_uint8_t* pBuffer,
                                         ktx_size_t bufSize);
+void ktxTextureInt_destruct(ktxTextureInt* This);
 
 static ktx_size_t ktxTexture_calcDataSize(ktxTexture* This);
 static ktx_uint32_t padRow(ktx_uint32_t* rowBytes);
@@ -527,6 +533,97 @@ ktxTextureInt_constructFromMemory(ktxTextureInt* This,
     return result;
 }
 
+/**
+ * @memberof ktxTexture @private
+ * @brief Construct a ktxTexture from a memory mapped KTX file.
+ *
+ * See ktxTextureInt_constructFromStream for details.
+ *
+ * @param[in] This pointer to a ktxTextureInt-sized block of memory to
+ *                 initialize.
+ * @param[in] filename    pointer to a char array containing the file name.
+ * @param[in] createFlags bitmask requesting specific actions during creation.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_FILE_OPEN_FAILED The file could not be opened.
+ * @exception KTX_FILE_READ_ERROR  The file could not be mapped.
+ * @exception KTX_INVALID_VALUE @p filename is @c NULL.
+ *
+ * For other exceptions, see ktxTexture_constructFromStream().
+ */
+static KTX_error_code
+ktxTextureInt_constructFromMappedFile(ktxTextureInt* This,
+                                      const char* const filename,
+                                      ktxTextureCreateFlags createFlags)
+{
+    KTX_error_code result;
+    int fd;
+
+    if (This == NULL || filename == NULL)
+        return KTX_INVALID_VALUE;
+
+    memset(This, 0, sizeof(*This));
+
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return KTX_FILE_OPEN_FAILED;
+
+    /* The mapping outlives the descriptor. */
+    result = ktxMemStream_construct_mmap(&This->stream, fd);
+    close(fd);
+    if (result == KTX_SUCCESS) {
+        result = ktxTextureInt_constructFromStream(This, createFlags);
+        if (result != KTX_SUCCESS)
+            ktxTextureInt_destruct(This);
+    }
+
+    return result;
+}
+
+#if defined(__ANDROID__)
+/**
+ * @memberof ktxTexture @private
+ * @brief Construct a ktxTexture from the buffer of an Android asset.
+ *
+ * See ktxTextureInt_constructFromStream for details.
+ *
+ * @param[in] This pointer to a ktxTextureInt-sized block of memory to
+ *                 initialize.
+ * @param[in] asset       the asset, closed with the texture's stream.
+ * @param[in] createFlags bitmask requesting specific actions during creation.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_FILE_READ_ERROR  The asset has no buffer.
+ * @exception KTX_INVALID_VALUE @p asset is @c NULL.
+ *
+ * For other exceptions, see ktxTexture_constructFromStream().
+ */
+static KTX_error_code
+ktxTextureInt_constructFromAsset(ktxTextureInt* This, AAsset* asset,
+                                 ktxTextureCreateFlags createFlags)
+{
+    KTX_error_code result;
+
+    if (This == NULL || asset == NULL)
+        return KTX_INVALID_VALUE;
+
+    memset(This, 0, sizeof(*This));
+
+    result = ktxMemStream_construct_asset(&This->stream, asset, KTX_TRUE);
+    if (result == KTX_SUCCESS) {
+        result = ktxTextureInt_constructFromStream(This, createFlags);
+        if (result != KTX_SUCCESS)
+            ktxTextureInt_destruct(This);
+    } else {
+        AAsset_close(asset);
+    }
+
+    return result;
+}
+#endif
+
 /**
  * @memberof ktxTexture @private
  * @~English
@@ -791,6 +888,122 @@ ktxTexture_CreateFromMemory(const ktx_uint8_t* bytes, ktx_size_t size,
     return result;
 }
 
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Create a ktxTexture from a memory mapped KTX file.
+ *
+ * The address of a newly created ktxTexture reflecting the contents of the
+ * file is written to the location pointed at by @p newTex.
+ *
+ * The file is mapped read-only instead of being read through stdio: the
+ * header is parsed and the images are read straight from the mapped pages,
+ * there is no intermediate copy of the file. Without
+ * KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, ktxTexture_IterateLoadLevelFaces()
+ * hands the images to its callback in place. The mapping is released once
+ * the images are loaded or the texture is destroyed.
+ *
+ * The create flag KTX_TEXTURE_CREATE_RAW_KVDATA_BIT should not be used. It is
+ * provided solely to enable implementation of the @e libktx v1 API on top of
+ * ktxTexture.
+ *
+ * @param[in] filename    pointer to a char array containing the file name.
+ * @param[in] createFlags bitmask requesting specific actions during creation.
+ * @param[in,out] newTex  pointer to a location in which store the address of
+ *                        the newly created texture.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+
+ * @exception KTX_FILE_OPEN_FAILED The file could not be opened.
+ * @exception KTX_FILE_READ_ERROR  The file could not be mapped.
+ * @exception KTX_INVALID_VALUE @p filename is @c NULL.
+ *
+ * For other exceptions, see ktxTexture_CreateFromStdioStream().
+ */
+KTX_error_code
+ktxTexture_CreateFromMappedFile(const char* const filename,
+                                ktxTextureCreateFlags createFlags,
+                                ktxTexture** newTex)
+{
+    KTX_error_code result;
+
+    if (newTex == NULL)
+        return KTX_INVALID_VALUE;
+
+    ktxTextureInt* tex = (ktxTextureInt*)malloc(sizeof(ktxTextureInt));
+    if (tex == NULL)
+        return KTX_OUT_OF_MEMORY;
+
+    result = ktxTextureInt_constructFromMappedFile(tex, filename, createFlags);
+    if (result == KTX_SUCCESS)
+        *newTex = (ktxTexture*)tex;
+    else {
+        free(tex);
+        *newTex = NULL;
+    }
+    return result;
+}
+
+#if defined(__ANDROID__)
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Create a ktxTexture from an Android asset containing KTX data.
+ *
+ * The address of a newly created ktxTexture reflecting the contents of the
+ * asset is written to the location pointed at by @p newTex.
+ *
+ * The texture reads from AAsset_getBuffer(). Open the asset with
+ * @c AASSET_MODE_BUFFER: for an asset stored uncompressed in the APK the
+ * buffer is a window into the mapped APK and, as with
+ * ktxTexture_CreateFromMappedFile(), nothing is copied before the images are
+ * loaded.
+ *
+ * The texture takes ownership of @p asset, also when creation fails. The
+ * asset is closed once the images are loaded or the texture is destroyed.
+ *
+ * @param[in] asset       the asset to read.
+ * @param[in] createFlags bitmask requesting specific actions during creation.
+ * @param[in,out] newTex  pointer to a location in which store the address of
+ *                        the newly created texture.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_FILE_READ_ERROR  The asset has no buffer.
+ * @exception KTX_INVALID_VALUE @p asset or @p newTex is @c NULL.
+ *
+ * For other exceptions, see ktxTexture_CreateFromStdioStream().
+ */
+KTX_error_code
+ktxTexture_CreateFromAsset(AAsset* asset, ktxTextureCreateFlags createFlags,
+                           ktxTexture** newTex)
+{
+    KTX_error_code result;
+
+    if (newTex == NULL) {
+        if (asset != NULL)
+            AAsset_close(asset);
+        return KTX_INVALID_VALUE;
+    }
+
+    ktxTextureInt* tex = (ktxTextureInt*)malloc(sizeof(ktxTextureInt));
+    if (tex == NULL) {
+        if (asset != NULL)
+            AAsset_close(asset);
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    result = ktxTextureInt_constructFromAsset(tex, asset, createFlags);
+    if (result == KTX_SUCCESS)
+        *newTex = (ktxTexture*)tex;
+    else {
+        free(tex);
+        *newTex = NULL;
+    }
+    return result;
+}
+#endif
+
 /**
  * @memberof ktxTexture
  * @~English
@@ -1105,6 +1318,12 @@ ktxTexture_IterateLevelFaces(ktxTexture* This, PFNKTXITERCB iterCb,
  * This function is helpful for reducing memory usage when uploading the data
  * to a graphics API.
  *
+ * When the source is read-only memory, i.e. the texture was created with
+ * ktxTexture_CreateFromMemory(), ktxTexture_CreateFromMappedFile() or
+ * ktxTexture_CreateFromAsset(), and no endianness conversion is needed, the
+ * callback is passed a pointer into the source instead and no temporary
+ * buffer is used at all. The callback must not modify the image data.
+ *
  * @param[in]     This     pointer to the ktxTexture object of interest.
  * @param[in,out] iterCb   the address of a callback function which is called
  *                         with the data for each image.
@@ -1171,13 +1390,7 @@ ktxTexture_IterateLoadLevelFaces(ktxTexture* This, PFNKTXITERCB iterCb,
 #else
         faceLodSizePadded = faceLodSize;
 #endif
-        if (!data) {
-            /* allocate memory sufficient for the base miplevel */
-            data = malloc(faceLodSizePadded);
-            if (!data) {
-                result = KTX_OUT_OF_MEMORY;
-                goto cleanup;
-            }
+        if (miplevel == 0) {
             dataSize = faceLodSizePadded;
         }
         else if (dataSize < faceLodSizePadded) {
@@ -1199,23 +1412,44 @@ ktxTexture_IterateLoadLevelFaces(ktxTexture* This, PFNKTXITERCB iterCb,
             /* And all z_slices are also passed as a group hence no
              *    for (z_slice = 0; z_slice < This->depth)
              */
-            result = subthis->stream.read(&subthis->stream, data,
-                                          faceLodSizePadded);
-            if (result != KTX_SUCCESS) {
-                goto cleanup;
-            }
-            
-            /* Perform endianness conversion on texture data */
-            if (subthis->needSwap) {
-                if (subthis->glTypeSize == 2)
-                    _ktxSwapEndian16((ktx_uint16_t*)data, faceLodSize / 2);
-                else if (subthis->glTypeSize == 4)
-                    _ktxSwapEndian32((ktx_uint32_t*)data, faceLodSize / 4);
+            const ktx_uint8_t* pImage = NULL;
+            if (!subthis->needSwap)
+                pImage = ktxMemStream_peek(&subthis->stream, faceLodSizePadded);
+            if (pImage) {
+                /* Read-only memory or mapped pages: pass the image in place. */
+                result = subthis->stream.skip(&subthis->stream,
+                                              faceLodSizePadded);
+                if (result != KTX_SUCCESS) {
+                    goto cleanup;
+                }
+            } else {
+                if (!data) {
+                    /* allocate memory sufficient for the base miplevel */
+                    data = malloc(dataSize);
+                    if (!data) {
+                        result = KTX_OUT_OF_MEMORY;
+                        goto cleanup;
+                    }
+                }
+                result = subthis->stream.read(&subthis->stream, data,
+                                              faceLodSizePadded);
+                if (result != KTX_SUCCESS) {
+                    goto cleanup;
+                }
+
+                /* Perform endianness conversion on texture data */
+                if (subthis->needSwap) {
+                    if (subthis->glTypeSize == 2)
+                        _ktxSwapEndian16((ktx_uint16_t*)data, faceLodSize / 2);
+                    else if (subthis->glTypeSize == 4)
+                        _ktxSwapEndian32((ktx_uint32_t*)data, faceLodSize / 4);
+                }
+                pImage = data;
             }
-            
+
             result = iterCb(miplevel, face,
                              width, height, depth,
-                             faceLodSize, data, userdata);
+                             faceLodSize, (void*)pImage, userdata);
             
             if (result != KTX_SUCCESS)
                 goto cleanup;
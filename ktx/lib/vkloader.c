@@ -76,7 +76,7 @@ setImageLayout(
     VkImageSubresourceRange subresourceRange);
 
 static void
-generateMipmaps(ktxVulkanTexture* vkTexture, ktxVulkanDeviceInfo* vdi,
+generateMipmaps(ktxVulkanTexture* vkTexture, VkCommandBuffer cmdBuffer,
                 VkFilter filter, VkImageLayout initialLayout);
 
 /**
@@ -264,9 +264,7 @@ typedef struct user_cbdata_optimal {
     ktx_uint8_t* dest;         // Pointer to mapped staging buffer.
     ktx_uint32_t elementSize;
     ktx_uint32_t numDimensions;
-#if defined(_DEBUG)
-    VkBufferImageCopy* regionsArrayEnd;
-#endif
+    VkBufferImageCopy* regionsArrayEnd; // For the asserts.
 } user_cbdata_optimal;
 
 /**
@@ -545,138 +543,92 @@ linearTilingPadCallback(int miplevel, int face,
     return KTX_SUCCESS;
 }
 
+//======================================================================
+//  Upload helpers
+//======================================================================
+
 /**
- * @memberof ktxTexture
+ * @internal
  * @~English
- * @brief Create a Vulkan image object from a ktxTexture object.
- *
- * Creates a VkImage with @c VkFormat etc. matching the KTX data and uploads
- * the images. Also creates a VkImageView object for accessing the image.
- * Mipmaps will be generated if the @c ktxTexture's @c generateMipmaps
- * flag is set. Returns the handles of the created objects and information
- * about the texture in the @c ktxVulkanTexture pointed at by @p vkTexture.
- *
- * @p usageFlags and thus acceptable usage of the created image may be
- * augmented as follows:
- * - with @c VK_IMAGE_USAGE_TRANSFER_DST_BIT if @p tiling is
- *   @c VK_IMAGE_TILING_OPTIMAL
- * - with <code>VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT</code>
- *   if @c generateMipmaps is set in the @c ktxTexture.
- *
- * Most Vulkan implementations support VK_IMAGE_TILING_LINEAR only for a very
- * limited number of formats and features. Generally VK_IMAGE_TILING_OPTIMAL is
- * preferred. The latter requires a staging buffer so will use more memory
- * during loading.
- *
- * @param[in] This          pointer to the ktxTexture from which to upload.
- * @param [in] vdi          pointer to a ktxVulkanDeviceInfo structure providing
- *                          information about the Vulkan device onto which to
- *                          load the texture.
- * @param [in,out] vkTexture pointer to a ktxVulkanTexture structure into which
- *                           the function writes information about the created
- *                           VkImage.
- * @param [in] tiling       type of tiling to use in the destination image
- *                          on the Vulkan device.
- * @param [in] usageFlags   a set of VkImageUsageFlags bits indicating the
- *                          intended usage of the destination image.
- * @param [in] finalLayout  a VkImageLayout value indicating the desired
- *                          final layout of the created image.
- *
- * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ * @brief Parameters of the Vulkan image for a ktxTexture, shared by the
+ *        upload functions.
+ */
+typedef struct ktxVulkanImageInfo {
+    VkFormat           format;
+    VkImageType        imageType;
+    VkImageViewType    viewType;
+    VkImageCreateFlags createFlags;
+    /** The requested usage augmented with what the upload needs. */
+    VkImageUsageFlags  usageFlags;
+    /** Set only when the ktxTexture's @c generateMipmaps is set. */
+    VkFilter           blitFilter;
+    ktx_uint32_t       numImageLayers;
+    ktx_uint32_t       numImageLevels;
+    ktx_bool_t         canUseFasterPath;
+    /** Number of buffer to image copies for @c VK_IMAGE_TILING_OPTIMAL. */
+    ktx_uint32_t       numCopyRegions;
+    /** Staging buffer size for @c VK_IMAGE_TILING_OPTIMAL. */
+    VkDeviceSize       stagingSize;
+} ktxVulkanImageInfo;
+
+/**
+ * @internal
+ * @~English
+ * @brief Work out the parameters of the Vulkan image for a ktxTexture and
+ *        check the physical device supports them.
  *
- * @exception KTX_INVALID_VALUE @p This, @p vdi or @p vkTexture is @c NULL.
- * @exception KTX_INVALID_OPERATION The ktxTexture contains neither images nor
- *                                  an active stream from which to read them.
- * @exception KTX_INVALID_OPERATION The combination of the ktxTexture's format,
- *                                  @p tiling and @p usageFlags is not supported
- *                                  by the physical device.
- * @exception KTX_INVALID_OPERATION Requested mipmap generation is not supported
- *                                  by the physical device for the combination
- *                                  of the ktxTexture's format and @p tiling.
- * @exception KTX_OUT_OF_MEMORY Sufficient memory could not be allocated
- *                              on either the CPU or the Vulkan device.
+ * @return  KTX_SUCCESS on success, KTX_INVALID_OPERATION if the image cannot
+ *          be created on @p physicalDevice with @p tiling and @p usageFlags.
  */
-KTX_error_code
-ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
-                      ktxVulkanTexture* vkTexture,
-                      VkImageTiling tiling,
-                      VkImageUsageFlags usageFlags,
-                      VkImageLayout finalLayout)
+static KTX_error_code
+ktxTexture_getVkImageInfo(ktxTexture* This, VkPhysicalDevice physicalDevice,
+                          VkImageTiling tiling, VkImageUsageFlags usageFlags,
+                          ktxVulkanImageInfo* info)
 {
-    KTX_error_code           kResult;
-    VkFilter                 blitFilter;
-    VkFormat                 vkFormat;
-    VkImageType              imageType;
-    VkImageViewType          viewType;
-    VkImageCreateFlags       createFlags = 0;
     VkImageFormatProperties  imageFormatProperties;
     VkResult                 vResult;
-    VkCommandBufferBeginInfo cmdBufBeginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .pNext = NULL
-    };
-    VkImageCreateInfo        imageCreateInfo = {
-         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-         .pNext = NULL
-    };
-    VkMemoryAllocateInfo     memAllocInfo = {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext = NULL,
-        .allocationSize = 0,
-        .memoryTypeIndex = 0
-    };
-    VkMemoryRequirements     memReqs;
-    ktx_uint32_t             numImageLayers, numImageLevels;
     ktx_uint32_t elementSize = ktxTexture_GetElementSize(This);
-    ktx_bool_t               canUseFasterPath;
 
-    if (!vdi || !This || !vkTexture) {
-        return KTX_INVALID_VALUE;
-    }
-
-    if (!This->pData && !ktxTexture_isActiveStream(This)) {
-        /* Nothing to upload. */
-        return KTX_INVALID_OPERATION;
-    }
+    info->createFlags = 0;
 
     /* _ktxCheckHeader should have caught this. */
     assert(This->numFaces == 6 ? This->numDimensions == 2 : VK_TRUE);
 
-    numImageLayers = This->numLayers;
+    info->numImageLayers = This->numLayers;
     if (This->isCubemap) {
-        numImageLayers *= 6;
-        createFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+        info->numImageLayers *= 6;
+        info->createFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
     }
 
     switch (This->numDimensions) {
       case 1:
-        imageType = VK_IMAGE_TYPE_1D;
-        viewType = This->isArray ?
+        info->imageType = VK_IMAGE_TYPE_1D;
+        info->viewType = This->isArray ?
                         VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
         break;
       case 2:
-        imageType = VK_IMAGE_TYPE_2D;
+        info->imageType = VK_IMAGE_TYPE_2D;
         if (This->isCubemap)
-            viewType = This->isArray ?
+            info->viewType = This->isArray ?
                         VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
         else
-            viewType = This->isArray ?
+            info->viewType = This->isArray ?
                         VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
         break;
       case 3:
-        imageType = VK_IMAGE_TYPE_3D;
+        info->imageType = VK_IMAGE_TYPE_3D;
         /* 3D array textures not supported in Vulkan. Attempts to create or
          * load them should have been trapped long before this.
          */
         assert(!This->isArray);
-        viewType = VK_IMAGE_VIEW_TYPE_3D;
+        info->viewType = VK_IMAGE_VIEW_TYPE_3D;
         break;
     }
 
-    vkFormat = vkGetFormatFromOpenGLInternalFormat(This->glInternalformat);
-    if (vkFormat == VK_FORMAT_UNDEFINED)
-        vkFormat = vkGetFormatFromOpenGLFormat(This->glFormat, This->glType);
-    if (vkFormat == VK_FORMAT_UNDEFINED) {
+    info->format = vkGetFormatFromOpenGLInternalFormat(This->glInternalformat);
+    if (info->format == VK_FORMAT_UNDEFINED)
+        info->format = vkGetFormatFromOpenGLFormat(This->glFormat, This->glType);
+    if (info->format == VK_FORMAT_UNDEFINED) {
         return KTX_INVALID_OPERATION;
     }
 
@@ -689,12 +641,12 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         // Ensure we can blit between levels.
         usageFlags |= (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
     }
-    vResult = vkGetPhysicalDeviceImageFormatProperties(vdi->physicalDevice,
-                                                      vkFormat,
-                                                      imageType,
+    vResult = vkGetPhysicalDeviceImageFormatProperties(physicalDevice,
+                                                      info->format,
+                                                      info->imageType,
                                                       tiling,
                                                       usageFlags,
-                                                      createFlags,
+                                                      info->createFlags,
                                                       &imageFormatProperties);
     if (vResult == VK_ERROR_FORMAT_NOT_SUPPORTED) {
         return KTX_INVALID_OPERATION;
@@ -706,8 +658,8 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         VkFormatFeatureFlags  formatFeatureFlags;
         VkFormatFeatureFlags  neededFeatures
             = VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT;
-        vkGetPhysicalDeviceFormatProperties(vdi->physicalDevice,
-                                            vkFormat,
+        vkGetPhysicalDeviceFormatProperties(physicalDevice,
+                                            info->format,
                                             &formatProperties);
         assert(vResult == VK_SUCCESS);
         if (tiling == VK_IMAGE_TILING_OPTIMAL)
@@ -719,14 +671,14 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
             return KTX_INVALID_OPERATION;
 
         if (formatFeatureFlags & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
-            blitFilter = VK_FILTER_LINEAR;
+            info->blitFilter = VK_FILTER_LINEAR;
         else
-            blitFilter = VK_FILTER_NEAREST; // XXX INVALID_OP?
+            info->blitFilter = VK_FILTER_NEAREST; // XXX INVALID_OP?
 
         max_dim = MAX(MAX(This->baseWidth, This->baseHeight), This->baseDepth);
-        numImageLevels = (uint32_t)floor(log2(max_dim)) + 1;
+        info->numImageLevels = (uint32_t)floor(log2(max_dim)) + 1;
     } else {
-        numImageLevels = This->numLevels;
+        info->numImageLevels = This->numLevels;
     }
 
     {
@@ -749,19 +701,219 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         if (elementSize % 4 == 0  /* There'll be no padding at any level. */
                /* There is no padding at level 0 and no other levels. */
             || (This->numLevels == 1 && actualRowPitch == tightRowPitch))
-            canUseFasterPath = KTX_TRUE;
+            info->canUseFasterPath = KTX_TRUE;
         else
-            canUseFasterPath = KTX_FALSE;
+            info->canUseFasterPath = KTX_FALSE;
+    }
+
+    info->usageFlags = usageFlags;
+
+    info->stagingSize = ktxTexture_GetSize(This);
+    if (info->canUseFasterPath) {
+        /*
+         * Because all array layers and faces are the same size they can
+         * be copied in a single operation so there'll be 1 copy per mip
+         * level.
+         */
+        info->numCopyRegions = This->numLevels;
+    } else {
+        /*
+         * Have to copy all images individually into the staging
+         * buffer so we can place them at correct multiples of
+         * elementSize and 4 and also need a copy region per image
+         * in case they end up with padding between them.
+         */
+        info->numCopyRegions = This->isArray ? This->numLevels
+                              : This->numLevels * This->numFaces;
+        /* 
+         * Add extra space to allow for possible padding described
+         * above. A bit ad-hoc but it's only a small amount of
+         * memory.
+         */
+        info->stagingSize += info->numCopyRegions * elementSize * 4;
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Copy the images of a ktxTexture into a mapped staging buffer and set
+ *        up the regions copying them to an optimally tiled image.
+ *
+ * The @c bufferOffset of the regions are relative to @p pMappedStagingBuffer.
+ *
+ * @param[in] This          pointer to the ktxTexture from which to upload.
+ * @param[in] info          the image parameters from
+ *                          ktxTexture_getVkImageInfo().
+ * @param[in] pMappedStagingBuffer pointer to at least @c info->stagingSize
+ *                          bytes of mapped staging memory.
+ * @param[in] stagingSize   size of the memory at @p pMappedStagingBuffer.
+ * @param[out] copyRegions  array of @c info->numCopyRegions regions.
+ */
+static KTX_error_code
+ktxTexture_fillStagingBuffer(ktxTexture* This, const ktxVulkanImageInfo* info,
+                             ktx_uint8_t* pMappedStagingBuffer,
+                             VkDeviceSize stagingSize,
+                             VkBufferImageCopy* copyRegions)
+{
+    KTX_error_code      kResult;
+    user_cbdata_optimal cbData;
+
+    cbData.offset = 0;
+    cbData.region = copyRegions;
+    cbData.numFaces = This->numFaces;
+    cbData.numLayers = This->numLayers;
+    cbData.dest = pMappedStagingBuffer;
+    cbData.elementSize = ktxTexture_GetElementSize(This);
+    cbData.numDimensions = This->numDimensions;
+    cbData.regionsArrayEnd = copyRegions + info->numCopyRegions;
+    if (info->canUseFasterPath) {
+        // Bulk load the data to the staging buffer and iterate
+        // over levels.
+
+        if (This->pData) {
+            // Image data has already been loaded. Copy to staging
+            // buffer.
+            assert(This->dataSize <= stagingSize);
+            memcpy(pMappedStagingBuffer, This->pData, This->dataSize);
+        } else {
+            /* Load the image data directly into the staging buffer. */
+            /* The strange cast quiets an Xcode warning when building
+             * for the Generic iOS Device where size_t is 32-bit even
+             * when building for arm64. */
+            kResult = ktxTexture_LoadImageData(This,
+                                  pMappedStagingBuffer,
+                                  (ktx_size_t)stagingSize);
+            if (kResult != KTX_SUCCESS)
+                return kResult;
+        }
+
+        // Iterate over mip levels to set up the copy regions.
+        kResult = ktxTexture_IterateLevels(This,
+                                           optimalTilingCallback,
+                                           &cbData);
+    } else {
+        // Iterate over face-levels with callback that copies the
+        // face-levels to Vulkan-valid offsets in the staging buffer while
+        // removing padding. Using face-levels minimizes pre-staging-buffer
+        // buffering, in the event the data is not already loaded.
+        if (This->pData) {
+            kResult = ktxTexture_IterateLevelFaces(
+                                        This,
+                                        optimalTilingPadCallback,
+                                        &cbData);
+        } else {
+            kResult = ktxTexture_IterateLoadLevelFaces(
+                                        This,
+                                        optimalTilingPadCallback,
+                                        &cbData);
+        }
+    }
+
+    return kResult;
+}
+
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture object.
+ *
+ * Creates a VkImage with @c VkFormat etc. matching the KTX data and uploads
+ * the images. Also creates a VkImageView object for accessing the image.
+ * Mipmaps will be generated if the @c ktxTexture's @c generateMipmaps
+ * flag is set. Returns the handles of the created objects and information
+ * about the texture in the @c ktxVulkanTexture pointed at by @p vkTexture.
+ *
+ * @p usageFlags and thus acceptable usage of the created image may be
+ * augmented as follows:
+ * - with @c VK_IMAGE_USAGE_TRANSFER_DST_BIT if @p tiling is
+ *   @c VK_IMAGE_TILING_OPTIMAL
+ * - with <code>VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT</code>
+ *   if @c generateMipmaps is set in the @c ktxTexture.
+ *
+ * Most Vulkan implementations support VK_IMAGE_TILING_LINEAR only for a very
+ * limited number of formats and features. Generally VK_IMAGE_TILING_OPTIMAL is
+ * preferred. The latter requires a staging buffer so will use more memory
+ * during loading.
+ *
+ * @param[in] This          pointer to the ktxTexture from which to upload.
+ * @param [in] vdi          pointer to a ktxVulkanDeviceInfo structure providing
+ *                          information about the Vulkan device onto which to
+ *                          load the texture.
+ * @param [in,out] vkTexture pointer to a ktxVulkanTexture structure into which
+ *                           the function writes information about the created
+ *                           VkImage.
+ * @param [in] tiling       type of tiling to use in the destination image
+ *                          on the Vulkan device.
+ * @param [in] usageFlags   a set of VkImageUsageFlags bits indicating the
+ *                          intended usage of the destination image.
+ * @param [in] finalLayout  a VkImageLayout value indicating the desired
+ *                          final layout of the created image.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This, @p vdi or @p vkTexture is @c NULL.
+ * @exception KTX_INVALID_OPERATION The ktxTexture contains neither images nor
+ *                                  an active stream from which to read them.
+ * @exception KTX_INVALID_OPERATION The combination of the ktxTexture's format,
+ *                                  @p tiling and @p usageFlags is not supported
+ *                                  by the physical device.
+ * @exception KTX_INVALID_OPERATION Requested mipmap generation is not supported
+ *                                  by the physical device for the combination
+ *                                  of the ktxTexture's format and @p tiling.
+ * @exception KTX_OUT_OF_MEMORY Sufficient memory could not be allocated
+ *                              on either the CPU or the Vulkan device.
+ */
+KTX_error_code
+ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
+                      ktxVulkanTexture* vkTexture,
+                      VkImageTiling tiling,
+                      VkImageUsageFlags usageFlags,
+                      VkImageLayout finalLayout)
+{
+    KTX_error_code           kResult;
+    ktxVulkanImageInfo       info;
+    VkResult                 vResult;
+    VkCommandBufferBeginInfo cmdBufBeginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = NULL
+    };
+    VkImageCreateInfo        imageCreateInfo = {
+         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+         .pNext = NULL
+    };
+    VkMemoryAllocateInfo     memAllocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = NULL,
+        .allocationSize = 0,
+        .memoryTypeIndex = 0
+    };
+    VkMemoryRequirements     memReqs;
+
+    if (!vdi || !This || !vkTexture) {
+        return KTX_INVALID_VALUE;
     }
 
+    if (!This->pData && !ktxTexture_isActiveStream(This)) {
+        /* Nothing to upload. */
+        return KTX_INVALID_OPERATION;
+    }
+
+    kResult = ktxTexture_getVkImageInfo(This, vdi->physicalDevice, tiling,
+                                        usageFlags, &info);
+    if (kResult != KTX_SUCCESS)
+        return kResult;
+
     vkTexture->width = This->baseWidth;
     vkTexture->height = This->baseHeight;
     vkTexture->depth = This->baseDepth;
     vkTexture->imageLayout = finalLayout;
-    vkTexture->imageFormat = vkFormat;
-    vkTexture->levelCount = numImageLevels;
-    vkTexture->layerCount = numImageLayers;
-    vkTexture->viewType = viewType;
+    vkTexture->imageFormat = info.format;
+    vkTexture->levelCount = info.numImageLevels;
+    vkTexture->layerCount = info.numImageLayers;
+    vkTexture->viewType = info.viewType;
+    vkTexture->allocation = NULL;
 
     VK_CHECK_RESULT(vkBeginCommandBuffer(vdi->cmdBuffer, &cmdBufBeginInfo));
 
@@ -771,7 +923,6 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         VkBuffer stagingBuffer;
         VkDeviceMemory stagingMemory;
         VkBufferImageCopy* copyRegions;
-        VkDeviceSize textureSize;
         VkBufferCreateInfo bufferCreateInfo = {
           .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
           .pNext = NULL
@@ -788,37 +939,10 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
             .pNext = NULL
         };
         ktx_uint8_t* pMappedStagingBuffer;
-        ktx_uint32_t numCopyRegions;
-        user_cbdata_optimal cbData;
-
-
-        textureSize = ktxTexture_GetSize(This);
-        bufferCreateInfo.size = textureSize;
-        if (canUseFasterPath) {
-            /*
-             * Because all array layers and faces are the same size they can
-             * be copied in a single operation so there'll be 1 copy per mip
-             * level.
-             */
-            numCopyRegions = This->numLevels;
-        } else {
-            /*
-             * Have to copy all images individually into the staging
-             * buffer so we can place them at correct multiples of
-             * elementSize and 4 and also need a copy region per image
-             * in case they end up with padding between them.
-             */
-            numCopyRegions = This->isArray ? This->numLevels
-                                  : This->numLevels * This->numFaces;
-            /* 
-             * Add extra space to allow for possible padding described
-             * above. A bit ad-hoc but it's only a small amount of
-             * memory.
-             */
-            bufferCreateInfo.size += numCopyRegions * elementSize * 4;
-        }
+
+        bufferCreateInfo.size = info.stagingSize;
         copyRegions = (VkBufferImageCopy*)malloc(sizeof(VkBufferImageCopy)
-                                                   * numCopyRegions);
+                                                   * info.numCopyRegions);
         if (copyRegions == NULL) {
             return KTX_OUT_OF_MEMORY;
         }
@@ -855,73 +979,32 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
                                     memReqs.size, 0,
                                     (void **)&pMappedStagingBuffer));
 
-        cbData.offset = 0;
-        cbData.region = copyRegions;
-        cbData.numFaces = This->numFaces;
-        cbData.numLayers = This->numLayers;
-        cbData.dest = pMappedStagingBuffer;
-        cbData.elementSize = elementSize;
-        cbData.numDimensions = This->numDimensions;
-#if defined(_DEBUG)
-        cbData.regionsArrayEnd = copyRegions + numCopyRegions;
-#endif
-        if (canUseFasterPath) {
-            // Bulk load the data to the staging buffer and iterate
-            // over levels.
-
-            if (This->pData) {
-                // Image data has already been loaded. Copy to staging
-                // buffer.
-                assert(This->dataSize <= memAllocInfo.allocationSize);
-                memcpy(pMappedStagingBuffer, This->pData, This->dataSize);
-            } else {
-                /* Load the image data directly into the staging buffer. */
-                /* The strange cast quiets an Xcode warning when building
-                 * for the Generic iOS Device where size_t is 32-bit even
-                 * when building for arm64. */
-                kResult = ktxTexture_LoadImageData(This,
-                                      pMappedStagingBuffer,
-                                      (ktx_size_t)memAllocInfo.allocationSize);
-                if (kResult != KTX_SUCCESS)
-                    return kResult;
-            }
-
-            // Iterate over mip levels to set up the copy regions.
-            kResult = ktxTexture_IterateLevels(This,
-                                               optimalTilingCallback,
-                                               &cbData);
-            // XXX Check for possible errors.
-        } else {
-            // Iterate over face-levels with callback that copies the
-            // face-levels to Vulkan-valid offsets in the staging buffer while
-            // removing padding. Using face-levels minimizes pre-staging-buffer
-            // buffering, in the event the data is not already loaded.
-            if (This->pData) {
-                kResult = ktxTexture_IterateLevelFaces(
-                                            This,
-                                            optimalTilingPadCallback,
-                                            &cbData);
-            } else {
-                kResult = ktxTexture_IterateLoadLevelFaces(
-                                            This,
-                                            optimalTilingPadCallback,
-                                            &cbData);
-                // XXX Check for possible errors.
-            }
-        }
-
+        kResult = ktxTexture_fillStagingBuffer(This, &info,
+                                               pMappedStagingBuffer,
+                                               memAllocInfo.allocationSize,
+                                               copyRegions);
         vkUnmapMemory(vdi->device, stagingMemory);
+        if (kResult != KTX_SUCCESS) {
+            // Nothing has been recorded yet. End the command buffer, as the
+            // success path does, so the caller gets it back out of the
+            // recording state.
+            free(copyRegions);
+            vkFreeMemory(vdi->device, stagingMemory, vdi->pAllocator);
+            vkDestroyBuffer(vdi->device, stagingBuffer, vdi->pAllocator);
+            vkEndCommandBuffer(vdi->cmdBuffer);
+            return kResult;
+        }
 
         // Create optimal tiled target image
-        imageCreateInfo.imageType = imageType;
-        imageCreateInfo.flags = createFlags;
-        imageCreateInfo.format = vkFormat;
+        imageCreateInfo.imageType = info.imageType;
+        imageCreateInfo.flags = info.createFlags;
+        imageCreateInfo.format = info.format;
         // numImageLevels ensures enough levels for generateMipmaps.
-        imageCreateInfo.mipLevels = numImageLevels;
-        imageCreateInfo.arrayLayers = numImageLayers;
+        imageCreateInfo.mipLevels = info.numImageLevels;
+        imageCreateInfo.arrayLayers = info.numImageLayers;
         imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-        imageCreateInfo.usage = usageFlags;
+        imageCreateInfo.usage = info.usageFlags;
         imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
         imageCreateInfo.extent.width = vkTexture->width;
@@ -948,7 +1031,7 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         subresourceRange.baseMipLevel = 0;
         subresourceRange.levelCount = This->numLevels;
         subresourceRange.baseArrayLayer = 0;
-        subresourceRange.layerCount = numImageLayers;
+        subresourceRange.layerCount = info.numImageLayers;
 
         // Image barrier to transition, possibly only the base level, image
         // layout to TRANSFER_DST_OPTIMAL so it can be used as the copy
@@ -964,12 +1047,13 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         vkCmdCopyBufferToImage(
             vdi->cmdBuffer, stagingBuffer,
             vkTexture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            numCopyRegions, copyRegions
+            info.numCopyRegions, copyRegions
             );
+        free(copyRegions);
 
         if (This->generateMipmaps) {
-            generateMipmaps(vkTexture, vdi,
-                            blitFilter, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            generateMipmaps(vkTexture, vdi->cmdBuffer,
+                            info.blitFilter, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
         } else {
             // Transition image layout to finalLayout after all mip levels
             // have been copied.
@@ -1017,18 +1101,18 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         user_cbdata_linear cbData;
         PFNKTXITERCB callback;
 
-        imageCreateInfo.imageType = imageType;
-        imageCreateInfo.flags = createFlags;
-        imageCreateInfo.format = vkFormat;
+        imageCreateInfo.imageType = info.imageType;
+        imageCreateInfo.flags = info.createFlags;
+        imageCreateInfo.format = info.format;
         imageCreateInfo.extent.width = vkTexture->width;
         imageCreateInfo.extent.height = vkTexture->height;
         imageCreateInfo.extent.depth = vkTexture->depth;
         // numImageLevels ensures enough levels for generateMipmaps.
-        imageCreateInfo.mipLevels = numImageLevels;
-        imageCreateInfo.arrayLayers = numImageLayers;
+        imageCreateInfo.mipLevels = info.numImageLevels;
+        imageCreateInfo.arrayLayers = info.numImageLayers;
         imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
-        imageCreateInfo.usage = usageFlags;
+        imageCreateInfo.usage = info.usageFlags;
         imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
 
@@ -1060,7 +1144,7 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         cbData.destImage = mappableImage;
         cbData.device = vdi->device;
         cbData.texture = This;
-        callback = canUseFasterPath ?
+        callback = info.canUseFasterPath ?
                          linearTilingCallback : linearTilingPadCallback;
 
         // Map image memory
@@ -1086,16 +1170,16 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         vkTexture->deviceMemory = mappableMemory;
 
         if (This->generateMipmaps) {
-            generateMipmaps(vkTexture, vdi,
-                            blitFilter,
+            generateMipmaps(vkTexture, vdi->cmdBuffer,
+                            info.blitFilter,
                             VK_IMAGE_LAYOUT_PREINITIALIZED);
         } else {
             VkImageSubresourceRange subresourceRange;
             subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             subresourceRange.baseMipLevel = 0;
-            subresourceRange.levelCount = numImageLevels;
+            subresourceRange.levelCount = info.numImageLevels;
             subresourceRange.baseArrayLayer = 0;
-            subresourceRange.layerCount = numImageLayers;
+            subresourceRange.layerCount = info.numImageLayers;
 
            // Transition image layout to finalLayout.
             setImageLayout(
@@ -1140,6 +1224,206 @@ ktxTexture_VkUpload(ktxTexture* texture, ktxVulkanDeviceInfo* vdi,
                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 }
 
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Record the upload of a ktxTexture into a caller-supplied command
+ *        buffer, taking staging and image memory from the caller.
+ *
+ * Creates an optimally tiled VkImage through @c callbacks->createImage, puts
+ * the images into staging memory obtained from @c callbacks->allocateStaging
+ * and records the layout transitions, the buffer to image copies and, if the
+ * @c ktxTexture's @c generateMipmaps flag is set, the mipmap blits into
+ * @p cmdBuffer. Nothing is submitted and nothing is waited on. The caller
+ * begins @p cmdBuffer beforehand, submits it when it sees fit and keeps the
+ * staging memory alive until that submission completes.
+ *
+ * Any number of textures can be recorded into the same command buffer and
+ * uploaded with a single submission. Their memory comes from the caller's
+ * allocator, e.g. sub-allocated from a few large blocks, instead of two
+ * @c vkAllocateMemory per texture as with ktxTexture_VkUploadEx().
+ *
+ * @p usageFlags is augmented as for ktxTexture_VkUploadEx(). A
+ * @p finalLayout of @c VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL leaves the image
+ * as the copies left it so the caller can record its own barrier, e.g. a
+ * queue family ownership transfer.
+ *
+ * @param[in] This          pointer to the ktxTexture from which to upload.
+ * @param[in] physicalDevice handle of the Vulkan physical device, used to
+ *                          check the image can be created.
+ * @param[in] cmdBuffer     the command buffer, in the recording state, into
+ *                          which to record the upload. Its queue must support
+ *                          graphics if mipmaps are generated.
+ * @param[in] callbacks     pointer to the callbacks providing the staging and
+ *                          image memory.
+ * @param [in,out] vkTexture pointer to a ktxVulkanTexture structure into which
+ *                           the function writes information about the created
+ *                           VkImage. @c deviceMemory is @c VK_NULL_HANDLE,
+ *                           @c allocation is what @c createImage returned.
+ * @param [in] usageFlags   a set of VkImageUsageFlags bits indicating the
+ *                          intended usage of the destination image.
+ * @param [in] finalLayout  a VkImageLayout value indicating the desired
+ *                          final layout of the created image.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This, @p callbacks or @p vkTexture is
+ *                              @c NULL.
+ * @exception KTX_INVALID_OPERATION The ktxTexture contains neither images nor
+ *                                  an active stream from which to read them.
+ * @exception KTX_INVALID_OPERATION The combination of the ktxTexture's format
+ *                                  and @p usageFlags is not supported by the
+ *                                  physical device, or mipmap generation is
+ *                                  requested and not supported.
+ * @exception KTX_OUT_OF_MEMORY A callback failed or the copy regions could not
+ *                              be allocated.
+ *
+ * @sa ktxVulkanTexture_DestructWithCallbacks()
+ */
+KTX_error_code
+ktxTexture_VkUploadToCommandBuffer(ktxTexture* This,
+                                   VkPhysicalDevice physicalDevice,
+                                   VkCommandBuffer cmdBuffer,
+                                   const ktxVulkanUploadCallbacks* callbacks,
+                                   ktxVulkanTexture* vkTexture,
+                                   VkImageUsageFlags usageFlags,
+                                   VkImageLayout finalLayout)
+{
+    KTX_error_code           kResult;
+    ktxVulkanImageInfo       info;
+    VkImageCreateInfo        imageCreateInfo = {
+         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+         .pNext = NULL
+    };
+    VkImageSubresourceRange  subresourceRange;
+    VkBufferImageCopy*       copyRegions;
+    VkBuffer                 stagingBuffer;
+    VkDeviceSize             stagingOffset, baseOffset;
+    ktx_uint8_t*             pMappedStagingBuffer;
+    ktx_uint32_t             elementSize, offsetAlignment, i;
+
+    if (!This || !callbacks || !vkTexture) {
+        return KTX_INVALID_VALUE;
+    }
+
+    if (!This->pData && !ktxTexture_isActiveStream(This)) {
+        /* Nothing to upload. */
+        return KTX_INVALID_OPERATION;
+    }
+
+    kResult = ktxTexture_getVkImageInfo(This, physicalDevice,
+                                        VK_IMAGE_TILING_OPTIMAL,
+                                        usageFlags, &info);
+    if (kResult != KTX_SUCCESS)
+        return kResult;
+
+    vkTexture->width = This->baseWidth;
+    vkTexture->height = This->baseHeight;
+    vkTexture->depth = This->baseDepth;
+    vkTexture->imageLayout = finalLayout;
+    vkTexture->imageFormat = info.format;
+    vkTexture->levelCount = info.numImageLevels;
+    vkTexture->layerCount = info.numImageLayers;
+    vkTexture->viewType = info.viewType;
+    vkTexture->deviceMemory = VK_NULL_HANDLE;
+
+    copyRegions = (VkBufferImageCopy*)malloc(sizeof(VkBufferImageCopy)
+                                               * info.numCopyRegions);
+    if (copyRegions == NULL) {
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    // Each region's bufferOffset must be a multiple of 4 and of the element
+    // size. The staging memory comes at whatever offset the caller's
+    // allocator picked so ask for enough extra to start at a multiple of
+    // their least common multiple.
+    elementSize = ktxTexture_GetElementSize(This);
+    if (elementSize % 4 == 0)
+        offsetAlignment = elementSize;
+    else if (elementSize % 2 == 0)
+        offsetAlignment = elementSize * 2;
+    else
+        offsetAlignment = elementSize * 4;
+    if (callbacks->allocateStaging(callbacks->pUserData,
+                                   info.stagingSize + offsetAlignment - 1,
+                                   &stagingBuffer, &stagingOffset,
+                                   (void**)&pMappedStagingBuffer)
+        != VK_SUCCESS) {
+        free(copyRegions);
+        return KTX_OUT_OF_MEMORY;
+    }
+    baseOffset = (stagingOffset + offsetAlignment - 1)
+                 / offsetAlignment * offsetAlignment;
+    pMappedStagingBuffer += baseOffset - stagingOffset;
+
+    // The staging memory is the caller's, it goes away with its submission
+    // even if this fails.
+    kResult = ktxTexture_fillStagingBuffer(This, &info, pMappedStagingBuffer,
+                                           info.stagingSize, copyRegions);
+    if (kResult != KTX_SUCCESS) {
+        free(copyRegions);
+        return kResult;
+    }
+    for (i = 0; i < info.numCopyRegions; i++)
+        copyRegions[i].bufferOffset += baseOffset;
+
+    imageCreateInfo.imageType = info.imageType;
+    imageCreateInfo.flags = info.createFlags;
+    imageCreateInfo.format = info.format;
+    // numImageLevels ensures enough levels for generateMipmaps.
+    imageCreateInfo.mipLevels = info.numImageLevels;
+    imageCreateInfo.arrayLayers = info.numImageLayers;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = info.usageFlags;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageCreateInfo.extent.width = vkTexture->width;
+    imageCreateInfo.extent.height = vkTexture->height;
+    imageCreateInfo.extent.depth = vkTexture->depth;
+
+    if (callbacks->createImage(callbacks->pUserData, &imageCreateInfo,
+                               &vkTexture->image, &vkTexture->allocation)
+        != VK_SUCCESS) {
+        free(copyRegions);
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    subresourceRange.baseMipLevel = 0;
+    subresourceRange.levelCount = This->numLevels;
+    subresourceRange.baseArrayLayer = 0;
+    subresourceRange.layerCount = info.numImageLayers;
+
+    setImageLayout(
+        cmdBuffer,
+        vkTexture->image,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        subresourceRange);
+
+    // The regions are consumed at record time.
+    vkCmdCopyBufferToImage(
+        cmdBuffer, stagingBuffer,
+        vkTexture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        info.numCopyRegions, copyRegions
+        );
+    free(copyRegions);
+
+    if (This->generateMipmaps) {
+        generateMipmaps(vkTexture, cmdBuffer,
+                        info.blitFilter, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    } else if (finalLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        setImageLayout(
+            cmdBuffer,
+            vkTexture->image,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            finalLayout,
+            subresourceRange);
+    }
+    return KTX_SUCCESS;
+}
+
 /** @memberof ktxTexture
  * @~English
  * @brief Return the VkFormat enum of a ktxTexture object.
@@ -1320,13 +1604,12 @@ setImageLayout(
  *
  * @param[in] vkTexture     pointer to an object with information about the
  *                          image for which to generate mipmaps.
- * @param[in] vdi           pointer to an object with information about the
- *                          Vulkan device and command buffer to use.
+ * @param[in] cmdBuffer     the command buffer in which to record the blits.
  * @param[in] blitFilter    the type of filter to use in the @c VkCmdBlitImage.
  * @param[in] initialLayout the layout of the image on entry to the function.
  */
 static void
-generateMipmaps(ktxVulkanTexture* vkTexture, ktxVulkanDeviceInfo* vdi,
+generateMipmaps(ktxVulkanTexture* vkTexture, VkCommandBuffer cmdBuffer,
                 VkFilter blitFilter, VkImageLayout initialLayout)
 {
     VkImageSubresourceRange subresourceRange;
@@ -1339,7 +1622,7 @@ generateMipmaps(ktxVulkanTexture* vkTexture, ktxVulkanDeviceInfo* vdi,
 
     // Transition base level to SRC_OPTIMAL for blitting.
     setImageLayout(
-        vdi->cmdBuffer,
+        cmdBuffer,
         vkTexture->image,
         initialLayout,
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -1379,7 +1662,7 @@ generateMipmaps(ktxVulkanTexture* vkTexture, ktxVulkanDeviceInfo* vdi,
 
         // Transiton current mip level to transfer dest
         setImageLayout(
-            vdi->cmdBuffer,
+            cmdBuffer,
             vkTexture->image,
             VK_IMAGE_LAYOUT_UNDEFINED,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -1387,7 +1670,7 @@ generateMipmaps(ktxVulkanTexture* vkTexture, ktxVulkanDeviceInfo* vdi,
 
         // Blit from previous level
         vkCmdBlitImage(
-            vdi->cmdBuffer,
+            cmdBuffer,
             vkTexture->image,
             VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
             vkTexture->image,
@@ -1399,7 +1682,7 @@ generateMipmaps(ktxVulkanTexture* vkTexture, ktxVulkanDeviceInfo* vdi,
         // Transiton current mip level to transfer source for read in
         // next iteration.
         setImageLayout(
-            vdi->cmdBuffer,
+            cmdBuffer,
             vkTexture->image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -1410,7 +1693,7 @@ generateMipmaps(ktxVulkanTexture* vkTexture, ktxVulkanDeviceInfo* vdi,
     // Transition all to final layout.
     subresourceRange.levelCount = vkTexture->levelCount;
     setImageLayout(
-        vdi->cmdBuffer,
+        cmdBuffer,
         vkTexture->image,
         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
         vkTexture->imageLayout,
@@ -1441,4 +1724,23 @@ ktxVulkanTexture_Destruct(ktxVulkanTexture* vkTexture, VkDevice device,
     vkFreeMemory(device, vkTexture->deviceMemory, pAllocator);
 }
 
+/**
+ * @memberof ktxVulkanTexture
+ * @~English
+ * @brief Destructor for the object returned by
+ *        ktxTexture_VkUploadToCommandBuffer().
+ *
+ * Hands the image and its allocation back to @c callbacks->destroyImage.
+ *
+ * @param vkTexture  pointer to the ktxVulkanTexture to be destructed.
+ * @param callbacks  pointer to the callbacks used during loading.
+ */
+void
+ktxVulkanTexture_DestructWithCallbacks(ktxVulkanTexture* vkTexture,
+                                      const ktxVulkanUploadCallbacks* callbacks)
+{
+    callbacks->destroyImage(callbacks->pUserData, vkTexture->image,
+                            vkTexture->allocation);
+}
+
 /** @} */